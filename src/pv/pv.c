@@ -1,145 +1,189 @@
 #include <assert.h>
 #include <limits.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "errlog.h"
-#include "cadef.h"
+#include "epicsTime.h"
 
 #define epicsExportSharedSymbols
 #include "pv.h"
 
-#define INVOKE(x, expr) \
-    {\
-        int _status = expr;\
-        if (!(_status & CA_M_SUCCESS)) {\
-            (x)->msg = ca_message(_status);\
-            errlogSevPrintf(sevrFromCA(_status), "%s: %s", #expr, ca_message(_status));\
-            return statFromCA(_status);\
-        }\
-    }
+epicsShareDef const struct pvSystem nullPvSys = {NULL,NULL,NULL,NULL};
+epicsShareDef const struct pvVar nullPvVar = {NULL,NULL,NULL,NULL,NULL,NULL,NULL,0};
 
-epicsShareDef const struct pvSystem nullPvSys = {NULL};
-epicsShareDef const struct pvVar nullPvVar = {NULL,NULL,NULL,NULL,NULL,NULL};
+static const pvBackend *const backends[] = {
+    &pvCaBackend,
+    &pvLoopbackBackend,
+};
 
-/* utilities */
-static pvSevr sevrFromCA(long status);  /* CA severity as pvSevr */
-static pvStat statFromCA(long status);  /* CA status as pvStat */
-static pvType typeFromCA(long type);    /* DBR type as pvType */
-static chtype typeToCA(pvType type);    /* pvType as DBR type */
+#define NUM_BACKENDS (sizeof(backends)/sizeof(backends[0]))
 
-epicsShareFunc pvStat pvSysCreate(pvSystem *pSys)
-{
-    assert(pSys);
-    assert(!ca_current_context());
-    INVOKE(pSys, ca_context_create(ca_enable_preemptive_callback));
-    pSys->id = ca_current_context();
-    return pvStatOK;
-}
+/* variables of pv systems with sharing turned on (pvShare.c) */
+extern const pvBackend pvShareBackend;
 
-epicsShareFunc pvStat pvSysFlush(pvSystem sys)
+epicsShareFunc const pvBackend *pvBackendFind(const char *name)
 {
-    INVOKE(&sys, ca_flush_io());
-    return pvStatOK;
+    unsigned i;
+
+    for (i = 0; i < NUM_BACKENDS; i++) {
+        if (strcmp(backends[i]->name, name) == 0)
+            return backends[i];
+    }
+    return NULL;
 }
 
-epicsShareFunc pvStat pvSysAttach(pvSystem sys)
+epicsShareFunc pvStat pvSysCreate(pvSystem *pSys)
 {
-    if (!ca_current_context())
-        INVOKE(&sys, ca_attach_context(sys.id));
-    return pvStatOK;
+    return pvSysCreateBackend(pSys, "ca");
 }
 
-static void pvCaConnectionHandler(struct connection_handler_args args)
+/* Copy options to buf without the option "share"; return whether it was there */
+static int takeShareOption(char *buf, const char *options)
 {
-    pvVar *var = (pvVar *)ca_puser(args.chid);
-    var->conn_handler(args.op == CA_OP_CONN_UP, var->arg);
+    int share = FALSE;
+
+    *buf = 0;
+    while (*options) {
+        size_t len = strcspn(options, ":");
+
+        if (len == 5 && strncmp(options, "share", 5) == 0) {
+            share = TRUE;
+        } else {
+            if (*buf)
+                strcat(buf, ":");
+            strncat(buf, options, len);
+        }
+        options += len;
+        if (*options == ':')
+            options++;
+    }
+    return share;
 }
 
-epicsShareFunc pvStat pvVarCreate(pvSystem sys, const char *name,
-    pvConnFunc *conn_func, pvEventFunc *event_func, void *arg, pvVar *var)
+epicsShareFunc pvStat pvSysCreateBackend(pvSystem *pSys, const char *spec)
 {
-    assert(var);
-    var->conn_handler = conn_func;
-    var->event_handler = event_func;
-    var->arg = arg;
-    INVOKE(var, ca_create_channel(name, pvCaConnectionHandler, var, CA_PRIORITY_DEFAULT, &var->chid));
-    return pvStatOK;
+    const char *options = strchr(spec, ':');
+    size_t len = options ? (size_t)(options - spec) : strlen(spec);
+    char name[32];
+    char *backendOptions;
+    int share;
+    pvStat status;
+
+    assert(pSys);
+    *pSys = nullPvSys;
+    if (len >= sizeof(name)) {
+        len = sizeof(name) - 1;
+    }
+    memcpy(name, spec, len);
+    name[len] = 0;
+    pSys->backend = pvBackendFind(name);
+    if (!pSys->backend) {
+        pSys->msg = "unknown pv backend";
+        errlogSevPrintf(errlogMajor, "pvSysCreateBackend: unknown pv backend '%s'\n", name);
+        return pvStatERROR;
+    }
+    backendOptions = (char *)malloc(options ? strlen(options) : 1);
+    if (!backendOptions) {
+        pSys->msg = "out of memory";
+        return pvStatERROR;
+    }
+    share = takeShareOption(backendOptions, options ? options + 1 : "");
+    status = pSys->backend->sysCreate(pSys, backendOptions);
+    free(backendOptions);
+    if (status == pvStatOK && share)
+        status = pvSysShare(pSys);
+    return status;
 }
 
-epicsShareFunc pvStat pvVarDestroy(pvVar *var)
+epicsShareFunc pvStat pvSysFlush(pvSystem sys)
 {
-    assert(var);
-    INVOKE(var, ca_clear_channel(var->chid));
-    *var = nullPvVar;
-    return pvStatOK;
+    return sys.backend->sysFlush(&sys);
 }
 
-static void pvCaEventHandler(struct event_handler_args args, pvEventType evt)
+epicsShareFunc pvStat pvSysAttach(pvSystem sys)
 {
-    pvVar *var = (pvVar *)ca_puser(args.chid);
-    unsigned count = (unsigned)args.count;
-    assert(args.count >= 0);
-    assert((long)count == args.count);
-    var->msg = ca_message(args.status);
-    var->event_handler(evt, args.usr, typeFromCA(args.type), count, (pvValue*)args.dbr, statFromCA(args.status));
+    return sys.backend->sysAttach(&sys);
 }
 
-static void pvCaGetHandler(struct event_handler_args args)
+epicsShareFunc pvStat pvVarCreate(pvSystem sys, const char *name,
+    pvConnFunc *conn_func, pvEventFunc *event_func, void *arg, pvVar *var)
 {
-    pvCaEventHandler(args, pvEventGet);
+    return pvVarCreatePriority(sys, name, pvPriorityMin, conn_func,
+        event_func, arg, var);
 }
 
-static void pvCaPutHandler(struct event_handler_args args)
+epicsShareFunc pvStat pvVarCreatePriority(pvSystem sys, const char *name,
+    unsigned priority, pvConnFunc *conn_func, pvEventFunc *event_func,
+    void *arg, pvVar *var)
 {
-    pvCaEventHandler(args, pvEventPut);
+    assert(var);
+    var->priority = priority > pvPriorityMax ? pvPriorityMax : priority;
+    var->conn_handler = conn_func;
+    var->event_handler = event_func;
+    var->arg = arg;
+    var->backend = sys.share ? &pvShareBackend : sys.backend;
+    return var->backend->varCreate(&sys, name, var);
 }
 
-static void pvCaMonitorHandler(struct event_handler_args args)
+epicsShareFunc pvStat pvVarDestroy(pvVar *var)
 {
-    pvCaEventHandler(args, pvEventMonitor);
+    pvStat status;
+
+    assert(var);
+    status = var->backend->varDestroy(var);
+    if (status == pvStatOK)
+        *var = nullPvVar;
+    return status;
 }
 
 epicsShareFunc pvStat pvVarGetCallback(pvVar *var, pvType type, unsigned count, void *arg)
 {
     assert(var);
     assert(pv_is_valid_type(type));
-    INVOKE(var, ca_array_get_callback(
-        typeToCA(type), count, var->chid, pvCaGetHandler, arg));
-    return pvStatOK;
+    return var->backend->varGetCallback(var, type, count, arg);
 }
 
 epicsShareFunc pvStat pvVarPutNoBlock(pvVar *var, pvType type, unsigned count, pvValue *value)
 {
     assert(var);
     assert(pv_is_simple_type(type));
-    INVOKE(var, ca_array_put(typeToCA(type), count, var->chid, value));
-    return pvStatOK;
+    return var->backend->varPutNoBlock(var, type, count, value);
 }
 
 epicsShareFunc pvStat pvVarPutCallback(pvVar *var, pvType type, unsigned count, pvValue *value, void *arg)
 {
     assert(var);
     assert(pv_is_simple_type(type));
-    INVOKE(var, ca_array_put_callback(
-        typeToCA(type), count, var->chid, value, pvCaPutHandler, arg));
-    return pvStatOK;
+    return var->backend->varPutCallback(var, type, count, value, arg);
 }
 
 epicsShareFunc pvStat pvVarMonitorOn(pvVar *var, pvType type, unsigned count, void *arg)
+{
+    return pvVarMonitorOnMask(var, type, count, pvMonitorDefault, arg);
+}
+
+epicsShareFunc pvStat pvVarMonitorOnMask(pvVar *var, pvType type, unsigned count,
+    unsigned mask, void *arg)
 {
     assert(var);
     assert(pv_is_valid_type(type));
-    if (var->monid == NULL) {
-        INVOKE(var, ca_create_subscription(typeToCA(type), count, var->chid,
-            DBE_VALUE | DBE_ALARM, pvCaMonitorHandler, arg, &var->monid));
-    }
-    return pvStatOK;
+    if (var->monid != NULL)
+        return pvStatOK;
+    if (mask == 0)
+        mask = pvMonitorDefault;
+    if (var->backend->varMonitorOnMask)
+        return var->backend->varMonitorOnMask(var, type, count, mask, arg);
+    return var->backend->varMonitorOn(var, type, count, arg);
 }
 
 epicsShareFunc pvStat pvVarMonitorOff(pvVar *var)
 {
     assert(var);
     if (var->monid != NULL) {
-        INVOKE(var, ca_clear_event(var->monid));
+        pvStat status = var->backend->varMonitorOff(var);
+        if (status != pvStatOK)
+            return status;
         var->monid = NULL;
     }
     return pvStatOK;
@@ -147,9 +191,15 @@ epicsShareFunc pvStat pvVarMonitorOff(pvVar *var)
 
 epicsShareFunc unsigned pvVarGetCount(pvVar *var)
 {
-    unsigned long c = ca_element_count(var->chid);
-    assert(c <= UINT_MAX);
-    return (unsigned)c;
+    return var->backend->varGetCount(var);
+}
+
+epicsShareFunc pvType pvVarGetType(pvVar *var)
+{
+    assert(var);
+    if (!var->backend->varGetType)
+        return pvTypeERROR;
+    return var->backend->varGetType(var);
 }
 
 epicsShareFunc int pvTimeGetCurrentDouble(double *pTime)
@@ -165,67 +215,6 @@ epicsShareFunc int pvTimeGetCurrentDouble(double *pTime)
     return pvStatOK;
 }
 
-#include "alarm.h"
-
-static pvSevr sevrFromCA(long status)
-{
-    switch (CA_EXTRACT_SEVERITY(status)) {
-        case CA_K_INFO:    return pvSevrNONE;
-        case CA_K_SUCCESS: return pvSevrNONE;
-        case CA_K_WARNING: return pvSevrMINOR;
-        case CA_K_ERROR:   return pvSevrMAJOR;
-        case CA_K_SEVERE:  return pvSevrINVALID;
-        default:           return pvSevrERROR;
-    }
-}
-
-static pvStat statFromCA(long status)
-{
-    pvSevr sevr = sevrFromCA(status);
-    return (sevr == pvSevrNONE || sevr == pvSevrMINOR) ?
-                pvStatOK : pvStatERROR;
-}
-
-static pvType typeFromCA(long type)
-{
-    switch (type) {
-        case DBR_CHAR:          return pvTypeCHAR;
-        case DBR_SHORT:         return pvTypeSHORT;
-        case DBR_ENUM:          return pvTypeSHORT;
-        case DBR_LONG:          return pvTypeLONG;
-        case DBR_FLOAT:         return pvTypeFLOAT;
-        case DBR_DOUBLE:        return pvTypeDOUBLE;
-        case DBR_STRING:        return pvTypeSTRING;
-        case DBR_TIME_CHAR:     return pvTypeTIME_CHAR;
-        case DBR_TIME_SHORT:    return pvTypeTIME_SHORT;
-        case DBR_TIME_ENUM:     return pvTypeTIME_SHORT;
-        case DBR_TIME_LONG:     return pvTypeTIME_LONG;
-        case DBR_TIME_FLOAT:    return pvTypeTIME_FLOAT;
-        case DBR_TIME_DOUBLE:   return pvTypeTIME_DOUBLE;
-        case DBR_TIME_STRING:   return pvTypeTIME_STRING;
-        default:                return pvTypeERROR;
-    }
-}
-
-static chtype typeToCA(pvType type)
-{
-    switch (type) {
-        case pvTypeCHAR:        return DBR_CHAR;
-        case pvTypeSHORT:       return DBR_SHORT;
-        case pvTypeLONG:        return DBR_LONG;
-        case pvTypeFLOAT:       return DBR_FLOAT;
-        case pvTypeDOUBLE:      return DBR_DOUBLE;
-        case pvTypeSTRING:      return DBR_STRING;
-        case pvTypeTIME_CHAR:   return DBR_TIME_CHAR;
-        case pvTypeTIME_SHORT:  return DBR_TIME_SHORT;
-        case pvTypeTIME_LONG:   return DBR_TIME_LONG;
-        case pvTypeTIME_FLOAT:  return DBR_TIME_FLOAT;
-        case pvTypeTIME_DOUBLE: return DBR_TIME_DOUBLE;
-        case pvTypeTIME_STRING: return DBR_TIME_STRING;
-        default:                return -1;
-    }
-}
-
 #include "db_access.h"
 
 typedef struct dbr_time_char    pvTimeChar;
@@ -248,6 +237,7 @@ epicsShareDef const size_t pv_sizes[] = {
     sizeof(pvTimeFloat ),
     sizeof(pvTimeDouble),
     sizeof(pvTimeString),
+    sizeof(pvCtrl      ),
 };
 
 epicsShareDef const size_t pv_value_sizes[] = {
@@ -263,6 +253,7 @@ epicsShareDef const size_t pv_value_sizes[] = {
     sizeof(pvFloat ),
     sizeof(pvDouble),
     sizeof(pvString),
+    sizeof(pvCtrl  ),
 };
 
 epicsShareDef const size_t pv_value_offsets[] = {
@@ -278,6 +269,7 @@ epicsShareDef const size_t pv_value_offsets[] = {
     offsetof(pvTimeFloat , value),
     offsetof(pvTimeDouble, value),
     offsetof(pvTimeString, value),
+    0,
 };
 
 epicsShareDef const size_t pv_status_offsets[] = {
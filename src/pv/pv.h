@@ -35,23 +35,52 @@ typedef enum {
 
 typedef struct pvSystem pvSystem;
 typedef struct pvVar pvVar;
+typedef struct pvBackend pvBackend;
 typedef void pvConnFunc(int connected, void *arg);
 typedef void pvEventFunc(pvEventType evt, void *arg, pvType type, unsigned count, pvValue *value, pvStat status);
 
 /* structures must be allocated by client code */
 
 struct pvSystem {
-    struct ca_client_context *id;
+    void *id;                   /* backend specific context */
     const char *msg;
+    const pvBackend *backend;
+    void *share;                /* shared channels, see pvSysShare */
 };
 
 struct pvVar {
-    struct oldChannelNotify *chid;
-    struct oldSubscription *monid;
+    void *chid;                 /* backend specific channel */
+    void *monid;                /* backend specific subscription */
     pvConnFunc *conn_handler;
     pvEventFunc *event_handler;
     void *arg;
     const char *msg;
+    const pvBackend *backend;
+    unsigned priority;          /* see pvVarCreatePriority */
+};
+
+/* A backend implements the pv functions for one message system. The
+ * generic functions below check their arguments, fill in the common
+ * parts of pvSystem and pvVar, and then call the backend's function
+ * of the same name; backends report connection changes and events
+ * via the pvVar's conn_handler and event_handler. */
+struct pvBackend {
+    const char *name;
+    pvStat (*sysCreate)(pvSystem *sys, const char *options);
+    pvStat (*sysFlush)(pvSystem *sys);
+    pvStat (*sysAttach)(pvSystem *sys);
+    pvStat (*varCreate)(pvSystem *sys, const char *name, pvVar *var);
+    pvStat (*varDestroy)(pvVar *var);
+    pvStat (*varGetCallback)(pvVar *var, pvType type, unsigned count, void *arg);
+    pvStat (*varPutNoBlock)(pvVar *var, pvType type, unsigned count, pvValue *value);
+    pvStat (*varPutCallback)(pvVar *var, pvType type, unsigned count, pvValue *value, void *arg);
+    pvStat (*varMonitorOn)(pvVar *var, pvType type, unsigned count, void *arg);
+    pvStat (*varMonitorOff)(pvVar *var);
+    unsigned (*varGetCount)(pvVar *var);
+    /* optional, see pvVarGetType */
+    pvType (*varGetType)(pvVar *var);
+    /* optional, see pvVarMonitorOnMask */
+    pvStat (*varMonitorOnMask)(pvVar *var, pvType type, unsigned count, unsigned mask, void *arg);
 };
 
 #define pvSysIsDefined(x) ((x).id != NULL)
@@ -61,13 +90,55 @@ struct pvVar {
 epicsShareExtern const struct pvSystem nullPvSys;
 epicsShareExtern const struct pvVar nullPvVar;
 
+/* built-in backends */
+epicsShareExtern const pvBackend pvCaBackend;       /* Channel Access */
+epicsShareExtern const pvBackend pvLoopbackBackend; /* in-process PVs */
+
+/* Find a built-in backend by name */
+epicsShareFunc const pvBackend *pvBackendFind(const char *name);
+
+/* Same as pvSysCreateBackend(pSys, "ca") */
 epicsShareFunc pvStat pvSysCreate(pvSystem *pSys);
+
+/* Create a pv system using the backend given by spec, which is
+ * the name of a built-in backend, optionally followed by a colon
+ * and options for the backend (see below), separated by colons.
+ * The option "share", which any backend takes, turns on sharing
+ * (pvSysShare), e.g. "ca:share". */
+epicsShareFunc pvStat pvSysCreateBackend(pvSystem *pSys, const char *spec);
 epicsShareFunc pvStat pvSysFlush(pvSystem sys);
 epicsShareFunc pvStat pvSysAttach(pvSystem sys);
 
+/* Turn on sharing for variables created in the pv system from now on
+ * (off by default, since it costs a copy of each monitor event):
+ * all variables with the same name and priority use one channel of the
+ * backend, and all their monitors with the same type, count and mask one
+ * subscription, whose events are passed on to each of them. A variable
+ * created when its channel is already connected gets its connection
+ * event, and a monitor that joins an existing subscription its last
+ * value, from a thread of the pv system. pvSysShareInfo returns the
+ * number of shared variables, and of channels and subscriptions they
+ * actually use. */
+epicsShareFunc pvStat pvSysShare(pvSystem *pSys);
+epicsShareFunc void pvSysShareInfo(pvSystem sys, unsigned *numVars,
+    unsigned *numChannels, unsigned *numMonitors);
+
 epicsShareFunc pvStat pvVarCreate(pvSystem sys, const char *name,
     pvConnFunc *conn_func, pvEventFunc *event_func, void *arg, pvVar *var);
+
+/* Like pvVarCreate, but with a priority between pvPriorityMin (the
+ * default) and pvPriorityMax. With CA, channels of different priority
+ * use separate circuits, and servers handle higher priorities first;
+ * the other backends ignore it. */
+#define pvPriorityMin   0
+#define pvPriorityMax   99
+epicsShareFunc pvStat pvVarCreatePriority(pvSystem sys, const char *name,
+    unsigned priority, pvConnFunc *conn_func, pvEventFunc *event_func,
+    void *arg, pvVar *var);
 epicsShareFunc pvStat pvVarDestroy(pvVar *var);
+/* A count of 0 for gets and monitors asks for the number of elements
+ * the server currently has (e.g. NORD of a waveform) where the backend
+ * supports it; the event handler gets the count actually delivered. */
 epicsShareFunc pvStat pvVarGetCallback(pvVar *var, pvType type, unsigned count, void *arg);
 epicsShareFunc pvStat pvVarPutNoBlock(pvVar *var, pvType type, unsigned count, pvValue *value);
 epicsShareFunc pvStat pvVarPutCallback(pvVar *var, pvType type, unsigned count, pvValue *value, void *arg);
@@ -75,8 +146,64 @@ epicsShareFunc pvStat pvVarPutCallback(pvVar *var, pvType type, unsigned count,
 epicsShareFunc pvStat pvVarMonitorOn(pvVar *var, pvType type, unsigned count, void *arg);
 epicsShareFunc pvStat pvVarMonitorOff(pvVar *var);
 
+/* Which changes a monitor reports; the values are those of EPICS'
+ * DBE_VALUE, DBE_ARCHIVE (aka DBE_LOG), DBE_ALARM and DBE_PROPERTY.
+ * pvVarMonitorOn uses pvMonitorDefault, as does a mask of 0. Backends
+ * that cannot select events ignore the mask. */
+#define pvMonitorValue      1
+#define pvMonitorArchive    2
+#define pvMonitorAlarm      4
+#define pvMonitorProperty   8
+#define pvMonitorDefault    (pvMonitorValue|pvMonitorAlarm)
+
+epicsShareFunc pvStat pvVarMonitorOnMask(pvVar *var, pvType type, unsigned count,
+    unsigned mask, void *arg);
+
+/* A get or monitor of pvTypeCTRL (count 1) delivers a pvCtrl with the
+ * channel's units, precision, limits, and enum strings. These rarely
+ * change, so it is usually monitored with pvMonitorProperty, which
+ * sends the current values first and then again whenever they change
+ * (loopback: whenever pvLoopbackSetCtrl is called). */
+
 epicsShareFunc unsigned pvVarGetCount(pvVar *var);
 
+/* The native (simple) type of a connected variable, i.e. the type in
+ * which the server holds the value; pvTypeERROR if it is not connected
+ * or the backend cannot tell. */
+epicsShareFunc pvType pvVarGetType(pvVar *var);
+
+/* Convert count elements from src of srcType to dst of dstType, the
+ * way the servers do it. Either type may be a time type; if dstType
+ * is one, status, severity, and time stamp are copied from src, or
+ * cleared if srcType is a simple type. Conversion from floating point
+ * to integer types truncates towards zero and wraps around within 32
+ * bits, so that e.g. 40000.0 arrives in an unsigned short variable
+ * unchanged. Conversions to and from strings are not supported unless
+ * both types are strings, nor those to and from pvTypeCTRL (pvStatERROR). */
+epicsShareFunc pvStat pvConvert(pvType dstType, void *dst,
+    pvType srcType, const void *src, unsigned count);
+
+/* The loopback backend ("loopback") implements PVs in the process
+ * itself, without any network or server. A PV exists as soon as a
+ * pvVar with its name is created, and is shared by all loopback pv
+ * systems in the process. Its type and element count are those given
+ * to pvLoopbackDefine, or else those of the first get, put, or
+ * monitor request; until then pvVarGetCount returns UINT_MAX. A put
+ * of fewer elements sets the rest to zero and shrinks the array that a
+ * get or monitor with count 0 delivers, as a waveform's NORD does.
+ *
+ * All callbacks are made from a thread that belongs to the pv system,
+ * in the order of the requests. The options "latency=<seconds>" and
+ * "rate=<events per second>", separated by colons (e.g.
+ * "loopback:latency=0.001:rate=1000"), delay each callback by the
+ * given latency after its request, and space them out so that no more
+ * than the given number are made per second. */
+epicsShareFunc pvStat pvLoopbackDefine(const char *name, pvType type, unsigned count);
+
+/* Set the control information of a loopback PV (all zero until then)
+ * and post it to the monitors of its channels. */
+epicsShareFunc pvStat pvLoopbackSetCtrl(const char *name, const pvCtrl *ctrl);
+
 #define pvVarGetPrivate(var) (var).arg
 #define pvVarGetMess(var) (var).msg
 #define pvSysGetMess(sys) (sys).msg
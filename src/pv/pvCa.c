@@ -0,0 +1,284 @@
+/*************************************************************************\
+This file is distributed subject to a Software License Agreement found
+in the file LICENSE that is included with this distribution.
+\*************************************************************************/
+/* Channel Access backend for the pv library */
+#include <assert.h>
+#include <limits.h>
+#include <string.h>
+
+#include "errlog.h"
+#include "cadef.h"
+
+#define epicsExportSharedSymbols
+#include "pv.h"
+
+#define INVOKE(x, expr) \
+    {\
+        int _status = expr;\
+        if (!(_status & CA_M_SUCCESS)) {\
+            (x)->msg = ca_message(_status);\
+            errlogSevPrintf(sevrFromCA(_status), "%s: %s", #expr, ca_message(_status));\
+            return statFromCA(_status);\
+        }\
+    }
+
+#define caChid(var) ((chid)(var)->chid)
+#define caEvid(var) ((evid)(var)->monid)
+
+/* utilities */
+static pvSevr sevrFromCA(long status);  /* CA severity as pvSevr */
+static pvStat statFromCA(long status);  /* CA status as pvStat */
+static pvType typeFromCA(long type);    /* DBR type as pvType */
+static chtype typeToCA(pvType type);    /* pvType as DBR type */
+static chtype requestType(pvVar *var, pvType type);
+static void ctrlFromCA(pvCtrl *ctrl, long type, const void *dbr);
+
+static pvStat pvCaSysCreate(pvSystem *pSys, const char *options)
+{
+    assert(!ca_current_context());
+    INVOKE(pSys, ca_context_create(ca_enable_preemptive_callback));
+    pSys->id = ca_current_context();
+    return pvStatOK;
+}
+
+static pvStat pvCaSysFlush(pvSystem *sys)
+{
+    INVOKE(sys, ca_flush_io());
+    return pvStatOK;
+}
+
+static pvStat pvCaSysAttach(pvSystem *sys)
+{
+    if (!ca_current_context())
+        INVOKE(sys, ca_attach_context((struct ca_client_context *)sys->id));
+    return pvStatOK;
+}
+
+static void pvCaConnectionHandler(struct connection_handler_args args)
+{
+    pvVar *var = (pvVar *)ca_puser(args.chid);
+    var->conn_handler(args.op == CA_OP_CONN_UP, var->arg);
+}
+
+static pvStat pvCaVarCreate(pvSystem *sys, const char *name, pvVar *var)
+{
+    chid id;
+
+    INVOKE(var, ca_create_channel(name, pvCaConnectionHandler, var, var->priority, &id));
+    var->chid = id;
+    return pvStatOK;
+}
+
+static pvStat pvCaVarDestroy(pvVar *var)
+{
+    INVOKE(var, ca_clear_channel(caChid(var)));
+    return pvStatOK;
+}
+
+static void pvCaEventHandler(struct event_handler_args args, pvEventType evt)
+{
+    pvVar *var = (pvVar *)ca_puser(args.chid);
+    unsigned count = (unsigned)args.count;
+    assert(args.count >= 0);
+    assert((long)count == args.count);
+    var->msg = ca_message(args.status);
+    if (args.type >= DBR_CTRL_STRING && args.type <= DBR_CTRL_DOUBLE) {
+        pvCtrl ctrl;
+
+        if (args.dbr)
+            ctrlFromCA(&ctrl, args.type, args.dbr);
+        var->event_handler(evt, args.usr, pvTypeCTRL, 1, args.dbr ? &ctrl : NULL, statFromCA(args.status));
+        return;
+    }
+    var->event_handler(evt, args.usr, typeFromCA(args.type), count, (pvValue*)args.dbr, statFromCA(args.status));
+}
+
+static void pvCaGetHandler(struct event_handler_args args)
+{
+    pvCaEventHandler(args, pvEventGet);
+}
+
+static void pvCaPutHandler(struct event_handler_args args)
+{
+    pvCaEventHandler(args, pvEventPut);
+}
+
+static void pvCaMonitorHandler(struct event_handler_args args)
+{
+    pvCaEventHandler(args, pvEventMonitor);
+}
+
+static pvStat pvCaVarGetCallback(pvVar *var, pvType type, unsigned count, void *arg)
+{
+    INVOKE(var, ca_array_get_callback(
+        requestType(var, type), count, caChid(var), pvCaGetHandler, arg));
+    return pvStatOK;
+}
+
+static pvStat pvCaVarPutNoBlock(pvVar *var, pvType type, unsigned count, pvValue *value)
+{
+    INVOKE(var, ca_array_put(typeToCA(type), count, caChid(var), value));
+    return pvStatOK;
+}
+
+static pvStat pvCaVarPutCallback(pvVar *var, pvType type, unsigned count, pvValue *value, void *arg)
+{
+    INVOKE(var, ca_array_put_callback(
+        typeToCA(type), count, caChid(var), value, pvCaPutHandler, arg));
+    return pvStatOK;
+}
+
+/* the pvMonitorXxx bits are those of DBE_XXX */
+static pvStat pvCaVarMonitorOnMask(pvVar *var, pvType type, unsigned count,
+    unsigned mask, void *arg)
+{
+    evid id;
+
+    INVOKE(var, ca_create_subscription(requestType(var, type), count, caChid(var),
+        (long)mask, pvCaMonitorHandler, arg, &id));
+    var->monid = id;
+    return pvStatOK;
+}
+
+static pvStat pvCaVarMonitorOn(pvVar *var, pvType type, unsigned count, void *arg)
+{
+    return pvCaVarMonitorOnMask(var, type, count, DBE_VALUE | DBE_ALARM, arg);
+}
+
+static pvStat pvCaVarMonitorOff(pvVar *var)
+{
+    INVOKE(var, ca_clear_event(caEvid(var)));
+    return pvStatOK;
+}
+
+static unsigned pvCaVarGetCount(pvVar *var)
+{
+    unsigned long c = ca_element_count(caChid(var));
+    assert(c <= UINT_MAX);
+    return (unsigned)c;
+}
+
+static pvType pvCaVarGetType(pvVar *var)
+{
+    return typeFromCA(ca_field_type(caChid(var)));
+}
+
+epicsShareDef const pvBackend pvCaBackend = {
+    "ca",
+    pvCaSysCreate,
+    pvCaSysFlush,
+    pvCaSysAttach,
+    pvCaVarCreate,
+    pvCaVarDestroy,
+    pvCaVarGetCallback,
+    pvCaVarPutNoBlock,
+    pvCaVarPutCallback,
+    pvCaVarMonitorOn,
+    pvCaVarMonitorOff,
+    pvCaVarGetCount,
+    pvCaVarGetType,
+    pvCaVarMonitorOnMask,
+};
+
+#include "alarm.h"
+
+static pvSevr sevrFromCA(long status)
+{
+    switch (CA_EXTRACT_SEVERITY(status)) {
+        case CA_K_INFO:    return pvSevrNONE;
+        case CA_K_SUCCESS: return pvSevrNONE;
+        case CA_K_WARNING: return pvSevrMINOR;
+        case CA_K_ERROR:   return pvSevrMAJOR;
+        case CA_K_SEVERE:  return pvSevrINVALID;
+        default:           return pvSevrERROR;
+    }
+}
+
+static pvStat statFromCA(long status)
+{
+    pvSevr sevr = sevrFromCA(status);
+    return (sevr == pvSevrNONE || sevr == pvSevrMINOR) ?
+                pvStatOK : pvStatERROR;
+}
+
+static pvType typeFromCA(long type)
+{
+    switch (type) {
+        case DBR_CHAR:          return pvTypeCHAR;
+        case DBR_SHORT:         return pvTypeSHORT;
+        case DBR_ENUM:          return pvTypeSHORT;
+        case DBR_LONG:          return pvTypeLONG;
+        case DBR_FLOAT:         return pvTypeFLOAT;
+        case DBR_DOUBLE:        return pvTypeDOUBLE;
+        case DBR_STRING:        return pvTypeSTRING;
+        case DBR_TIME_CHAR:     return pvTypeTIME_CHAR;
+        case DBR_TIME_SHORT:    return pvTypeTIME_SHORT;
+        case DBR_TIME_ENUM:     return pvTypeTIME_SHORT;
+        case DBR_TIME_LONG:     return pvTypeTIME_LONG;
+        case DBR_TIME_FLOAT:    return pvTypeTIME_FLOAT;
+        case DBR_TIME_DOUBLE:   return pvTypeTIME_DOUBLE;
+        case DBR_TIME_STRING:   return pvTypeTIME_STRING;
+        default:                return pvTypeERROR;
+    }
+}
+
+static chtype typeToCA(pvType type)
+{
+    switch (type) {
+        case pvTypeCHAR:        return DBR_CHAR;
+        case pvTypeSHORT:       return DBR_SHORT;
+        case pvTypeLONG:        return DBR_LONG;
+        case pvTypeFLOAT:       return DBR_FLOAT;
+        case pvTypeDOUBLE:      return DBR_DOUBLE;
+        case pvTypeSTRING:      return DBR_STRING;
+        case pvTypeTIME_CHAR:   return DBR_TIME_CHAR;
+        case pvTypeTIME_SHORT:  return DBR_TIME_SHORT;
+        case pvTypeTIME_LONG:   return DBR_TIME_LONG;
+        case pvTypeTIME_FLOAT:  return DBR_TIME_FLOAT;
+        case pvTypeTIME_DOUBLE: return DBR_TIME_DOUBLE;
+        case pvTypeTIME_STRING: return DBR_TIME_STRING;
+        default:                return -1;
+    }
+}
+
+/* The DBR type to get or monitor: for pvTypeCTRL that with the most
+   information for the channel's native type */
+static chtype requestType(pvVar *var, pvType type)
+{
+    if (type != pvTypeCTRL)
+        return typeToCA(type);
+    switch (ca_field_type(caChid(var))) {
+        case DBR_ENUM:          return DBR_CTRL_ENUM;
+        case DBR_STRING:        return DBR_CTRL_STRING;
+        default:                return DBR_CTRL_DOUBLE;
+    }
+}
+
+static void ctrlFromCA(pvCtrl *ctrl, long type, const void *dbr)
+{
+    memset(ctrl, 0, sizeof(pvCtrl));
+    if (type == DBR_CTRL_ENUM) {
+        const struct dbr_ctrl_enum *e = (const struct dbr_ctrl_enum *)dbr;
+        int i;
+
+        ctrl->numChoices = e->no_str < 0 ? 0 :
+            e->no_str > pvMaxChoices ? pvMaxChoices : (epicsUInt16)e->no_str;
+        for (i = 0; i < ctrl->numChoices; i++) {
+            strncpy(ctrl->choices[i], e->strs[i], pvChoiceSize - 1);
+        }
+    } else if (type == DBR_CTRL_DOUBLE) {
+        const struct dbr_ctrl_double *d = (const struct dbr_ctrl_double *)dbr;
+
+        memcpy(ctrl->units, d->units, pvUnitsSize - 1);
+        ctrl->precision = d->precision;
+        ctrl->displayLow = d->lower_disp_limit;
+        ctrl->displayHigh = d->upper_disp_limit;
+        ctrl->controlLow = d->lower_ctrl_limit;
+        ctrl->controlHigh = d->upper_ctrl_limit;
+        ctrl->alarmLow = d->lower_alarm_limit;
+        ctrl->alarmHigh = d->upper_alarm_limit;
+        ctrl->warningLow = d->lower_warning_limit;
+        ctrl->warningHigh = d->upper_warning_limit;
+    }
+}
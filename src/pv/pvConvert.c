@@ -0,0 +1,197 @@
+/*************************************************************************\
+This file is distributed subject to a Software License Agreement found
+in the file LICENSE that is included with this distribution.
+\*************************************************************************/
+/* Conversion between pv types, for clients that request the native
+ * type of a channel and convert on their own side */
+#include <assert.h>
+#include <limits.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PV_CONVERT_SSE2
+#include <emmintrin.h>
+#endif
+
+#define epicsExportSharedSymbols
+#include "pv.h"
+
+/* The common pairs (native short, long, or float arrays into double
+ * variables) have their own kernels; with SSE2 these convert 4 to 8
+ * elements per step, the remaining elements (and everything on other
+ * targets) go through the plain loops below them. */
+
+static void shortToDouble(pvDouble *dst, const pvShort *src, unsigned n)
+{
+    unsigned i = 0;
+
+#ifdef PV_CONVERT_SSE2
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+        /* sign extend by unpacking into the upper halves and shifting down */
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_pd(dst + i,     _mm_cvtepi32_pd(lo));
+        _mm_storeu_pd(dst + i + 2, _mm_cvtepi32_pd(_mm_shuffle_epi32(lo, 0x4E)));
+        _mm_storeu_pd(dst + i + 4, _mm_cvtepi32_pd(hi));
+        _mm_storeu_pd(dst + i + 6, _mm_cvtepi32_pd(_mm_shuffle_epi32(hi, 0x4E)));
+    }
+#endif
+    for (; i < n; i++)
+        dst[i] = src[i];
+}
+
+static void longToDouble(pvDouble *dst, const pvLong *src, unsigned n)
+{
+    unsigned i = 0;
+
+#ifdef PV_CONVERT_SSE2
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+        _mm_storeu_pd(dst + i,     _mm_cvtepi32_pd(v));
+        _mm_storeu_pd(dst + i + 2, _mm_cvtepi32_pd(_mm_shuffle_epi32(v, 0x4E)));
+    }
+#endif
+    for (; i < n; i++)
+        dst[i] = src[i];
+}
+
+static void floatToDouble(pvDouble *dst, const pvFloat *src, unsigned n)
+{
+    unsigned i = 0;
+
+#ifdef PV_CONVERT_SSE2
+    for (; i + 4 <= n; i += 4) {
+        __m128 v = _mm_loadu_ps(src + i);
+        _mm_storeu_pd(dst + i,     _mm_cvtps_pd(v));
+        _mm_storeu_pd(dst + i + 2, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+    }
+#endif
+    for (; i < n; i++)
+        dst[i] = src[i];
+}
+
+/* Floating point to integer, truncating towards zero. Values that fit
+ * into 32 bits unsigned but not signed wrap around, so that they
+ * survive the trip into an unsigned variable; anything else out of
+ * range (and NaN) saturates. */
+static pvLong toLong(double v)
+{
+    if (v >= 2147483648.0)
+        return v < 4294967296.0 ? (pvLong)(epicsUInt32)v : -1;
+    if (v >= -2147483648.0)
+        return (pvLong)v;
+    return v < 0 ? INT_MIN : 0;
+}
+
+/* Other pairs go through double, a block of elements at a time, so
+ * that the switch on the type is not made for each element. */
+#define BLOCK 256
+
+static void toDouble(double *dst, pvType type, const void *src, unsigned n)
+{
+    unsigned i;
+
+    switch (type) {
+    case pvTypeCHAR:
+        for (i = 0; i < n; i++) dst[i] = ((const pvChar *)src)[i];
+        break;
+    case pvTypeSHORT:
+        for (i = 0; i < n; i++) dst[i] = ((const pvShort *)src)[i];
+        break;
+    case pvTypeLONG:
+        for (i = 0; i < n; i++) dst[i] = ((const pvLong *)src)[i];
+        break;
+    case pvTypeFLOAT:
+        for (i = 0; i < n; i++) dst[i] = ((const pvFloat *)src)[i];
+        break;
+    case pvTypeDOUBLE:
+        memcpy(dst, src, n * sizeof(double));
+        break;
+    default:
+        assert(0);
+    }
+}
+
+static void fromDouble(pvType type, void *dst, const double *src, unsigned n)
+{
+    unsigned i;
+
+    switch (type) {
+    case pvTypeCHAR:
+        for (i = 0; i < n; i++) ((pvChar *)dst)[i] = (pvChar)toLong(src[i]);
+        break;
+    case pvTypeSHORT:
+        for (i = 0; i < n; i++) ((pvShort *)dst)[i] = (pvShort)toLong(src[i]);
+        break;
+    case pvTypeLONG:
+        for (i = 0; i < n; i++) ((pvLong *)dst)[i] = toLong(src[i]);
+        break;
+    case pvTypeFLOAT:
+        for (i = 0; i < n; i++) ((pvFloat *)dst)[i] = (pvFloat)src[i];
+        break;
+    case pvTypeDOUBLE:
+        memcpy(dst, src, n * sizeof(double));
+        break;
+    default:
+        assert(0);
+    }
+}
+
+epicsShareFunc pvStat pvConvert(pvType dstType, void *dst,
+    pvType srcType, const void *src, unsigned count)
+{
+    pvType dstSimple = pv_simple_type(dstType);
+    pvType srcSimple = pv_simple_type(srcType);
+    void *dstValue;
+    const void *srcValue;
+    unsigned i;
+
+    assert(dst && src);
+    assert(pv_is_valid_type(dstType) && pv_is_valid_type(srcType));
+
+    if ((dstSimple == pvTypeSTRING) != (srcSimple == pvTypeSTRING)
+        || (dstSimple == pvTypeCTRL) != (srcSimple == pvTypeCTRL))
+        return pvStatERROR;
+
+    if (pv_is_time_type(dstType)) {
+        unsigned d = dstType - pvTypeTIME_CHAR;
+        char *p = (char *)dst;
+
+        if (pv_is_time_type(srcType)) {
+            unsigned s = srcType - pvTypeTIME_CHAR;
+            const char *q = (const char *)src;
+
+            memcpy(p + pv_status_offsets[d], q + pv_status_offsets[s], sizeof(epicsInt16));
+            memcpy(p + pv_severity_offsets[d], q + pv_severity_offsets[s], sizeof(epicsInt16));
+            memcpy(p + pv_stamp_offsets[d], q + pv_stamp_offsets[s], sizeof(epicsTimeStamp));
+        } else {
+            memset(p + pv_status_offsets[d], 0, sizeof(epicsInt16));
+            memset(p + pv_severity_offsets[d], 0, sizeof(epicsInt16));
+            memset(p + pv_stamp_offsets[d], 0, sizeof(epicsTimeStamp));
+        }
+    }
+
+    dstValue = pv_value_ptr(dst, dstType);
+    srcValue = pv_value_ptr((void *)src, srcType);
+
+    if (dstSimple == srcSimple) {
+        memmove(dstValue, srcValue, count * pv_value_sizes[dstSimple]);
+    } else if (dstSimple == pvTypeDOUBLE && srcSimple == pvTypeSHORT) {
+        shortToDouble((pvDouble *)dstValue, (const pvShort *)srcValue, count);
+    } else if (dstSimple == pvTypeDOUBLE && srcSimple == pvTypeLONG) {
+        longToDouble((pvDouble *)dstValue, (const pvLong *)srcValue, count);
+    } else if (dstSimple == pvTypeDOUBLE && srcSimple == pvTypeFLOAT) {
+        floatToDouble((pvDouble *)dstValue, (const pvFloat *)srcValue, count);
+    } else {
+        double block[BLOCK];
+
+        for (i = 0; i < count; i += BLOCK) {
+            unsigned n = count - i < BLOCK ? count - i : BLOCK;
+
+            toDouble(block, srcSimple, (const char *)srcValue + i * pv_value_sizes[srcSimple], n);
+            fromDouble(dstSimple, (char *)dstValue + i * pv_value_sizes[dstSimple], block, n);
+        }
+    }
+    return pvStatOK;
+}
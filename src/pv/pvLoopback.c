@@ -0,0 +1,708 @@
+/*************************************************************************\
+This file is distributed subject to a Software License Agreement found
+in the file LICENSE that is included with this distribution.
+\*************************************************************************/
+/*************************************************************************\
+Loopback backend for the pv library: named PVs that live in the process
+itself, so that programs can be run, benchmarked and profiled without
+an IOC or network.
+
+Each pv system has a thread that makes all callbacks. Requests are
+appended to the system's list of pending events, each with the time
+when it is due: the time of the request plus the latency, but no
+earlier than the previous event plus the minimum interval (1/rate).
+The thread waits for the first event to become due, removes it, and
+handles it: a get or monitor converts the PV's value to the requested
+type, a put converts the given value to the PV's type, stores it (the
+elements it does not give are set to zero, and the number it gives is
+what a get or monitor with count 0 delivers, like NORD of a waveform) and
+posts monitors to all channels of the PV (in any system). Monitors
+take a copy of the value when posted, like Channel Access does.
+Control information (pvTypeCTRL) is whatever pvLoopbackSetCtrl last
+set; requests for it never fix the PV's type.
+
+A put posts a value and archive event, pvLoopbackSetCtrl a property
+event; a monitor only gets those its event mask selects. There are no
+alarms, so a monitor of alarm events only gets the first event.
+
+The thread holds the system's callback lock while it handles an
+event; destroying a channel or turning off its monitor takes the same
+lock, and removes the channel's pending events, so that no callback
+happens afterwards.
+\*************************************************************************/
+#include <assert.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "epicsEvent.h"
+#include "epicsMutex.h"
+#include "epicsThread.h"
+#include "epicsTime.h"
+#include "errlog.h"
+
+#define epicsExportSharedSymbols
+#include "pv.h"
+
+typedef struct lbPv     LBPV;
+typedef struct lbSys    LBSYS;
+typedef struct lbChan   LBCHAN;
+typedef struct lbMon    LBMON;
+typedef struct lbEvent  LBEVENT;
+
+enum lbEventKind { lbEvConnect, lbEvGet, lbEvPut, lbEvPutNoBlock, lbEvMonitor };
+
+/* a named PV, shared by all loopback systems */
+struct lbPv {
+    LBPV            *next;
+    char            *name;
+    pvType          type;       /* simple type, pvTypeERROR if not yet known */
+    unsigned        count;      /* number of elements */
+    unsigned        used;       /* elements in use (cf. NORD), set by puts */
+    void            *value;     /* count elements of type */
+    epicsTimeStamp  stamp;      /* time of last put */
+    pvCtrl          ctrl;       /* see pvLoopbackSetCtrl */
+    LBCHAN          *chans;     /* channels connected to this PV */
+};
+
+struct lbSys {
+    double          latency;    /* delay of each event */
+    double          interval;   /* minimum time between events */
+    double          lastDue;    /* when the last pending event is due */
+    epicsMutexId    lock;       /* protects the list of pending events */
+    epicsMutexId    cbLock;     /* held while an event is handled */
+    epicsEventId    wakeup;     /* signalled when an event is added */
+    LBEVENT         *first;     /* pending events, in order */
+    LBEVENT         *last;
+};
+
+struct lbChan {
+    LBCHAN          *next;      /* next channel of the same PV */
+    LBPV            *pv;
+    LBSYS           *sys;
+    pvVar           *var;
+};
+
+struct lbMon {
+    LBCHAN          *chan;
+    pvType          type;
+    unsigned        count;
+    unsigned        mask;       /* events to post (pvMonitor...) */
+    void            *arg;
+};
+
+struct lbEvent {
+    LBEVENT         *next;
+    double          due;
+    enum lbEventKind kind;
+    LBCHAN          *chan;
+    pvType          type;
+    unsigned        count;
+    void            *arg;
+    void            *data;      /* value to put resp. monitored value */
+};
+
+/* the PVs, protected by pvLock */
+static LBPV *pvList;
+static epicsMutexId pvLock;
+
+static void lbInit(void *arg)
+{
+    pvLock = epicsMutexCreate();
+    if (!pvLock) {
+        errlogSevPrintf(errlogFatal, "pvLoopback: epicsMutexCreate failed\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void lbLazyInit(void)
+{
+    static epicsThreadOnceId lbOnceFlag = EPICS_THREAD_ONCE_INIT;
+    epicsThreadOnce(&lbOnceFlag, lbInit, NULL);
+}
+
+static double lbNow(void)
+{
+    double now;
+
+    pvTimeGetCurrentDouble(&now);
+    return now;
+}
+
+/* Value conversion between simple types */
+
+static double lbGetDouble(pvType type, const void *p, unsigned i)
+{
+    switch (type) {
+    case pvTypeCHAR:    return ((const pvChar *)p)[i];
+    case pvTypeSHORT:   return ((const pvShort *)p)[i];
+    case pvTypeLONG:    return ((const pvLong *)p)[i];
+    case pvTypeFLOAT:   return ((const pvFloat *)p)[i];
+    case pvTypeDOUBLE:  return ((const pvDouble *)p)[i];
+    case pvTypeSTRING:  return strtod(((const pvString *)p)[i], NULL);
+    default:            return 0;
+    }
+}
+
+static void lbPutDouble(pvType type, void *p, unsigned i, double v)
+{
+    switch (type) {
+    case pvTypeCHAR:    ((pvChar *)p)[i] = (pvChar)v; break;
+    case pvTypeSHORT:   ((pvShort *)p)[i] = (pvShort)v; break;
+    case pvTypeLONG:    ((pvLong *)p)[i] = (pvLong)v; break;
+    case pvTypeFLOAT:   ((pvFloat *)p)[i] = (pvFloat)v; break;
+    case pvTypeDOUBLE:  ((pvDouble *)p)[i] = v; break;
+    case pvTypeSTRING:
+        sprintf(((pvString *)p)[i], "%.*g", 15, v);
+        break;
+    default:            break;
+    }
+}
+
+/* Convert srcCount elements to dstCount elements of another simple
+   type; missing elements are set to zero */
+static void lbConvert(pvType dstType, void *dst, unsigned dstCount,
+    pvType srcType, const void *src, unsigned srcCount)
+{
+    unsigned i, n = dstCount < srcCount ? dstCount : srcCount;
+
+    if (dstType == srcType) {
+        memcpy(dst, src, n * pv_value_sizes[dstType]);
+    } else {
+        for (i = 0; i < n; i++)
+            lbPutDouble(dstType, dst, i, lbGetDouble(srcType, src, i));
+    }
+    memset((char *)dst + n * pv_value_sizes[dstType], 0,
+        (dstCount - n) * pv_value_sizes[dstType]);
+}
+
+/* Give a PV whose type is not yet known the given type and count */
+static pvStat lbFixType(LBPV *pv, pvType type, unsigned count)
+{
+    if (pv->type != pvTypeERROR || type == pvTypeCTRL)
+        return pvStatOK;
+    if (pv_is_time_type(type))
+        type = (pvType)(type - pvTypeTIME_CHAR);
+    if (count == 0)
+        count = 1;
+    pv->value = calloc(count, pv_value_sizes[type]);
+    if (!pv->value)
+        return pvStatERROR;
+    pv->type = type;
+    pv->count = pv->used = count;
+    return pvStatOK;
+}
+
+/* Allocate a buffer with the PV's value as the given type and count;
+   must be called with pvLock taken */
+static void *lbRead(LBPV *pv, pvType type, unsigned count)
+{
+    pvType valueType = pv_is_time_type(type) ? (pvType)(type - pvTypeTIME_CHAR) : type;
+    void *buf;
+
+    if (type == pvTypeCTRL) {
+        buf = malloc(sizeof(pvCtrl));
+        if (buf)
+            memcpy(buf, &pv->ctrl, sizeof(pvCtrl));
+        return buf;
+    }
+    if (count == 0)
+        count = pv->used;
+    buf = calloc(1, pv_size_n(type, count));
+    if (!buf)
+        return NULL;
+    lbConvert(valueType, pv_value_ptr(buf, type), count,
+        pv->type, pv->value, pv->count);
+    if (pv_is_time_type(type)) {
+        unsigned t = type - pvTypeTIME_CHAR;
+
+        /* status and severity are 0, i.e. no alarm */
+        *(epicsTimeStamp *)((char *)buf + pv_stamp_offsets[t]) = pv->stamp;
+    }
+    return buf;
+}
+
+/* Event list */
+
+static LBEVENT *lbNewEvent(LBCHAN *chan, enum lbEventKind kind,
+    pvType type, unsigned count, void *arg)
+{
+    LBEVENT *ev = (LBEVENT *)calloc(1, sizeof(LBEVENT));
+
+    if (ev) {
+        ev->chan = chan;
+        ev->kind = kind;
+        ev->type = type;
+        ev->count = count;
+        ev->arg = arg;
+    }
+    return ev;
+}
+
+static void lbFreeEvent(LBEVENT *ev)
+{
+    free(ev->data);
+    free(ev);
+}
+
+static void lbAppend(LBSYS *sys, LBEVENT *ev)
+{
+    double due = lbNow() + sys->latency;
+
+    epicsMutexMustLock(sys->lock);
+    if (due < sys->lastDue + sys->interval)
+        due = sys->lastDue + sys->interval;
+    ev->due = sys->lastDue = due;
+    if (sys->last)
+        sys->last->next = ev;
+    else
+        sys->first = ev;
+    sys->last = ev;
+    epicsMutexUnlock(sys->lock);
+    epicsEventSignal(sys->wakeup);
+}
+
+/* Remove pending events of the channel (all of them, or only monitor
+   events); must be called with the callback lock taken */
+static void lbCancel(LBCHAN *chan, int monitorsOnly)
+{
+    LBSYS *sys = chan->sys;
+    LBEVENT **pev, *prev = NULL;
+
+    epicsMutexMustLock(sys->lock);
+    pev = &sys->first;
+    while (*pev) {
+        LBEVENT *ev = *pev;
+
+        if (ev->chan == chan && (!monitorsOnly || ev->kind == lbEvMonitor)) {
+            *pev = ev->next;
+            lbFreeEvent(ev);
+        } else {
+            prev = ev;
+            pev = &ev->next;
+        }
+    }
+    sys->last = prev;
+    epicsMutexUnlock(sys->lock);
+}
+
+/* Post the PV's value to all channels monitoring any of the given
+   events; must be called with pvLock taken */
+static void lbPostMonitors(LBPV *pv, unsigned events)
+{
+    LBCHAN *chan;
+
+    for (chan = pv->chans; chan; chan = chan->next) {
+        LBMON *mon = (LBMON *)chan->var->monid;
+        LBEVENT *ev;
+
+        if (!mon || !(mon->mask & events))
+            continue;
+        ev = lbNewEvent(chan, lbEvMonitor, mon->type,
+            mon->count ? mon->count : pv->used, mon->arg);
+        if (ev && !(ev->data = lbRead(pv, mon->type, ev->count))) {
+            free(ev);
+            ev = NULL;
+        }
+        if (!ev) {
+            errlogSevPrintf(errlogMajor, "pvLoopback(%s): out of memory, monitor lost\n", pv->name);
+            continue;
+        }
+        lbAppend(chan->sys, ev);
+    }
+}
+
+static void lbHandle(LBEVENT *ev)
+{
+    LBCHAN *chan = ev->chan;
+    pvVar *var = chan->var;
+    LBPV *pv = chan->pv;
+
+    switch (ev->kind) {
+    case lbEvConnect:
+        var->conn_handler(TRUE, var->arg);
+        break;
+    case lbEvGet:
+        epicsMutexMustLock(pvLock);
+        if (ev->count == 0)
+            ev->count = pv->used;
+        ev->data = lbRead(pv, ev->type, ev->count);
+        epicsMutexUnlock(pvLock);
+        var->msg = ev->data ? "Normal successful completion" : "out of memory";
+        var->event_handler(pvEventGet, ev->arg, ev->type, ev->count, ev->data,
+            ev->data ? pvStatOK : pvStatERROR);
+        break;
+    case lbEvPut:
+    case lbEvPutNoBlock:
+        epicsMutexMustLock(pvLock);
+        lbConvert(pv->type, pv->value, pv->count, ev->type, ev->data, ev->count);
+        pv->used = ev->count < pv->count ? ev->count : pv->count;
+        epicsTimeGetCurrent(&pv->stamp);
+        lbPostMonitors(pv, pvMonitorValue|pvMonitorArchive);
+        epicsMutexUnlock(pvLock);
+        if (ev->kind == lbEvPut) {
+            var->msg = "Normal successful completion";
+            var->event_handler(pvEventPut, ev->arg, ev->type, ev->count, NULL, pvStatOK);
+        }
+        break;
+    case lbEvMonitor:
+        var->msg = "Normal successful completion";
+        var->event_handler(pvEventMonitor, ev->arg, ev->type, ev->count,
+            ev->data, pvStatOK);
+        break;
+    }
+}
+
+static void lbTask(void *arg)
+{
+    LBSYS *sys = (LBSYS *)arg;
+
+    for (;;) {
+        LBEVENT *ev;
+        double wait;
+
+        epicsMutexMustLock(sys->cbLock);
+        epicsMutexMustLock(sys->lock);
+        ev = sys->first;
+        wait = ev ? ev->due - lbNow() : -1;
+        if (ev && wait <= 0) {
+            sys->first = ev->next;
+            if (!sys->first)
+                sys->last = NULL;
+        }
+        epicsMutexUnlock(sys->lock);
+        if (ev && wait <= 0)
+            lbHandle(ev);
+        epicsMutexUnlock(sys->cbLock);
+        if (!ev)
+            epicsEventMustWait(sys->wakeup);
+        else if (wait > 0)
+            epicsEventWaitWithTimeout(sys->wakeup, wait);
+        else
+            lbFreeEvent(ev);
+    }
+}
+
+/* Parse "latency=<seconds>" and "rate=<events per second>",
+   separated by colons */
+static pvStat lbParseOptions(LBSYS *sys, const char *options)
+{
+    while (*options) {
+        double value;
+        int n = 0;
+
+        if (sscanf(options, "latency=%lf%n", &value, &n) == 1 && value >= 0) {
+            sys->latency = value;
+        } else if (sscanf(options, "rate=%lf%n", &value, &n) == 1 && value >= 0) {
+            sys->interval = value > 0 ? 1.0 / value : 0;
+        } else {
+            return pvStatERROR;
+        }
+        options += n;
+        if (*options == ':')
+            options++;
+        else if (*options)
+            return pvStatERROR;
+    }
+    return pvStatOK;
+}
+
+static pvStat lbSysCreate(pvSystem *pSys, const char *options)
+{
+    LBSYS *sys = (LBSYS *)calloc(1, sizeof(LBSYS));
+
+    lbLazyInit();
+    if (!sys) {
+        pSys->msg = "out of memory";
+        return pvStatERROR;
+    }
+    if (lbParseOptions(sys, options) != pvStatOK) {
+        pSys->msg = "invalid loopback options";
+        errlogSevPrintf(errlogMajor, "pvLoopback: invalid options '%s'\n", options);
+        free(sys);
+        return pvStatERROR;
+    }
+    sys->lock = epicsMutexCreate();
+    sys->cbLock = epicsMutexCreate();
+    sys->wakeup = epicsEventCreate(epicsEventEmpty);
+    if (!sys->lock || !sys->cbLock || !sys->wakeup
+        || !epicsThreadCreate("pvLoopback", epicsThreadPriorityMedium,
+            epicsThreadGetStackSize(epicsThreadStackMedium), lbTask, sys)) {
+        pSys->msg = "cannot create loopback thread";
+        if (sys->lock)
+            epicsMutexDestroy(sys->lock);
+        if (sys->cbLock)
+            epicsMutexDestroy(sys->cbLock);
+        if (sys->wakeup)
+            epicsEventDestroy(sys->wakeup);
+        free(sys);
+        return pvStatERROR;
+    }
+    pSys->id = sys;
+    return pvStatOK;
+}
+
+static pvStat lbSysFlush(pvSystem *sys)
+{
+    return pvStatOK;
+}
+
+static pvStat lbSysAttach(pvSystem *sys)
+{
+    return pvStatOK;
+}
+
+/* Find the PV with the given name, creating it if necessary; must be
+   called with pvLock taken */
+static LBPV *lbFind(const char *name)
+{
+    LBPV *pv;
+
+    for (pv = pvList; pv; pv = pv->next) {
+        if (strcmp(pv->name, name) == 0)
+            return pv;
+    }
+    pv = (LBPV *)calloc(1, sizeof(LBPV));
+    if (!pv)
+        return NULL;
+    pv->name = (char *)malloc(strlen(name) + 1);
+    if (!pv->name) {
+        free(pv);
+        return NULL;
+    }
+    strcpy(pv->name, name);
+    pv->type = pvTypeERROR;
+    pv->next = pvList;
+    pvList = pv;
+    return pv;
+}
+
+epicsShareFunc pvStat pvLoopbackDefine(const char *name, pvType type, unsigned count)
+{
+    LBPV *pv;
+    pvStat status = pvStatERROR;
+
+    if (!pv_is_simple_type(type) || count == 0)
+        return pvStatERROR;
+    lbLazyInit();
+    epicsMutexMustLock(pvLock);
+    pv = lbFind(name);
+    if (pv && pv->type == pvTypeERROR)
+        status = lbFixType(pv, type, count);
+    else if (pv && pv->type == type && pv->count == count)
+        status = pvStatOK;
+    epicsMutexUnlock(pvLock);
+    return status;
+}
+
+epicsShareFunc pvStat pvLoopbackSetCtrl(const char *name, const pvCtrl *ctrl)
+{
+    LBPV *pv;
+
+    lbLazyInit();
+    epicsMutexMustLock(pvLock);
+    pv = lbFind(name);
+    if (pv) {
+        pv->ctrl = *ctrl;
+        lbPostMonitors(pv, pvMonitorProperty);
+    }
+    epicsMutexUnlock(pvLock);
+    return pv ? pvStatOK : pvStatERROR;
+}
+
+static pvStat lbVarCreate(pvSystem *sys, const char *name, pvVar *var)
+{
+    LBCHAN *chan = (LBCHAN *)calloc(1, sizeof(LBCHAN));
+    LBEVENT *ev = lbNewEvent(chan, lbEvConnect, pvTypeERROR, 0, NULL);
+
+    if (chan && ev) {
+        epicsMutexMustLock(pvLock);
+        chan->pv = lbFind(name);
+        if (chan->pv) {
+            chan->next = chan->pv->chans;
+            chan->pv->chans = chan;
+        }
+        epicsMutexUnlock(pvLock);
+    }
+    if (!chan || !ev || !chan->pv) {
+        var->msg = "out of memory";
+        free(chan);
+        free(ev);
+        return pvStatERROR;
+    }
+    chan->sys = (LBSYS *)sys->id;
+    chan->var = var;
+    var->chid = chan;
+    lbAppend(chan->sys, ev);
+    return pvStatOK;
+}
+
+static pvStat lbVarDestroy(pvVar *var)
+{
+    LBCHAN *chan = (LBCHAN *)var->chid;
+    LBCHAN **pc;
+
+    epicsMutexMustLock(chan->sys->cbLock);
+    /* first stop further monitor events from puts in other systems */
+    epicsMutexMustLock(pvLock);
+    for (pc = &chan->pv->chans; *pc; pc = &(*pc)->next) {
+        if (*pc == chan) {
+            *pc = chan->next;
+            break;
+        }
+    }
+    epicsMutexUnlock(pvLock);
+    lbCancel(chan, FALSE);
+    epicsMutexUnlock(chan->sys->cbLock);
+    free(var->monid);
+    free(chan);
+    return pvStatOK;
+}
+
+static pvStat lbVarGetCallback(pvVar *var, pvType type, unsigned count, void *arg)
+{
+    LBCHAN *chan = (LBCHAN *)var->chid;
+    LBEVENT *ev;
+    pvStat status;
+
+    epicsMutexMustLock(pvLock);
+    status = lbFixType(chan->pv, type, count);
+    epicsMutexUnlock(pvLock);
+    ev = status == pvStatOK ? lbNewEvent(chan, lbEvGet, type, count, arg) : NULL;
+    if (!ev) {
+        var->msg = "out of memory";
+        return pvStatERROR;
+    }
+    lbAppend(chan->sys, ev);
+    return pvStatOK;
+}
+
+static pvStat lbQueuePut(pvVar *var, enum lbEventKind kind, pvType type,
+    unsigned count, pvValue *value, void *arg)
+{
+    LBCHAN *chan = (LBCHAN *)var->chid;
+    LBEVENT *ev;
+    pvStat status;
+
+    if (count == 0)
+        count = 1;
+    epicsMutexMustLock(pvLock);
+    status = lbFixType(chan->pv, type, count);
+    epicsMutexUnlock(pvLock);
+    ev = status == pvStatOK ? lbNewEvent(chan, kind, type, count, arg) : NULL;
+    if (ev && (ev->data = malloc(count * pv_value_sizes[type])) != NULL) {
+        memcpy(ev->data, value, count * pv_value_sizes[type]);
+    } else {
+        free(ev);
+        var->msg = "out of memory";
+        return pvStatERROR;
+    }
+    lbAppend(chan->sys, ev);
+    return pvStatOK;
+}
+
+static pvStat lbVarPutNoBlock(pvVar *var, pvType type, unsigned count, pvValue *value)
+{
+    return lbQueuePut(var, lbEvPutNoBlock, type, count, value, NULL);
+}
+
+static pvStat lbVarPutCallback(pvVar *var, pvType type, unsigned count, pvValue *value, void *arg)
+{
+    return lbQueuePut(var, lbEvPut, type, count, value, arg);
+}
+
+static pvStat lbVarMonitorOnMask(pvVar *var, pvType type, unsigned count,
+    unsigned mask, void *arg)
+{
+    LBCHAN *chan = (LBCHAN *)var->chid;
+    LBMON *mon = (LBMON *)calloc(1, sizeof(LBMON));
+    LBEVENT *ev = lbNewEvent(chan, lbEvMonitor, type, count, arg);
+    pvStat status = pvStatERROR;
+
+    if (mon && ev) {
+        mon->chan = chan;
+        mon->type = type;
+        mon->count = count;
+        mon->mask = mask;
+        mon->arg = arg;
+        epicsMutexMustLock(pvLock);
+        status = lbFixType(chan->pv, type, count);
+        if (count == 0)
+            ev->count = chan->pv->used;
+        /* the first event has the current value */
+        if (status == pvStatOK && (ev->data = lbRead(chan->pv, type, ev->count)) != NULL)
+            var->monid = mon;
+        else
+            status = pvStatERROR;
+        epicsMutexUnlock(pvLock);
+    }
+    if (status != pvStatOK) {
+        var->msg = "out of memory";
+        free(mon);
+        if (ev)
+            lbFreeEvent(ev);
+        return pvStatERROR;
+    }
+    lbAppend(chan->sys, ev);
+    return pvStatOK;
+}
+
+static pvStat lbVarMonitorOn(pvVar *var, pvType type, unsigned count, void *arg)
+{
+    return lbVarMonitorOnMask(var, type, count, pvMonitorDefault, arg);
+}
+
+static pvStat lbVarMonitorOff(pvVar *var)
+{
+    LBCHAN *chan = (LBCHAN *)var->chid;
+    void *mon = var->monid;
+
+    epicsMutexMustLock(chan->sys->cbLock);
+    epicsMutexMustLock(pvLock);
+    var->monid = NULL;
+    epicsMutexUnlock(pvLock);
+    lbCancel(chan, TRUE);
+    epicsMutexUnlock(chan->sys->cbLock);
+    free(mon);
+    return pvStatOK;
+}
+
+static unsigned lbVarGetCount(pvVar *var)
+{
+    LBCHAN *chan = (LBCHAN *)var->chid;
+    unsigned count;
+
+    epicsMutexMustLock(pvLock);
+    count = chan->pv->type == pvTypeERROR ? UINT_MAX : chan->pv->count;
+    epicsMutexUnlock(pvLock);
+    return count;
+}
+
+static pvType lbVarGetType(pvVar *var)
+{
+    LBCHAN *chan = (LBCHAN *)var->chid;
+    pvType type;
+
+    epicsMutexMustLock(pvLock);
+    type = chan->pv->type;
+    epicsMutexUnlock(pvLock);
+    return type;
+}
+
+epicsShareDef const pvBackend pvLoopbackBackend = {
+    "loopback",
+    lbSysCreate,
+    lbSysFlush,
+    lbSysAttach,
+    lbVarCreate,
+    lbVarDestroy,
+    lbVarGetCallback,
+    lbVarPutNoBlock,
+    lbVarPutCallback,
+    lbVarMonitorOn,
+    lbVarMonitorOff,
+    lbVarGetCount,
+    lbVarGetType,
+    lbVarMonitorOnMask,
+};
@@ -0,0 +1,794 @@
+/*************************************************************************\
+This file is distributed subject to a Software License Agreement found
+in the file LICENSE that is included with this distribution.
+\*************************************************************************/
+/*************************************************************************\
+Shared channels and subscriptions for the pv library.
+
+When sharing is turned on for a pv system (pvSysShare), all variables
+with the same name and priority use one channel of the backend, and
+all monitors of such variables with the same type, count, and event
+mask use one subscription. Events from the backend are fanned out to the variables:
+connection changes to all of them, monitor events to those that monitor
+with the subscription's type, count, and mask, and completions of gets
+and puts to the variable that made the request. The first subscription
+of a channel uses the channel's own backend variable; subscriptions
+with other types, counts, or masks each need another one.
+
+The cache lock protects the hash table, the lists of variables,
+subscriptions, and requests, and all reference counts; it is never
+held while calling a handler or a backend function. Each channel has a
+callback lock which is held while handlers of its variables are called,
+so that every variable sees the events in order. pvVarDestroy marks the
+variable as dead and then takes the callback lock, so no handler is
+called after it returns; like with the backends, it must not be called
+with a lock held that handlers take.
+
+A variable that is created for a channel that is already connected, or
+monitors with a subscription that already exists, gets its connection
+event and the subscription's last value from the cache's own thread.
+\*************************************************************************/
+#include <assert.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "epicsEvent.h"
+#include "epicsMutex.h"
+#include "epicsString.h"
+#include "epicsThread.h"
+#include "errlog.h"
+
+#define epicsExportSharedSymbols
+#include "pv.h"
+
+typedef struct shCache  SHCACHE;
+typedef struct shChan   SHCHAN;
+typedef struct shSub    SHSUB;
+typedef struct shVar    SHVAR;
+typedef struct shReq    SHREQ;
+
+#define NUM_BUCKETS 256
+
+struct shCache {
+    pvSystem        sys;        /* the backend's pv system */
+    epicsMutexId    lock;
+    epicsEventId    wakeup;     /* signalled when a variable is queued */
+    SHCHAN          *buckets[NUM_BUCKETS];
+    SHVAR           *first;     /* variables waiting for the thread */
+    SHVAR           *last;
+    unsigned        numVars;
+    unsigned        numChans;
+    unsigned        numSubs;
+};
+
+struct shChan {
+    SHCHAN          *next;      /* in the same bucket */
+    SHCACHE         *cache;
+    char            *name;
+    unsigned        priority;
+    pvVar           var;        /* the backend's variable */
+    epicsMutexId    cbLock;     /* held while handlers are called */
+    int             hashed;     /* found by name and priority */
+    int             connected;
+    int             primaryUsed;/* var's monitor belongs to a subscription */
+    unsigned        numLive;    /* variables not yet destroyed */
+    unsigned        refs;       /* variables, subscriptions, backend
+                                   variable, and running callbacks */
+    SHVAR           *vars;
+    SHVAR           *lastVar;
+    SHSUB           *subs;
+    SHREQ           *reqs;      /* pending gets and puts */
+};
+
+struct shSub {
+    SHSUB           *next;      /* of the same channel */
+    SHCHAN          *chan;
+    pvVar           *var;       /* &chan->var or &own */
+    pvVar           own;
+    pvType          type;
+    unsigned        count;
+    unsigned        mask;       /* pvMonitorXxx */
+    unsigned        numVars;    /* variables that monitor with it */
+    unsigned        refs;       /* the backend's monitor, running callbacks */
+    int             busy;       /* monitor is being turned on */
+    int             orphan;     /* no variables left while busy */
+    /* the last event, for variables that join later */
+    int             hasValue;
+    void            *value;
+    size_t          size;       /* of the value buffer */
+    unsigned        valueCount;
+    pvStat          status;
+};
+
+struct shVar {
+    SHVAR           *prev;      /* of the same channel */
+    SHVAR           *next;
+    SHVAR           *nextQueued;/* waiting for the cache's thread */
+    SHCHAN          *chan;
+    pvVar           *var;       /* the user's variable */
+    SHSUB           *sub;       /* if monitored */
+    void            *monArg;
+    unsigned        refs;       /* the variable itself, queue, requests,
+                                   and running callbacks */
+    int             dead;       /* pvVarDestroy has been called */
+    int             queued;
+    /* only accessed with the channel's callback lock taken: */
+    int             connected;  /* as reported to the handler */
+    int             gotMonitor; /* since pvVarMonitorOn */
+};
+
+struct shReq {
+    SHREQ           *prev;      /* of the same channel */
+    SHREQ           *next;
+    SHVAR           *v;
+    void            *arg;
+};
+
+/* The functions named ...Release must be called with the cache lock
+   taken; the object may be freed, after which the caller must not
+   touch it, nor any lock it contains. */
+
+static void shChanRelease(SHCHAN *chan)
+{
+    if (--chan->refs == 0) {
+        epicsMutexDestroy(chan->cbLock);
+        free(chan->name);
+        free(chan);
+    }
+}
+
+static void shSubRelease(SHSUB *sub)
+{
+    if (--sub->refs == 0) {
+        shChanRelease(sub->chan);
+        free(sub->value);
+        free(sub);
+    }
+}
+
+static void shVarRelease(SHVAR *v)
+{
+    if (--v->refs == 0) {
+        SHCHAN *chan = v->chan;
+
+        if (v->prev)
+            v->prev->next = v->next;
+        else
+            chan->vars = v->next;
+        if (v->next)
+            v->next->prev = v->prev;
+        else
+            chan->lastVar = v->prev;
+        free(v);
+        shChanRelease(chan);
+    }
+}
+
+/* Remove the channel from the hash table, so that variables created
+   later get a new one; must be called with the cache lock taken */
+static void shUnhash(SHCHAN *chan)
+{
+    SHCACHE *cache = chan->cache;
+    SHCHAN **pc = &cache->buckets[epicsStrHash(chan->name, 0) % NUM_BUCKETS];
+
+    if (!chan->hashed)
+        return;
+    while (*pc != chan)
+        pc = &(*pc)->next;
+    *pc = chan->next;
+    chan->hashed = FALSE;
+    cache->numChans--;
+}
+
+/* Queue the variable for the cache's thread; must be called with the
+   cache lock taken */
+static void shQueue(SHVAR *v)
+{
+    SHCACHE *cache = v->chan->cache;
+
+    if (v->queued)
+        return;
+    v->queued = TRUE;
+    v->refs++;
+    v->nextQueued = NULL;
+    if (cache->last)
+        cache->last->nextQueued = v;
+    else
+        cache->first = v;
+    cache->last = v;
+    epicsEventSignal(cache->wakeup);
+}
+
+/* Return the next live variable after v (the first one if v is NULL)
+   that monitors with sub (or any variable if sub is NULL), with a
+   reference taken, and release the reference on v */
+static SHVAR *shNextVar(SHCHAN *chan, SHVAR *v, SHSUB *sub)
+{
+    SHVAR *next;
+
+    epicsMutexMustLock(chan->cache->lock);
+    next = v ? v->next : chan->vars;
+    while (next && (next->dead || (sub && next->sub != sub)))
+        next = next->next;
+    if (next)
+        next->refs++;
+    if (v)
+        shVarRelease(v);
+    epicsMutexUnlock(chan->cache->lock);
+    return next;
+}
+
+/* Backend handlers */
+
+static void shConn(int connected, void *arg)
+{
+    SHCHAN *chan = (SHCHAN *)arg;
+    SHCACHE *cache = chan->cache;
+    SHVAR *v;
+
+    epicsMutexMustLock(chan->cbLock);
+    epicsMutexMustLock(cache->lock);
+    chan->connected = connected;
+    chan->refs++;
+    epicsMutexUnlock(cache->lock);
+    for (v = shNextVar(chan, NULL, NULL); v; v = shNextVar(chan, v, NULL)) {
+        if (v->connected != connected) {
+            v->connected = connected;
+            v->var->conn_handler(connected, v->var->arg);
+        }
+    }
+    epicsMutexUnlock(chan->cbLock);
+    epicsMutexMustLock(cache->lock);
+    shChanRelease(chan);
+    epicsMutexUnlock(cache->lock);
+}
+
+static void shSubConn(int connected, void *arg)
+{
+    SHSUB *sub = (SHSUB *)arg;
+
+    /* subscriptions of their own survive disconnects, like the
+       channel's, so we only need to turn the monitor on once */
+    if (connected && !pvMonIsDefined(sub->own)
+        && pvVarMonitorOnMask(&sub->own, sub->type, sub->count, sub->mask, sub) != pvStatOK) {
+        errlogSevPrintf(errlogMajor, "pvShare(%s): pvVarMonitorOnMask failed: %s\n",
+            sub->chan->name, pvVarGetMess(sub->own));
+    }
+}
+
+static void shMonitorEvent(SHSUB *sub, pvType type, unsigned count,
+    pvValue *value, pvStat status)
+{
+    SHCHAN *chan = sub->chan;
+    SHCACHE *cache = chan->cache;
+    size_t size = pv_size_n(type, count);
+    SHVAR *v;
+
+    epicsMutexMustLock(cache->lock);
+    sub->refs++;
+    epicsMutexUnlock(cache->lock);
+    epicsMutexMustLock(chan->cbLock);
+    /* keep a copy for variables that join later */
+    if (value && size > sub->size) {
+        free(sub->value);
+        sub->value = malloc(size);
+        sub->size = sub->value ? size : 0;
+    }
+    sub->hasValue = value && sub->value;
+    if (sub->hasValue) {
+        memcpy(sub->value, value, size);
+        sub->valueCount = count;
+        sub->status = status;
+    }
+    for (v = shNextVar(chan, NULL, sub); v; v = shNextVar(chan, v, sub)) {
+        v->gotMonitor = TRUE;
+        v->var->msg = sub->var->msg;
+        v->var->event_handler(pvEventMonitor, v->monArg, type, count, value, status);
+    }
+    epicsMutexUnlock(chan->cbLock);
+    epicsMutexMustLock(cache->lock);
+    shSubRelease(sub);
+    epicsMutexUnlock(cache->lock);
+}
+
+static void shRequestDone(SHREQ *req, pvEventType evt, pvType type,
+    unsigned count, pvValue *value, pvStat status)
+{
+    SHVAR *v = req->v;
+    SHCHAN *chan = v->chan;
+    SHCACHE *cache = chan->cache;
+    int dead;
+
+    epicsMutexMustLock(chan->cbLock);
+    epicsMutexMustLock(cache->lock);
+    if (req->prev)
+        req->prev->next = req->next;
+    else
+        chan->reqs = req->next;
+    if (req->next)
+        req->next->prev = req->prev;
+    dead = v->dead;
+    epicsMutexUnlock(cache->lock);
+    if (!dead) {
+        v->var->msg = chan->var.msg;
+        v->var->event_handler(evt, req->arg, type, count, value, status);
+    }
+    epicsMutexUnlock(chan->cbLock);
+    epicsMutexMustLock(cache->lock);
+    shVarRelease(v);
+    epicsMutexUnlock(cache->lock);
+    free(req);
+}
+
+static void shEvent(pvEventType evt, void *arg, pvType type, unsigned count,
+    pvValue *value, pvStat status)
+{
+    if (evt == pvEventMonitor)
+        shMonitorEvent((SHSUB *)arg, type, count, value, status);
+    else
+        shRequestDone((SHREQ *)arg, evt, type, count, value, status);
+}
+
+/* The cache's thread: tell variables that joined late about the
+   connection and the subscription's last value */
+
+static void shCatchUp(SHVAR *v)
+{
+    SHCHAN *chan = v->chan;
+    SHCACHE *cache = chan->cache;
+    SHSUB *sub = NULL;
+    int connected;
+
+    epicsMutexMustLock(chan->cbLock);
+    epicsMutexMustLock(cache->lock);
+    connected = chan->connected && !v->dead;
+    epicsMutexUnlock(cache->lock);
+    if (connected && !v->connected) {
+        v->connected = TRUE;
+        v->var->conn_handler(TRUE, v->var->arg);
+    }
+    /* the handler may have turned the monitor on or off */
+    epicsMutexMustLock(cache->lock);
+    if (!v->dead && v->connected && v->sub && !v->gotMonitor) {
+        sub = v->sub;
+        sub->refs++;
+    }
+    epicsMutexUnlock(cache->lock);
+    if (sub) {
+        if (sub->hasValue) {
+            v->gotMonitor = TRUE;
+            v->var->msg = sub->var->msg;
+            v->var->event_handler(pvEventMonitor, v->monArg, sub->type,
+                sub->valueCount, (pvValue *)sub->value, sub->status);
+        }
+        epicsMutexMustLock(cache->lock);
+        shSubRelease(sub);
+        epicsMutexUnlock(cache->lock);
+    }
+    epicsMutexUnlock(chan->cbLock);
+}
+
+static void shTask(void *arg)
+{
+    SHCACHE *cache = (SHCACHE *)arg;
+
+    /* handlers may call pv functions */
+    pvSysAttach(cache->sys);
+    for (;;) {
+        SHVAR *v;
+
+        epicsMutexMustLock(cache->lock);
+        v = cache->first;
+        if (v) {
+            cache->first = v->nextQueued;
+            if (!cache->first)
+                cache->last = NULL;
+            v->queued = FALSE;
+        }
+        epicsMutexUnlock(cache->lock);
+        if (!v) {
+            pvSysFlush(cache->sys);
+            epicsEventMustWait(cache->wakeup);
+            continue;
+        }
+        shCatchUp(v);
+        epicsMutexMustLock(cache->lock);
+        shVarRelease(v);
+        epicsMutexUnlock(cache->lock);
+    }
+}
+
+/* Turn off the subscription's monitor and release it; called without
+   the cache lock */
+static void shSubDestroy(SHSUB *sub)
+{
+    SHCHAN *chan = sub->chan;
+    SHCACHE *cache = chan->cache;
+
+    if (sub->var == &chan->var) {
+        if (pvVarMonitorOff(&chan->var) != pvStatOK) {
+            errlogSevPrintf(errlogMajor, "pvShare(%s): pvVarMonitorOff failed: %s\n",
+                chan->name, pvVarGetMess(chan->var));
+        }
+        epicsMutexMustLock(cache->lock);
+        chan->primaryUsed = FALSE;
+    } else {
+        if (pvVarIsDefined(sub->own) && pvVarDestroy(&sub->own) != pvStatOK) {
+            errlogSevPrintf(errlogMajor, "pvShare(%s): pvVarDestroy failed: %s\n",
+                chan->name, pvVarGetMess(sub->own));
+        }
+        epicsMutexMustLock(cache->lock);
+    }
+    shSubRelease(sub);
+    epicsMutexUnlock(cache->lock);
+}
+
+/* Functions for the variables */
+
+static pvStat shVarMonitorOff(pvVar *var)
+{
+    SHVAR *v = (SHVAR *)var->chid;
+    SHCACHE *cache = v->chan->cache;
+    SHSUB *sub;
+    int last = FALSE;
+
+    epicsMutexMustLock(cache->lock);
+    sub = v->sub;
+    v->sub = NULL;
+    if (sub && --sub->numVars == 0) {
+        SHSUB **ps;
+
+        for (ps = &v->chan->subs; *ps != sub; ps = &(*ps)->next)
+            ;
+        *ps = sub->next;
+        cache->numSubs--;
+        /* whoever turns the monitor on also turns it off again */
+        if (sub->busy)
+            sub->orphan = TRUE;
+        else
+            last = TRUE;
+    }
+    epicsMutexUnlock(cache->lock);
+    if (last)
+        shSubDestroy(sub);
+    return pvStatOK;
+}
+
+static pvStat shVarMonitorOnMask(pvVar *var, pvType type, unsigned count,
+    unsigned mask, void *arg)
+{
+    SHVAR *v = (SHVAR *)var->chid;
+    SHCHAN *chan = v->chan;
+    SHCACHE *cache = chan->cache;
+    SHSUB *sub;
+    pvStat status = pvStatOK;
+    int orphan;
+
+    epicsMutexMustLock(cache->lock);
+    for (sub = chan->subs; sub; sub = sub->next) {
+        if (sub->type == type && sub->count == count && sub->mask == mask)
+            break;
+    }
+    if (sub) {
+        sub->numVars++;
+        v->sub = sub;
+        v->monArg = arg;
+        v->gotMonitor = FALSE;
+        var->monid = sub;
+        shQueue(v);
+        epicsMutexUnlock(cache->lock);
+        return pvStatOK;
+    }
+    sub = (SHSUB *)calloc(1, sizeof(SHSUB));
+    if (!sub) {
+        epicsMutexUnlock(cache->lock);
+        var->msg = "out of memory";
+        return pvStatERROR;
+    }
+    sub->chan = chan;
+    sub->type = type;
+    sub->count = count;
+    sub->mask = mask;
+    sub->numVars = 1;
+    sub->refs = 1;
+    sub->busy = TRUE;
+    if (!chan->primaryUsed) {
+        chan->primaryUsed = TRUE;
+        sub->var = &chan->var;
+    } else {
+        sub->var = &sub->own;
+    }
+    sub->next = chan->subs;
+    chan->subs = sub;
+    chan->refs++;
+    cache->numSubs++;
+    v->sub = sub;
+    v->monArg = arg;
+    v->gotMonitor = FALSE;
+    var->monid = sub;
+    epicsMutexUnlock(cache->lock);
+
+    if (sub->var == &chan->var)
+        status = pvVarMonitorOnMask(&chan->var, type, count, mask, sub);
+    else
+        status = pvVarCreatePriority(cache->sys, chan->name, chan->priority,
+            shSubConn, shEvent, sub, &sub->own);
+    if (status != pvStatOK)
+        var->msg = sub->var->msg;
+
+    epicsMutexMustLock(cache->lock);
+    sub->busy = FALSE;
+    orphan = sub->orphan;
+    epicsMutexUnlock(cache->lock);
+    if (orphan)
+        shSubDestroy(sub);
+    else if (status != pvStatOK) {
+        shVarMonitorOff(var);
+        var->monid = NULL;
+    }
+    return status;
+}
+
+static pvStat shVarMonitorOn(pvVar *var, pvType type, unsigned count, void *arg)
+{
+    return shVarMonitorOnMask(var, type, count, pvMonitorDefault, arg);
+}
+
+static pvStat shVarDestroy(pvVar *var)
+{
+    SHVAR *v = (SHVAR *)var->chid;
+    SHCHAN *chan = v->chan;
+    SHCACHE *cache = chan->cache;
+    int last;
+
+    if (v->sub)
+        shVarMonitorOff(var);
+
+    epicsMutexMustLock(cache->lock);
+    v->dead = TRUE;
+    cache->numVars--;
+    last = --chan->numLive == 0;
+    if (last)
+        shUnhash(chan);
+    epicsMutexUnlock(cache->lock);
+
+    /* wait for handlers that are running */
+    epicsMutexMustLock(chan->cbLock);
+    epicsMutexUnlock(chan->cbLock);
+
+    if (last) {
+        SHREQ *req;
+
+        if (pvVarIsDefined(chan->var) && pvVarDestroy(&chan->var) != pvStatOK) {
+            errlogSevPrintf(errlogMajor, "pvShare(%s): pvVarDestroy failed: %s\n",
+                chan->name, pvVarGetMess(chan->var));
+        }
+        /* the backend has dropped the requests that were pending */
+        epicsMutexMustLock(cache->lock);
+        while ((req = chan->reqs) != NULL) {
+            chan->reqs = req->next;
+            shVarRelease(req->v);
+            free(req);
+        }
+        shChanRelease(chan);
+        epicsMutexUnlock(cache->lock);
+    }
+    epicsMutexMustLock(cache->lock);
+    shVarRelease(v);
+    epicsMutexUnlock(cache->lock);
+    return pvStatOK;
+}
+
+static pvStat shVarCreate(pvSystem *sys, const char *name, pvVar *var)
+{
+    SHCACHE *cache = (SHCACHE *)sys->share;
+    SHCHAN **bucket = &cache->buckets[epicsStrHash(name, 0) % NUM_BUCKETS];
+    SHVAR *v = (SHVAR *)calloc(1, sizeof(SHVAR));
+    SHCHAN *chan;
+    int created = FALSE;
+    pvStat status;
+
+    if (!v) {
+        var->msg = "out of memory";
+        return pvStatERROR;
+    }
+    epicsMutexMustLock(cache->lock);
+    for (chan = *bucket; chan; chan = chan->next) {
+        if (strcmp(chan->name, name) == 0 && chan->priority == var->priority)
+            break;
+    }
+    if (!chan) {
+        chan = (SHCHAN *)calloc(1, sizeof(SHCHAN));
+        if (chan && (!(chan->name = epicsStrDup(name))
+                || !(chan->cbLock = epicsMutexCreate()))) {
+            free(chan->name);
+            free(chan);
+            chan = NULL;
+        }
+        if (!chan) {
+            epicsMutexUnlock(cache->lock);
+            free(v);
+            var->msg = "out of memory";
+            return pvStatERROR;
+        }
+        chan->cache = cache;
+        chan->priority = var->priority;
+        chan->refs = 1;         /* the backend variable */
+        chan->next = *bucket;
+        *bucket = chan;
+        chan->hashed = TRUE;
+        cache->numChans++;
+        created = TRUE;
+    }
+    v->chan = chan;
+    v->var = var;
+    v->refs = 1;
+    v->prev = chan->lastVar;
+    if (chan->lastVar)
+        chan->lastVar->next = v;
+    else
+        chan->vars = v;
+    chan->lastVar = v;
+    chan->numLive++;
+    chan->refs++;
+    cache->numVars++;
+    var->chid = v;
+    if (chan->connected)
+        shQueue(v);
+    epicsMutexUnlock(cache->lock);
+
+    if (!created)
+        return pvStatOK;
+    status = pvVarCreatePriority(cache->sys, chan->name, chan->priority,
+        shConn, shEvent, chan, &chan->var);
+    if (status != pvStatOK) {
+        const char *msg = chan->var.msg;
+
+        /* variables that have joined in the meantime never connect,
+           but later ones get a new channel */
+        epicsMutexMustLock(cache->lock);
+        shUnhash(chan);
+        epicsMutexUnlock(cache->lock);
+        shVarDestroy(var);
+        var->msg = msg;
+    }
+    return status;
+}
+
+static pvStat shRequest(pvVar *var, pvEventType evt, pvType type,
+    unsigned count, pvValue *value, void *arg)
+{
+    SHVAR *v = (SHVAR *)var->chid;
+    SHCHAN *chan = v->chan;
+    SHCACHE *cache = chan->cache;
+    SHREQ *req = (SHREQ *)calloc(1, sizeof(SHREQ));
+    pvStat status;
+
+    if (!req) {
+        var->msg = "out of memory";
+        return pvStatERROR;
+    }
+    req->v = v;
+    req->arg = arg;
+    epicsMutexMustLock(cache->lock);
+    v->refs++;
+    req->next = chan->reqs;
+    if (chan->reqs)
+        chan->reqs->prev = req;
+    chan->reqs = req;
+    epicsMutexUnlock(cache->lock);
+
+    if (evt == pvEventGet)
+        status = pvVarGetCallback(&chan->var, type, count, req);
+    else
+        status = pvVarPutCallback(&chan->var, type, count, value, req);
+    if (status != pvStatOK) {
+        var->msg = chan->var.msg;
+        epicsMutexMustLock(cache->lock);
+        if (req->prev)
+            req->prev->next = req->next;
+        else
+            chan->reqs = req->next;
+        if (req->next)
+            req->next->prev = req->prev;
+        shVarRelease(v);
+        epicsMutexUnlock(cache->lock);
+        free(req);
+    }
+    return status;
+}
+
+static pvStat shVarGetCallback(pvVar *var, pvType type, unsigned count, void *arg)
+{
+    return shRequest(var, pvEventGet, type, count, NULL, arg);
+}
+
+static pvStat shVarPutCallback(pvVar *var, pvType type, unsigned count, pvValue *value, void *arg)
+{
+    return shRequest(var, pvEventPut, type, count, value, arg);
+}
+
+static pvStat shVarPutNoBlock(pvVar *var, pvType type, unsigned count, pvValue *value)
+{
+    SHVAR *v = (SHVAR *)var->chid;
+    pvStat status = pvVarPutNoBlock(&v->chan->var, type, count, value);
+
+    var->msg = v->chan->var.msg;
+    return status;
+}
+
+static unsigned shVarGetCount(pvVar *var)
+{
+    SHVAR *v = (SHVAR *)var->chid;
+
+    return pvVarIsDefined(v->chan->var) ? pvVarGetCount(&v->chan->var) : UINT_MAX;
+}
+
+static pvType shVarGetType(pvVar *var)
+{
+    SHVAR *v = (SHVAR *)var->chid;
+
+    return pvVarIsDefined(v->chan->var) ? pvVarGetType(&v->chan->var) : pvTypeERROR;
+}
+
+/* only the variable functions are used, see pvVarCreate */
+const pvBackend pvShareBackend = {
+    "share",
+    NULL,
+    NULL,
+    NULL,
+    shVarCreate,
+    shVarDestroy,
+    shVarGetCallback,
+    shVarPutNoBlock,
+    shVarPutCallback,
+    shVarMonitorOn,
+    shVarMonitorOff,
+    shVarGetCount,
+    shVarGetType,
+    shVarMonitorOnMask,
+};
+
+epicsShareFunc pvStat pvSysShare(pvSystem *sys)
+{
+    SHCACHE *cache;
+
+    assert(sys);
+    if (sys->share)
+        return pvStatOK;
+    cache = (SHCACHE *)calloc(1, sizeof(SHCACHE));
+    if (cache) {
+        cache->sys = *sys;
+        cache->lock = epicsMutexCreate();
+        cache->wakeup = epicsEventCreate(epicsEventEmpty);
+    }
+    if (!cache || !cache->lock || !cache->wakeup
+        || !epicsThreadCreate("pvShare", epicsThreadPriorityMedium,
+            epicsThreadGetStackSize(epicsThreadStackMedium), shTask, cache)) {
+        sys->msg = "cannot create pvShare thread";
+        if (cache && cache->lock)
+            epicsMutexDestroy(cache->lock);
+        if (cache && cache->wakeup)
+            epicsEventDestroy(cache->wakeup);
+        free(cache);
+        return pvStatERROR;
+    }
+    sys->share = cache;
+    return pvStatOK;
+}
+
+epicsShareFunc void pvSysShareInfo(pvSystem sys, unsigned *numVars,
+    unsigned *numChannels, unsigned *numMonitors)
+{
+    SHCACHE *cache = (SHCACHE *)sys.share;
+
+    *numVars = *numChannels = *numMonitors = 0;
+    if (!cache)
+        return;
+    epicsMutexMustLock(cache->lock);
+    *numVars = cache->numVars;
+    *numChannels = cache->numChans;
+    *numMonitors = cache->numSubs;
+    epicsMutexUnlock(cache->lock);
+}
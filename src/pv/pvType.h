@@ -32,7 +32,8 @@ typedef enum {
     pvTypeTIME_LONG   = 8,
     pvTypeTIME_FLOAT  = 9,
     pvTypeTIME_DOUBLE = 10,
-    pvTypeTIME_STRING = 11
+    pvTypeTIME_STRING = 11,
+    pvTypeCTRL        = 12
 } pvType;
 
 /* these must correspond to corresponding types in db_access.h */
@@ -45,12 +46,38 @@ typedef epicsOldString  pvString;   /* dbr_string_t */
 
 typedef void            pvValue;    /* abstract */
 
+/*
+ * Control information of a channel: the value of pvTypeCTRL, which
+ * can only be read (get or monitor) and always has a single element.
+ * Limits that the channel does not have are 0, as are numChoices
+ * and the choices unless it is an enum.
+ */
+#define pvUnitsSize     8           /* MAX_UNITS_SIZE */
+#define pvMaxChoices    16          /* MAX_ENUM_STATES */
+#define pvChoiceSize    26          /* MAX_ENUM_STRING_SIZE */
+
+typedef struct {
+    char            units[pvUnitsSize];
+    epicsInt16      precision;
+    epicsUInt16     numChoices;
+    epicsFloat64    displayLow, displayHigh;    /* LOPR, HOPR */
+    epicsFloat64    controlLow, controlHigh;    /* DRVL, DRVH */
+    epicsFloat64    alarmLow, alarmHigh;        /* LOLO, HIHI */
+    epicsFloat64    warningLow, warningHigh;    /* LOW, HIGH */
+    char            choices[pvMaxChoices][pvChoiceSize];
+} pvCtrl;
+
 #define pv_is_simple_type(type)\
     ((type)>=pvTypeCHAR&&(type)<=pvTypeSTRING)
 #define pv_is_time_type(type)\
     ((type)>=pvTypeTIME_CHAR&&(type)<=pvTypeTIME_STRING)
 #define pv_is_valid_type(type)\
-    ((type)>=pvTypeCHAR&&(type)<=pvTypeTIME_STRING)
+    ((type)>=pvTypeCHAR&&(type)<=pvTypeCTRL)
+
+#define pv_simple_type(type)\
+    (pv_is_time_type(type)?(pvType)((type)-pvTypeTIME_CHAR):(type))
+#define pv_time_type(type)\
+    (pv_is_simple_type(type)?(pvType)((type)+pvTypeTIME_CHAR):(type))
 
 #define pv_status(pv,type)\
     (assert(pv_is_time_type(type)),\
@@ -50,6 +50,14 @@ enum compType {
         SYNC
 };
 
+/* Kind of limits (extra argument passed to seq_pvLimits()) */
+enum pvLimitKind {
+	pvLimitDISPLAY,
+	pvLimitCONTROL,
+	pvLimitALARM,
+	pvLimitWARNING
+};
+
 typedef	struct state_set *const SS_ID;	/* state set id, opaque */
 typedef char string[MAX_STRING_SIZE];	/* representation of SNL string type */
 
@@ -62,6 +70,13 @@ typedef unsigned CH_ID;			/* identifier for a pv */
 
 typedef int seqBool;
 
+/* status, severity, and time stamp of a value (see pvGetQMany) */
+typedef struct seqPvMeta {
+	epicsTimeStamp	timeStamp;
+	pvStat		status;
+	pvSevr		severity;
+} seqPvMeta;
+
 typedef struct seqProgram seqProgram;	/* struct defined in generated code */
 
 /*
@@ -79,6 +94,9 @@ epicsShareFunc seqBool seq_efTestAndClear(SS_ID, EF_ID);
 epicsShareFunc pvStat seq_pvGet(SS_ID, CH_ID, enum compType);
 epicsShareFunc pvStat seq_pvGetTmo(SS_ID, CH_ID, enum compType, double tmo);
 epicsShareFunc seqBool seq_pvGetQ(SS_ID, CH_ID);
+epicsShareFunc unsigned seq_pvGetQMany(SS_ID, CH_ID, void *, unsigned, seqPvMeta *);
+epicsShareFunc unsigned seq_pvGetQMerge(SS_ID, const CH_ID *, unsigned,
+	void *, unsigned, unsigned *, seqPvMeta *);
 epicsShareFunc void seq_pvFlushQ(SS_ID, CH_ID);
 epicsShareFunc pvStat seq_pvPut(SS_ID, CH_ID, enum compType);
 epicsShareFunc pvStat seq_pvPutTmo(SS_ID, CH_ID, enum compType, double tmo);
@@ -102,9 +120,17 @@ epicsShareFunc epicsTimeStamp seq_pvTimeStamp(SS_ID, CH_ID);
 epicsShareFunc const char *seq_pvMessage(SS_ID, CH_ID);
 epicsShareFunc seqBool seq_pvAssigned(SS_ID, CH_ID);
 epicsShareFunc seqBool seq_pvConnected(SS_ID, CH_ID);
+/* cached control information */
+epicsShareFunc char *seq_pvUnits(SS_ID, CH_ID, char *);
+epicsShareFunc int seq_pvPrecision(SS_ID, CH_ID);
+epicsShareFunc pvStat seq_pvLimits(SS_ID, CH_ID, double *, double *, enum pvLimitKind);
+epicsShareFunc int seq_pvChoice(SS_ID, CH_ID, const char *);
 
 #define seq_pvIndex(ssId, chId)	chId
 
+/* message channel operations */
+epicsShareFunc seqBool seq_msgSend(SS_ID, unsigned);
+epicsShareFunc seqBool seq_msgRecv(SS_ID, unsigned);
 /* global operations */
 epicsShareFunc void seq_pvFlush(SS_ID);
 epicsShareFunc seqBool seq_delay(SS_ID, double);
@@ -122,6 +148,7 @@ epicsShareFunc void epicsShareAPI seqShow(epicsThreadId);
 epicsShareFunc void epicsShareAPI seqChanShow(epicsThreadId, const char *);
 epicsShareFunc void epicsShareAPI seqcar(int level);
 epicsShareFunc void epicsShareAPI seqQueueShow(epicsThreadId);
+epicsShareFunc void epicsShareAPI seqMemShow(epicsThreadId);
 epicsShareFunc void epicsShareAPI seqStop(epicsThreadId);
 epicsShareFunc epicsThreadId epicsShareAPI seq(seqProgram *, const char *, unsigned);
 
@@ -38,6 +38,7 @@ in the file LICENSE that is included with this distribution.
 #define bitMask seqMask
 
 #include "seq_queue.h"
+#include "seq_atomic.h"
 
 #define valPtr(ch,ss)		((char*)(ss)->var+(ch)->offset)
 #define bufPtr(ch)		((char*)(ch)->prog->var+(ch)->offset)
@@ -45,14 +46,23 @@ in the file LICENSE that is included with this distribution.
 #define ssNum(ss)		((ss)-(ss)->prog->ss)
 #define chNum(ch)		((ch)-(ch)->prog->chan)
 
+/* index of channel in per state set tables (getReq, putReq, ...) */
+#define ssSlot(ss,ch)		((ss)->chanMap?ss_slot(ss,chNum(ch)):chNum(ch))
+/* whether a slot is the spare one for channels the state set does not use;
+   pv functions must not be called for these, see seq_if.c */
+#define isSpareSlot(ss,slot)	((ss)->chanMap && (unsigned)(slot) == (ss)->numMapped)
+
 #define metaPtr(ch,ss) (			\
 	(ch)->dbch				\
 	?(optTest((ch)->prog,OPT_SAFE)		\
-		?(ss)->metaData + chNum(ch)	\
+		?(ss)->metaData + ssSlot(ss,ch)	\
 		:&(ch)->dbch->metaData)		\
 	:0					\
 )
 
+/* priority for creating the channel */
+#define chanPriority(ch)	((ch)->priority != PRIORITY_DEFAULT ? (ch)->priority : (ch)->prog->pvPriority)
+
 #define optTest(sp,opt)		(((sp)->options & (opt)) != 0)
 					/* test if opt is set in program instance sp */
 
@@ -74,6 +84,11 @@ in the file LICENSE that is included with this distribution.
 #define newArray(type,count)	(DEBUG("%s:%d:calloc(%u,%u)\n",__FILE__,__LINE__,count,sizeof(type)),(type *)calloc(count, sizeof(type)))
 #define new(type)		newArray(type,1)
 
+/* Event dispatch: values of up to 2^(DISPATCH_POOL_MIN+DISPATCH_NUM_POOLS-1)
+   bytes are copied into pooled buffers, larger ones are malloc'ed */
+#define DISPATCH_POOL_MIN	6
+#define DISPATCH_NUM_POOLS	11
+
 typedef struct db_channel	DBCHAN;
 typedef struct channel		CHAN;
 typedef seqState		STATE;
@@ -96,6 +111,10 @@ struct channel
 	unsigned	eventNum;	/* event number */
 	PVTYPE		*type;		/* request type info */
 	PROG		*prog;		/* state program that owns this struct*/
+	const char	*filter;	/* channel filter (JSON), or NULL */
+	unsigned	priority;	/* channel priority (PRIORITY_DEFAULT:
+					   that of the program) */
+	boolean		ctrl;		/* whether to cache control information */
 
 	/* dynamic channel data (assigned at runtime) */
 	DBCHAN		*dbch;		/* channel assigned to a named db pv */
@@ -103,9 +122,20 @@ struct channel
 	CHAN		*nextSynced;	/* next channel synced to same flag */
 	QUEUE		queue;		/* queue if queued */
 	boolean		monitored;	/* whether channel is monitored */
+	unsigned	monitorMask;	/* events to monitor (0=default) */
+	boolean		monitorDynamic;	/* monitor with count 0 */
+	unsigned	assignGen;	/* number of pvAssign calls, to drop
+					   dispatched events of the old pv */
+	struct dispatch_latest *dispatchLatest;/* newest monitor event that
+					   found the dispatch queue full */
+	seqAtomicSize	dispatchSeq;	/* monitor events seen by callbacks */
+	size_t		dispatchApplied;/* dispatchSeq of last event applied */
 	/* buffer access, only used in safe mode */
 	epicsMutexId	varLock;	/* mutex for locking access to shared
 					   var buffer and meta data */
+	SSCB		*owner;		/* only state set using this channel */
+	boolean		direct;		/* owner's buffer is newer than shared
+					   buffer (direct delivery) */
 };
 
 struct pv_type
@@ -123,6 +153,8 @@ struct pv_meta_data
 	pvStat		status;		/* status code */
 	pvSevr		severity;	/* severity code */
 	const char	*message;	/* error message */
+	unsigned	count;		/* number of elements received
+					   (0=none yet) */
 };
 
 /* Channel assigned to a named (database) pv */
@@ -131,9 +163,14 @@ struct db_channel
 	char		*dbName;	/* channel name after macro expansion */
 	pvVar		pvid;		/* PV (process variable) id */
 	unsigned	dbCount;	/* actual count for db access */
+	pvType		reqType;	/* type requested for gets and monitors */
+	void		*convBuf;	/* values converted from reqType */
 	boolean		connected;	/* whether channel is connected */
 	boolean		gotMonitor;	/* whether we got a monitor after connect */
 	PVMETA		metaData;	/* meta data (shared buffer) */
+	pvVar		ctrlid;		/* PV id for control information */
+	pvCtrl		*ctrl;		/* cached control information, NULL
+					   until received */
 };
 
 struct state_set
@@ -156,12 +193,20 @@ struct state_set
 	double		wakeupTime;	/* next time state set should wake up */
 	epicsEventId	syncSem;	/* semaphore for event sync */
 	epicsEventId	dead;		/* event to signal state set exit done */
-	/* these are arrays, one for each channel */
+	/* these are arrays, one for each channel the state set uses,
+	   see ssSlot() */
+	const unsigned	*chanMap;	/* sorted indices of used channels,
+					   NULL if all channels are used */
+	unsigned	numMapped;	/* number of entries in chanMap */
+	unsigned	numSlots;	/* number of entries in the arrays */
 	PVREQ		**getReq;	/* currently pending get requests */
 	PVREQ		**putReq;	/* currently pending put requests */
 	PVMETA		*metaData;	/* meta data (safe mode) */
 	/* safe mode */
 	boolean		*dirty;		/* array of flags, one for each channel */
+	epicsMutexId	varLock;	/* var lock for channels owned by this
+					   state set */
+	boolean		waiting;	/* waiting for events in main loop */
 };
 
 STATIC_ASSERT(offsetof(struct state_set,var)==0);
@@ -176,10 +221,18 @@ struct program_instance
 	unsigned	threadPriority;	/* thread priority (all threads) */
 	unsigned	stackSize;	/* stack size (all threads) */
 	pvSystem	pvSys;		/* pv system handle */
+	boolean		nativeType;	/* request channels' native types */
+	unsigned	pvPriority;	/* default channel priority */
+	unsigned	dispatchSize;	/* size of event dispatch queue
+					   (0=events are applied in callbacks) */
 	CHAN		*chan;		/* table of channels */
 	unsigned	numChans;	/* number of channels */
 	QUEUE		*queues;	/* array of syncQ queues */
 	unsigned	numQueues;	/* number of syncQ queues */
+	seqMsgChan	*msgChans;	/* table of message channels */
+	unsigned	numMsgChans;	/* number of message channels */
+	QUEUE		*msgQueues;	/* for each message channel one queue per
+					   state set, NULL if not a receiver */
 	SSCB		*ss;		/* array of state set control blocks */
 	unsigned	numSS;		/* number of state sets */
 	size_t		varSize;	/* size of user variable area */
@@ -203,6 +256,22 @@ struct program_instance
 					   a monitor event */
 
 	void		*pvReqPool;	/* freeList for pv requests (has own lock) */
+
+	/* event dispatch, only if dispatchSize != 0 (see seq_ca.c) */
+	QUEUE		dispatchQueue;	/* events from pv callbacks */
+	seqAtomicSize	dispatchPending;/* events put but not yet applied */
+	seqAtomicSize	dispatchLost;	/* monitor events replaced (full) */
+	epicsMutexId	latestLock;	/* protects dispatchLatest slots */
+	struct dispatch_latest *latestList;/* slots not yet applied */
+	epicsEventId	dispatchWake;	/* wakes up dispatcher */
+	epicsEventId	dispatchDead;	/* dispatcher has exited */
+	boolean		dispatchQuit;	/* dispatcher should exit */
+	void		*dispatchPools[DISPATCH_NUM_POOLS];
+					/* freeLists for values, by size */
+
+	void		*arena;		/* single block holding all fixed size
+					   tables (chan, ss, evFlags, ...) */
+	size_t		arenaSize;	/* size of arena in bytes */
 	boolean		die;		/* flag set when seqStop is called */
 	epicsEventId	ready;		/* all channels connected & got 1st monitor */
 	epicsEventId	dead;		/* event to signal exit of main thread done */
@@ -223,6 +292,9 @@ struct pvreq
 #define THREAD_STACK_SIZE	epicsThreadStackBig
 #define THREAD_PRIORITY		epicsThreadPriorityMedium
 
+/* Minimum time in seconds between reports of lost syncQ elements */
+#define QUEUE_LOSS_REPORT_INTERVAL	5.0
+
 /* Internal procedures */
 
 /* seq_task.c */
@@ -231,6 +303,7 @@ void ss_write_buffer(CHAN *ch, void *val, PVMETA *meta, boolean dirtify);
 void ss_read_buffer(SSCB *ss, CHAN *ch, boolean dirty_only);
 void ss_read_buffer_selective(PROG *sp, SSCB *ss, EF_ID ev_flag);
 void ss_wakeup(PROG *sp, unsigned eventNum);
+ptrdiff_t ss_slot(SSCB *ss, ptrdiff_t nch);
 
 /* seq_mac.c */
 void seqMacParse(PROG *sp, const char *macStr);
@@ -242,8 +315,13 @@ void seqMacFree(PROG *sp);
 pvConnFunc seq_conn_handler;
 pvEventFunc seq_event_handler;
 pvStat seq_connect(PROG *sp, boolean wait);
+pvStat seq_chan_create(CHAN *ch);
 void seq_disconnect(PROG *sp);
 pvStat seq_camonitor(CHAN *ch, boolean on);
+void seq_ctrl_connect(CHAN *ch);
+void seq_ctrl_disconnect(CHAN *ch, DBCHAN *dbch);
+boolean seq_dispatch_start(PROG *sp);
+void seq_dispatch_stop(PROG *sp);
 
 /* seq_prog.c */
 typedef int seqTraversee(PROG *prog, void *param);
@@ -261,6 +339,10 @@ void createOrAttachPvSystem(PROG *sp);
 /* seq_main.c */
 void seq_free(PROG *sp);
 
+/* seq_spill_mmap.c, or seq_spill_none.c where files cannot be mapped */
+void *seqSpillMap(size_t numBytes);
+void seqSpillUnmap(void *addr, size_t numBytes);
+
 /* debug/query support */
 typedef int pr_fun(const char *format,...);
 void print_channel_value(pr_fun *, CHAN *ch, void *val);
@@ -1,7 +1,10 @@
 #ifndef INCLseqStatsh
 #define INCLseqStatsh
 
+#include <stddef.h>
+
 #include "shareLib.h"
+#include "epicsThread.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -13,6 +16,35 @@ epicsShareFunc void seqGatherStats(
     unsigned *num_connected
 );
 
+/* Number of buckets in a queue's residence time histogram. Bucket 0
+   counts elements that stayed in the queue for less than 1 microsecond,
+   bucket i (i>0) those that stayed at least 10^(i-1) but less than 10^i
+   microseconds, and the last bucket all that stayed longer. */
+#define seqQueueNumAgeBuckets 9
+
+/* Statistics for a syncQ queue, including its spill area (if any) */
+typedef struct seqQueueStats {
+    size_t  numElems;       /* capacity in elements */
+    size_t  used;           /* elements currently in the queue */
+    size_t  lost;           /* elements lost since creation */
+    size_t  highWater;      /* maximum number of elements used */
+    int     timed;          /* whether the following are recorded */
+    size_t  removed;        /* elements removed by consumers */
+    double  maxAge;         /* longest residence time in seconds */
+    double  oldestAge;      /* age of the first element now in the
+                               queue in seconds, 0 if empty */
+    size_t  ageHist[seqQueueNumAgeBuckets]; /* residence times */
+} seqQueueStats;
+
+/* Fill in statistics for at most n of the syncQ queues of the state
+   program that the given thread belongs to, and return the number of
+   its queues (0 if there is no such program). */
+epicsShareFunc unsigned seqGatherQueueStats(
+    epicsThreadId tid,
+    seqQueueStats *stats,
+    unsigned n
+);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
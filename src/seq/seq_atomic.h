@@ -0,0 +1,123 @@
+/*************************************************************************\
+Copyright (c) 2010-2015 Helmholtz-Zentrum Berlin f. Materialien
+                        und Energie GmbH, Germany (HZB)
+This file is distributed subject to a Software License Agreement found
+in the file LICENSE that is included with this distribution.
+\*************************************************************************/
+/*************************************************************************\
+Minimal set of atomic operations on size_t used by the lock-free parts
+of the run time system. In order of preference, these are implemented
+with C11 <stdatomic.h>, the GCC/clang __atomic builtins, epicsAtomic.h
+from EPICS base 3.15 and later, or the older GCC __sync builtins.
+
+seqAtomicLoad, seqAtomicStore and seqAtomicCas are sequentially
+consistent; seqAtomicLoadAcq and seqAtomicStoreRel have acquire resp.
+release semantics. seqAtomicCas returns the previous value, so it
+succeeded if the result equals the expected value. seqAtomicAdd
+returns the new value.
+\*************************************************************************/
+#ifndef INCLseq_atomich
+#define INCLseq_atomich
+
+#include <stddef.h>
+
+#include "epicsVersion.h"
+
+/* Assumed size of a cache line, for padding */
+#define SEQ_CACHE_LINE	64
+
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L \
+	&& !defined(__STDC_NO_ATOMICS__)
+
+#include <stdatomic.h>
+
+typedef atomic_size_t seqAtomicSize;
+
+#define seqAtomicInit(p,v)	atomic_init(p,v)
+#define seqAtomicLoad(p)	atomic_load(p)
+#define seqAtomicLoadAcq(p)	atomic_load_explicit(p,memory_order_acquire)
+#define seqAtomicStore(p,v)	atomic_store(p,v)
+#define seqAtomicStoreRel(p,v)	atomic_store_explicit(p,v,memory_order_release)
+#define seqAtomicAdd(p,v)	(atomic_fetch_add(p,v)+(v))
+#define seqAtomicFenceAcq()	atomic_thread_fence(memory_order_acquire)
+
+static inline size_t seqAtomicCas(seqAtomicSize *p, size_t old, size_t new_)
+{
+	atomic_compare_exchange_strong(p, &old, new_);
+	return old;
+}
+
+#elif defined(__GNUC__) && defined(__ATOMIC_SEQ_CST)
+
+typedef size_t seqAtomicSize;
+
+#define seqAtomicInit(p,v)	(*(p)=(v))
+#define seqAtomicLoad(p)	__atomic_load_n(p,__ATOMIC_SEQ_CST)
+#define seqAtomicLoadAcq(p)	__atomic_load_n(p,__ATOMIC_ACQUIRE)
+#define seqAtomicStore(p,v)	__atomic_store_n(p,v,__ATOMIC_SEQ_CST)
+#define seqAtomicStoreRel(p,v)	__atomic_store_n(p,v,__ATOMIC_RELEASE)
+#define seqAtomicAdd(p,v)	__atomic_add_fetch(p,v,__ATOMIC_SEQ_CST)
+#define seqAtomicFenceAcq()	__atomic_thread_fence(__ATOMIC_ACQUIRE)
+
+static __inline__ size_t seqAtomicCas(seqAtomicSize *p, size_t old, size_t new_)
+{
+	__atomic_compare_exchange_n(p, &old, new_, 0,
+		__ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+	return old;
+}
+
+#elif EPICS_VERSION > 3 || (EPICS_VERSION == 3 && EPICS_REVISION >= 15)
+
+#include "epicsAtomic.h"
+
+typedef size_t seqAtomicSize;
+
+#define seqAtomicInit(p,v)	(*(p)=(v))
+#define seqAtomicLoad(p)	seqAtomicLoadBarrier(p)
+#define seqAtomicLoadAcq(p)	seqAtomicLoadBarrier(p)
+#define seqAtomicStore(p,v)	(epicsAtomicWriteMemoryBarrier(),epicsAtomicSetSizeT(p,v),\
+					epicsAtomicReadMemoryBarrier())
+#define seqAtomicStoreRel(p,v)	(epicsAtomicWriteMemoryBarrier(),epicsAtomicSetSizeT(p,v))
+#define seqAtomicAdd(p,v)	epicsAtomicAddSizeT(p,v)
+#define seqAtomicFenceAcq()	epicsAtomicReadMemoryBarrier()
+#define seqAtomicCas(p,o,n)	epicsAtomicCmpAndSwapSizeT(p,o,n)
+
+/* The barrier must follow the load, so that later accesses are not
+   done before it */
+static EPICS_ALWAYS_INLINE size_t seqAtomicLoadBarrier(seqAtomicSize *p)
+{
+	size_t v = epicsAtomicGetSizeT(p);
+
+	epicsAtomicReadMemoryBarrier();
+	return v;
+}
+
+#elif defined(__GNUC__)
+
+typedef size_t seqAtomicSize;
+
+#define seqAtomicInit(p,v)	(*(p)=(v))
+#define seqAtomicLoad(p)	seqAtomicLoadBarrier(p)
+#define seqAtomicLoadAcq(p)	seqAtomicLoadBarrier(p)
+#define seqAtomicStore(p,v)	(__sync_synchronize(),*(volatile size_t *)(p)=(v),\
+					__sync_synchronize())
+#define seqAtomicStoreRel(p,v)	(__sync_synchronize(),*(volatile size_t *)(p)=(v))
+#define seqAtomicAdd(p,v)	__sync_add_and_fetch(p,v)
+#define seqAtomicFenceAcq()	__sync_synchronize()
+#define seqAtomicCas(p,o,n)	__sync_val_compare_and_swap(p,o,n)
+
+/* The barrier must follow the load, so that later accesses are not
+   done before it */
+static __inline__ size_t seqAtomicLoadBarrier(seqAtomicSize *p)
+{
+	size_t v = *(volatile size_t *)p;
+
+	__sync_synchronize();
+	return v;
+}
+
+#else
+#error "no atomic operations available: need C11, GCC, or EPICS base >= 3.15"
+#endif
+
+#endif /* INCLseq_atomich */
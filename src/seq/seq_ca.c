@@ -36,6 +36,7 @@ in the file LICENSE that is included with this distribution.
 static void proc_db_events(
 	pvValue		*value,	/* ptr to value */
 	pvType		type,	/* type of value */
+	unsigned	count,	/* element count of value */
 	CHAN		*ch,	/* channel object */
 	SSCB		*ss,	/* originator, for put and get, else 0 */
 	pvEventType	evtype,	/* put, get, or monitor */
@@ -66,21 +67,17 @@ pvStat seq_connect(PROG *sp, boolean wait)
 		DEBUG("seq_connect: connect %s to %s\n", ch->varName,
 			dbch->dbName);
 		/* Connect to it */
-		status = pvVarCreate(
-				sp->pvSys,		/* PV system context */
-				ch->dbch->dbName,	/* PV name */
-				seq_conn_handler,	/* connection handler routine */
-				seq_event_handler,	/* event handler routine */
-				ch,			/* private data is CHAN struc */
-				&dbch->pvid);		/* ptr to PV id */
+		status = seq_chan_create(ch);
 		if (status != pvStatOK)
 		{
 			errlogSevPrintf(errlogFatal, "seq_connect(var '%s', pv '%s'): pvVarCreate() failure: "
 				"%s\n", ch->varName, dbch->dbName, pvVarGetMess(dbch->pvid));
 			free(ch->dbch->dbName);
+			free(ch->dbch->convBuf);
 			free(ch->dbch);
 			continue;
 		}
+		seq_ctrl_connect(ch);
 	}
 	pvSysFlush(sp->pvSys);
 
@@ -138,6 +135,42 @@ pvStat seq_connect(PROG *sp, boolean wait)
 	return pvStatOK;
 }
 
+/*
+ * Create the pv variable of an assigned channel. The channel's filter
+ * (if any) is appended to the name given to the pv layer only, so that
+ * dbch->dbName (pvName, seqShow, messages) stays as assigned. A record
+ * name without a field gets a "." before the filter, as in "rec.{...}".
+ */
+pvStat seq_chan_create(CHAN *ch)
+{
+	DBCHAN	*dbch = ch->dbch;
+	char	*name = dbch->dbName;
+	pvStat	status;
+
+	if (ch->filter)
+	{
+		name = (char *)malloc(strlen(dbch->dbName) + strlen(ch->filter) + 2);
+		if (!name)
+		{
+			dbch->pvid.msg = "out of memory";
+			return pvStatERROR;
+		}
+		sprintf(name, strchr(dbch->dbName, '.') ? "%s%s" : "%s.%s",
+			dbch->dbName, ch->filter);
+	}
+	status = pvVarCreatePriority(
+			ch->prog->pvSys,	/* PV system context */
+			name,			/* PV name (with filter) */
+			chanPriority(ch),	/* channel priority */
+			seq_conn_handler,	/* connection handler routine */
+			seq_event_handler,	/* event handler routine */
+			ch,			/* private data is CHAN struc */
+			&dbch->pvid);		/* ptr to PV id */
+	if (name != dbch->dbName)
+		free(name);
+	return status;
+}
+
 /*
  * seq_get_handler() - Sequencer callback handler.
  * Called when a "get" completes.
@@ -152,8 +185,8 @@ static void seq_get_handler(
 
 	freeListFree(sp->pvReqPool, arg);
 	/* ignore callback if not expected, e.g. already timed out */
-	if (ss->getReq[chNum(ch)] == rq)
-		proc_db_events(value, type, ch, ss, pvEventGet, status);
+	if (ss->getReq[ssSlot(ss,ch)] == rq)
+		proc_db_events(value, type, count, ch, ss, pvEventGet, status);
 }
 
 /*
@@ -170,8 +203,8 @@ static void seq_put_handler(
 
 	freeListFree(sp->pvReqPool, arg);
 	/* ignore callback if not expected, e.g. already timed out */
-	if (ss->putReq[chNum(ch)] == rq)
-		proc_db_events(value, type, ch, ss, pvEventPut, status);
+	if (ss->putReq[ssSlot(ss,ch)] == rq)
+		proc_db_events(value, type, count, ch, ss, pvEventPut, status);
 }
 
 /*
@@ -183,7 +216,7 @@ static void seq_mon_handler(
 	CHAN	*ch = (CHAN *)arg;
 	PROG	*sp = ch->prog;
 
-	proc_db_events(value, type, ch, 0, pvEventMonitor, status);
+	proc_db_events(value, type, count, ch, 0, pvEventMonitor, status);
 	epicsMutexMustLock(sp->lock);
 	if (ch->dbch && !ch->dbch->gotMonitor)
 	{
@@ -198,10 +231,8 @@ static void seq_mon_handler(
 	epicsMutexUnlock(sp->lock);
 }
 
-/*
- * seq_event_handler() - main CA event handler.
- */
-void seq_event_handler(
+/* Dispatch an event to the handler for its type */
+static void handle_event(
 	pvEventType evt, void *arg, pvType type, unsigned count, pvValue *value, pvStat status)
 {
 	switch (evt)
@@ -218,24 +249,416 @@ void seq_event_handler(
 	}
 }
 
-struct putq_cp_arg {
-	CHAN	*ch;
-	void	*value;
-};
+/*
+ * Event dispatch (program parameter pvdispatch=<size>): instead of
+ * applying an event in the pv callback, which runs on a thread of the
+ * pv system (for CA, while CA holds locks of its own), the callback
+ * copies the value into a pooled buffer, puts a small record into the
+ * program's event queue, and returns. A dispatcher thread takes the
+ * records from the queue in batches and applies them, each batch with
+ * the program lock taken once. The queue is the lock-free one used for
+ * syncQ; the consumer is woken only when the number of pending events
+ * goes up from zero. The buffer pools are freeLists, which take a mutex
+ * of their own for a moment, but the callback never waits for the
+ * dispatcher or the program lock.
+ *
+ * A callback never waits for room in the queue either. Monitor events
+ * may fill the queue up to the given size; if it is full, the event goes
+ * to a per channel slot for the newest value instead, replacing (and
+ * counting as lost) one that is still there. The dispatcher applies the
+ * slots after the queued events; a monitor event is numbered per channel
+ * so that queued events older than an applied slot are dropped. A full
+ * queue thus costs intermediate updates, never the last one. Monitor
+ * callbacks of a channel are not called concurrently, so the numbers of
+ * a channel's events are ordered like the events. The queue has room
+ * beyond that for two
+ * completions (get and put) per channel slot of each state set, which
+ * is as many as can be pending, so that completions are not lost (the
+ * state set would wait until its timeout). Should a completion still
+ * find the queue full, it is applied in the callback.
+ */
+
+/* Event record passed from pv callbacks to the dispatcher */
+typedef struct dispatch_event
+{
+	void		*arg;		/* CHAN for monitors, else PVREQ */
+	unsigned	assignGen;	/* the channel's assignGen when put */
+	size_t		seq;		/* the channel's dispatchSeq (monitors) */
+	pvValue		*value;		/* pooled copy of the value, or NULL */
+	pvType		type;
+	unsigned	count;
+	pvEventType	evtype;
+	pvStat		status;
+} DISPATCH_EVENT;
+
+/* Per channel slot for the newest monitor event that found the queue full */
+typedef struct dispatch_latest
+{
+	DISPATCH_EVENT	ev;
+	boolean		pending;	/* ev is not yet applied */
+	struct dispatch_latest *next;	/* in the program's latestList */
+} DISPATCH_LATEST;
+
+/* Number of records the dispatcher takes from the queue at once */
+#define DISPATCH_BATCH	32
+
+/* Index of the pool for values of the given size,
+   or DISPATCH_NUM_POOLS if it is too large for any pool */
+static unsigned pool_index(size_t size)
+{
+	unsigned n;
+
+	for (n = 0; n < DISPATCH_NUM_POOLS; n++)
+		if (size <= (size_t)1 << (DISPATCH_POOL_MIN + n))
+			break;
+	return n;
+}
+
+static pvValue *value_alloc(PROG *sp, size_t size)
+{
+	unsigned n = pool_index(size);
+
+	if (n < DISPATCH_NUM_POOLS)
+		return (pvValue *)freeListMalloc(sp->dispatchPools[n]);
+	return (pvValue *)malloc(size);
+}
+
+static void value_free(PROG *sp, pvValue *value, size_t size)
+{
+	unsigned n = pool_index(size);
+
+	if (n < DISPATCH_NUM_POOLS)
+		freeListFree(sp->dispatchPools[n], value);
+	else
+		free(value);
+}
+
+/* Channel an event is for */
+static CHAN *event_chan(pvEventType evt, void *arg)
+{
+	return evt == pvEventMonitor ? (CHAN *)arg : ((PVREQ *)arg)->ch;
+}
+
+/* Count an event as pending and wake up the dispatcher if it is the first */
+static void dispatch_wake(PROG *sp)
+{
+	if (seqAtomicAdd(&sp->dispatchPending, 1) == 1)
+		epicsEventSignal(sp->dispatchWake);
+}
+
+/* Put a monitor event that found the queue full into the channel's
+   slot for the newest value; return FALSE if out of memory */
+static boolean dispatch_latest(PROG *sp, const DISPATCH_EVENT *ev)
+{
+	CHAN		*ch = (CHAN *)ev->arg;
+	DISPATCH_LATEST	*latest = NULL;
+	DISPATCH_EVENT	old;
+	boolean		replaced;
+
+	/* the slot is allocated when it is first needed */
+	if (!ch->dispatchLatest)
+	{
+		latest = new(DISPATCH_LATEST);
+		if (!latest)
+			return FALSE;
+	}
+	epicsMutexMustLock(sp->latestLock);
+	if (!ch->dispatchLatest)
+		ch->dispatchLatest = latest;
+	else if (latest)
+		free(latest);
+	latest = ch->dispatchLatest;
+	old = latest->ev;
+	replaced = latest->pending;
+	latest->ev = *ev;
+	if (!replaced)
+	{
+		latest->pending = TRUE;
+		latest->next = sp->latestList;
+		sp->latestList = latest;
+	}
+	epicsMutexUnlock(sp->latestLock);
+	if (replaced)
+	{
+		if (old.value)
+			value_free(sp, old.value, pv_size_n(old.type, old.count));
+		seqAtomicAdd(&sp->dispatchLost, 1);
+	}
+	else
+		dispatch_wake(sp);
+	return TRUE;
+}
+
+/* Put an event into the dispatch queue; return FALSE if it must be
+   applied in the callback, i.e. out of memory, or a completion and
+   the queue is full */
+static boolean dispatch_put(PROG *sp,
+	pvEventType evt, void *arg, pvType type, unsigned count, pvValue *value, pvStat status)
+{
+	CHAN		*ch = event_chan(evt, arg);
+	DISPATCH_EVENT	*ev = NULL;
+	DISPATCH_EVENT	mon;
+	pvValue		*copy = NULL;
+	size_t		size = value ? pv_size_n(type, count) : 0;
+
+	if (value)
+	{
+		copy = value_alloc(sp, size);
+		if (!copy)
+			return FALSE;
+		memcpy(copy, value, size);
+	}
+	/* the room beyond dispatchSize is for completions */
+	if (evt != pvEventMonitor || seqQueueUsed(sp->dispatchQueue) < sp->dispatchSize)
+		ev = (DISPATCH_EVENT *)seqQueueReserve(sp->dispatchQueue, sizeof(DISPATCH_EVENT));
+	if (!ev)
+	{
+		if (evt == pvEventMonitor)
+			ev = &mon;
+		else
+		{
+			if (copy)
+				value_free(sp, copy, size);
+			return FALSE;
+		}
+	}
+	ev->arg = arg;
+	/* no lock needed: pvAssign changes it only after pvVarDestroy
+	   has waited for the callbacks of the old pv to finish */
+	ev->assignGen = ch->assignGen;
+	ev->seq = evt == pvEventMonitor ? seqAtomicAdd(&ch->dispatchSeq, 1) : 0;
+	ev->value = copy;
+	ev->type = type;
+	ev->count = count;
+	ev->evtype = evt;
+	ev->status = status;
+	if (ev == &mon)
+	{
+		if (dispatch_latest(sp, &mon))
+			return TRUE;
+		if (copy)
+			value_free(sp, copy, size);
+		return FALSE;
+	}
+	seqQueueCommit(sp->dispatchQueue, ev, sizeof(DISPATCH_EVENT));
+	dispatch_wake(sp);
+	return TRUE;
+}
+
+/* Apply an event taken from the queue or a slot; sp->lock must be held */
+static void dispatch_apply(PROG *sp, DISPATCH_EVENT *ev)
+{
+	CHAN *ch = event_chan(ev->evtype, ev->arg);
+
+	/* drop events for the pv a channel was assigned to before a
+	   pvAssign, the way pvVarDestroy drops them when there is no
+	   dispatcher, and monitor events older than one already applied */
+	if (ev->assignGen != ch->assignGen)
+	{
+		if (ev->evtype != pvEventMonitor)
+			freeListFree(sp->pvReqPool, ev->arg);
+	}
+	else if (ev->evtype != pvEventMonitor)
+		handle_event(ev->evtype, ev->arg, ev->type, ev->count,
+			ev->value, ev->status);
+	else if ((ptrdiff_t)(ev->seq - ch->dispatchApplied) > 0)
+	{
+		ch->dispatchApplied = ev->seq;
+		handle_event(ev->evtype, ev->arg, ev->type, ev->count,
+			ev->value, ev->status);
+	}
+	if (ev->value)
+		value_free(sp, ev->value, pv_size_n(ev->type, ev->count));
+}
+
+/* Take a pending slot off the list, if there is one */
+static boolean dispatch_take_latest(PROG *sp, DISPATCH_EVENT *ev)
+{
+	DISPATCH_LATEST *latest;
+
+	epicsMutexMustLock(sp->latestLock);
+	latest = sp->latestList;
+	if (latest)
+	{
+		sp->latestList = latest->next;
+		latest->pending = FALSE;
+		*ev = latest->ev;
+	}
+	epicsMutexUnlock(sp->latestLock);
+	return latest != NULL;
+}
+
+/* Dispatcher thread: apply events until told to exit */
+static void dispatcher(void *arg)
+{
+	PROG		*sp = (PROG *)arg;
+	DISPATCH_EVENT	batch[DISPATCH_BATCH];
+	size_t		reported = 0;
+	double		timeReported = 0;
+
+	for (;;)
+	{
+		size_t n, lost;
+
+		epicsEventMustWait(sp->dispatchWake);
+		do {
+			size_t i;
+			DISPATCH_EVENT ev;
+
+			n = seqQueueGetBatch(sp->dispatchQueue, batch, DISPATCH_BATCH);
+			epicsMutexMustLock(sp->lock);
+			for (i = 0; i < n; i++)
+				dispatch_apply(sp, batch + i);
+			/* slots hold events newer than the queued ones
+			   of their channels */
+			while (dispatch_take_latest(sp, &ev))
+			{
+				dispatch_apply(sp, &ev);
+				n++;
+			}
+			epicsMutexUnlock(sp->lock);
+			if (n == 0)
+			{
+				/* a callback has put an event but not yet counted it */
+				epicsThreadSleep(0.0);
+				continue;
+			}
+		} while (seqAtomicAdd(&sp->dispatchPending, (size_t)0 - n) != 0);
+		/* report lost events here, not in the callbacks */
+		lost = seqAtomicLoad(&sp->dispatchLost);
+		if (lost != reported)
+		{
+			double timeNow;
+
+			pvTimeGetCurrentDouble(&timeNow);
+			if (timeNow - timeReported >= QUEUE_LOSS_REPORT_INTERVAL)
+			{
+				errlogSevPrintf(errlogMinor,
+					"%s[%d]: %u monitor event(s) replaced by newer ones "
+					"(dispatch queue is full)\n",
+					sp->progName, sp->instance, (unsigned)(lost - reported));
+				reported = lost;
+				timeReported = timeNow;
+			}
+		}
+		if (sp->dispatchQuit)
+			break;
+	}
+	epicsEventSignal(sp->dispatchDead);
+}
+
+/*
+ * seq_dispatch_start() - Create the event queue and start the dispatcher,
+ * if the program has an event dispatch queue size. Must be called before
+ * channels are connected.
+ */
+boolean seq_dispatch_start(PROG *sp)
+{
+	char		threadName[THREAD_NAME_SIZE+10];
+	unsigned	n, numCompletions = 0;
+
+	if (!sp->dispatchSize)
+		return TRUE;
+	/* room for the completions that can be pending, see dispatch_put */
+	for (n = 0; n < sp->numSS; n++)
+		numCompletions += 2 * sp->ss[n].numSlots;
+	sp->dispatchQueue = seqQueueCreatePolicy(sp->dispatchSize + numCompletions,
+		sizeof(DISPATCH_EVENT), 0, QP_DROP_NEWEST);
+	if (!sp->dispatchQueue)
+	{
+		errlogSevPrintf(errlogFatal, "seq_dispatch_start: seqQueueCreate failed\n");
+		return FALSE;
+	}
+	seqAtomicInit(&sp->dispatchPending, 0);
+	seqAtomicInit(&sp->dispatchLost, 0);
+	sp->latestLock = epicsMutexCreate();
+	if (!sp->latestLock)
+	{
+		errlogSevPrintf(errlogFatal, "seq_dispatch_start: epicsMutexCreate failed\n");
+		return FALSE;
+	}
+	for (n = 0; n < DISPATCH_NUM_POOLS; n++)
+	{
+		size_t size = (size_t)1 << (DISPATCH_POOL_MIN + n);
+
+		/* allocate about 64kB at a time */
+		freeListInitPvt(&sp->dispatchPools[n], (int)size,
+			(int)max(65536 / size, 1));
+		if (!sp->dispatchPools[n])
+		{
+			errlogSevPrintf(errlogFatal, "seq_dispatch_start: freeListInitPvt failed\n");
+			return FALSE;
+		}
+	}
+	sp->dispatchWake = epicsEventCreate(epicsEventEmpty);
+	sp->dispatchDead = epicsEventCreate(epicsEventEmpty);
+	if (!sp->dispatchWake || !sp->dispatchDead)
+	{
+		errlogSevPrintf(errlogFatal, "seq_dispatch_start: epicsEventCreate failed\n");
+		return FALSE;
+	}
+	epicsThreadGetName(epicsThreadGetIdSelf(), threadName, THREAD_NAME_SIZE);
+	strcat(threadName, "_dispatch");
+	if (!epicsThreadCreate(threadName, sp->threadPriority, sp->stackSize,
+		dispatcher, sp))
+	{
+		errlogSevPrintf(errlogFatal, "seq_dispatch_start: epicsThreadCreate failed\n");
+		epicsEventDestroy(sp->dispatchDead);
+		sp->dispatchDead = NULL;
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/*
+ * seq_dispatch_stop() - Apply the remaining events, stop the dispatcher,
+ * and free the event queue. Must be called after channels have been
+ * disconnected, so that no more events come in.
+ */
+void seq_dispatch_stop(PROG *sp)
+{
+	unsigned n;
 
-static void *putq_cp(void *dest, const void *src, size_t elemSize)
+	if (sp->dispatchDead)
+	{
+		sp->dispatchQuit = TRUE;
+		epicsEventSignal(sp->dispatchWake);
+		epicsEventMustWait(sp->dispatchDead);
+		epicsEventDestroy(sp->dispatchDead);
+	}
+	if (sp->dispatchWake)
+		epicsEventDestroy(sp->dispatchWake);
+	if (sp->latestLock)
+		epicsMutexDestroy(sp->latestLock);
+	for (n = 0; n < sp->numChans; n++)
+		free(sp->chan[n].dispatchLatest);
+	for (n = 0; n < DISPATCH_NUM_POOLS; n++)
+		if (sp->dispatchPools[n])
+			freeListCleanup(sp->dispatchPools[n]);
+	if (sp->dispatchQueue)
+		seqQueueDestroy(sp->dispatchQueue);
+	sp->dispatchQueue = NULL;
+}
+
+/*
+ * seq_event_handler() - main CA event handler.
+ */
+void seq_event_handler(
+	pvEventType evt, void *arg, pvType type, unsigned count, pvValue *value, pvStat status)
 {
-	struct putq_cp_arg *arg = (struct putq_cp_arg *)src;
-	CHAN *ch = arg->ch;
+	PROG *sp = event_chan(evt, arg)->prog;
 
-	return memcpy(dest, arg->value,
-		pv_size_n(ch->type->getType, ch->dbch->dbCount));
+	/* fall back to applying the event here, see dispatch_put */
+	if (sp->dispatchQueue && dispatch_put(sp, evt, arg, type, count, value, status))
+		return;
+	handle_event(evt, arg, type, count, value, status);
 }
 
 /* Common code for completion and monitor handling */
 static void proc_db_events(
 	pvValue		*value,
 	pvType		type,
+	unsigned	count,
 	CHAN		*ch,
 	SSCB		*ss,
 	pvEventType	evtype,
@@ -255,25 +678,53 @@ static void proc_db_events(
 	DEBUG("proc_db_events: var=%s, pv=%s, type=%s, status=%d\n", ch->varName,
 		ch->dbch->dbName, event_type_name[evtype], status);
 
+	/* a dynamic monitor delivers as many elements as the server
+	   currently has, which can be fewer (or more) than dbCount */
+	count = min(count, ch->dbch->dbCount);
+
+	/* native type requested, convert to the variable's type */
+	if (value != NULL && type != ch->type->getType)
+	{
+		if (!ch->dbch->convBuf || pvConvert(ch->type->getType,
+			ch->dbch->convBuf, type, value, count) != pvStatOK)
+		{
+			errlogSevPrintf(errlogMajor,
+				"%s event for variable '%s' (pv '%s'): cannot convert type %d\n",
+				event_type_name[evtype], ch->varName, ch->dbch->dbName, type);
+			value = NULL;
+		}
+		else
+		{
+			value = ch->dbch->convBuf;
+			type = ch->type->getType;
+		}
+	}
+
 	/* monitor on var queued via syncQ */
-	if (ch->queue && evtype == pvEventMonitor)
+	if (ch->queue && evtype == pvEventMonitor && value != NULL)
 	{
 		boolean	full;
-		struct putq_cp_arg arg = {ch, value};
+		/* Size of the message as received; only queues for
+		   elements of varying size store less than the maximum */
+		size_t	size = pv_size_n(type, count);
 
 		DEBUG("proc_db_events: var=%s, pv=%s, queue=%p, used(max)=%d(%d)\n",
 			ch->varName, ch->dbch->dbName,
 			ch->queue, seqQueueUsed(ch->queue), seqQueueNumElems(ch->queue));
-		/* Copy whole message into queue; no need to lock against other
-		   writers, because named and anonymous PVs are disjoint. */
-		full = seqQueuePutF(ch->queue, putq_cp, &arg);
+		/* Copy whole message into queue; no need to lock, the
+		   queue supports concurrent writers. */
+		full = seqQueuePutN(ch->queue, memcpy, value, size);
 		if (full)
 		{
-			errlogSevPrintf(errlogMinor,
-			  "monitor event for variable '%s' (pv '%s'): "
-			  "last queue element overwritten (queue is full)\n",
-			  ch->varName, ch->dbch->dbName
-			);
+			size_t lost = seqQueueReportLost(ch->queue,
+				QUEUE_LOSS_REPORT_INTERVAL);
+
+			if (lost)
+				errlogSevPrintf(errlogMinor,
+				  "monitor event for variable '%s' (pv '%s'): "
+				  "%u queue element(s) lost (queue is full)\n",
+				  ch->varName, ch->dbch->dbName, (unsigned)lost
+				);
 		}
 	}
 	else if (value != NULL)
@@ -289,6 +740,7 @@ static void proc_db_events(
 		meta.status = pv_status(value,type);
 		meta.severity = pv_severity(value,type);
 		meta.message = NULL;
+		meta.count = count;
 
 		/* Set error message only when severity indicates error */
 		if (meta.severity != pvSevrNONE)
@@ -307,11 +759,11 @@ static void proc_db_events(
 	switch (evtype)
 	{
 	case pvEventPut:
-		ss->putReq[chNum(ch)] = NULL;
+		ss->putReq[ssSlot(ss,ch)] = NULL;
 		epicsEventSignal(ss->syncSem);
 		break;
 	case pvEventGet:
-		ss->getReq[chNum(ch)] = NULL;
+		ss->getReq[ssSlot(ss,ch)] = NULL;
 		epicsEventSignal(ss->syncSem);
 		if (optTest(sp, OPT_SAFE))
 			break;
@@ -354,6 +806,7 @@ void seq_disconnect(PROG *sp)
 		/* Note: must unlock around pvVarDestroy to avoid deadlock
 		   with pending callbacks. */
 		status = pvVarDestroy(&dbch->pvid);
+		seq_ctrl_disconnect(ch, dbch);
 		epicsMutexMustLock(sp->lock);
 		if (status != pvStatOK)
 			errlogSevPrintf(errlogFatal, "seq_disconnect(var '%s', pv '%s'): pvVarDestroy() failure: "
@@ -370,6 +823,7 @@ pvStat seq_camonitor(CHAN *ch, boolean turn_on)
 	PROG	*sp = ch->prog;
 	pvStat	status;
 	boolean	done;
+	pvType	type;
 
 	assert(ch);
 
@@ -378,6 +832,7 @@ pvStat seq_camonitor(CHAN *ch, boolean turn_on)
 	assert(dbch);
 	done = turn_on == pvMonIsDefined(dbch->pvid);
 	dbch->gotMonitor = FALSE;
+	type = dbch->reqType;
 	epicsMutexUnlock(sp->lock);
 
 	if (done)
@@ -386,10 +841,12 @@ pvStat seq_camonitor(CHAN *ch, boolean turn_on)
 	DEBUG("calling pvVarMonitor%s(%p)\n", turn_on ? "On" : "Off", ch);
 	if (turn_on)
 	{
-		status = pvVarMonitorOn(
+		status = pvVarMonitorOnMask(
 				&dbch->pvid,		/* pvid */
-				ch->type->getType,	/* requested type */
-				ch->count,		/* element count */
+				type,			/* requested type */
+				/* element count (0=as many as the server has) */
+				ch->monitorDynamic ? 0 : ch->count,
+				ch->monitorMask,	/* events (0=default) */
 				ch);			/* user arg (channel struct) */
 	}
 	else
@@ -405,6 +862,33 @@ pvStat seq_camonitor(CHAN *ch, boolean turn_on)
 	return status;
 }
 
+/*
+ * req_type() - Type to request for gets and monitors of a channel that
+ * has just connected: the variable's type, or with pvtype=native the
+ * channel's native type, if that differs and is numeric. Values of the
+ * native type are converted in proc_db_events, which needs a buffer.
+ */
+static pvType req_type(CHAN *ch)
+{
+	DBCHAN	*dbch = ch->dbch;
+	pvType	type = ch->type->getType;
+	pvType	native;
+
+	if (!ch->prog->nativeType || pv_simple_type(type) == pvTypeSTRING)
+		return type;
+	native = pvVarGetType(&dbch->pvid);
+	if (!pv_is_simple_type(native) || native == pvTypeSTRING
+		|| native == pv_simple_type(type))
+		return type;
+	if (!dbch->convBuf)
+	{
+		dbch->convBuf = newArray(char, pv_size_n(type, ch->count));
+		if (!dbch->convBuf)
+			return type;
+	}
+	return pv_time_type(native);
+}
+
 /*
  * seq_conn_handler() - Sequencer connection handler.
  * Called each time a connection is established or broken.
@@ -442,9 +926,10 @@ void seq_conn_handler(int connected, void *arg)
 			for (nss = 0; nss < sp->numSS; nss++)
 			{
 				SSCB *ss = sp->ss + nss;
+				ptrdiff_t slot = ssSlot(ss,ch);
 
-				ss->getReq[chNum(ch)] = NULL;
-				ss->putReq[chNum(ch)] = NULL;
+				ss->getReq[slot] = NULL;
+				ss->putReq[slot] = NULL;
 				epicsEventSignal(ss->syncSem);
 			}
 		}
@@ -473,6 +958,7 @@ void seq_conn_handler(int connected, void *arg)
 			dbCount = pvVarGetCount(&dbch->pvid);
 			assert(dbCount >= 0);
 			dbch->dbCount = min(ch->count, (unsigned)dbCount);
+			dbch->reqType = req_type(ch);
 
 			if (ch->monitored)
 			{
@@ -496,3 +982,89 @@ void seq_conn_handler(int connected, void *arg)
 	   that such conditions get checked whenever these counts change. */
 	ss_wakeup(sp, 0);
 }
+
+/*
+ * Control information (units, precision, limits, enum strings) of
+ * channels that use pvUnits etc.: a second pv variable for the same
+ * channel monitors it with pvMonitorProperty, so it arrives once after
+ * connecting and again when it changes; the event handler copies it
+ * into a cache from which the builtins read without a round trip.
+ * With sharing (pvsys=<backend>:share) both use the same channel of the
+ * backend.
+ */
+static void seq_ctrl_conn_handler(int connected, void *arg)
+{
+	CHAN	*ch = (CHAN *)arg;
+	PROG	*sp = ch->prog;
+	DBCHAN	*dbch;
+
+	epicsMutexMustLock(sp->lock);
+	dbch = ch->dbch;
+	/* the monitor stays on across reconnects */
+	if (connected && dbch && !pvMonIsDefined(dbch->ctrlid)
+		&& pvVarMonitorOnMask(&dbch->ctrlid, pvTypeCTRL, 1,
+			pvMonitorProperty, ch) != pvStatOK)
+	{
+		errlogSevPrintf(errlogMinor, "seq_ctrl_conn_handler(var '%s', pv '%s'): "
+			"pvVarMonitorOn() failure: %s\n", ch->varName, dbch->dbName,
+			pvVarGetMess(dbch->ctrlid));
+	}
+	epicsMutexUnlock(sp->lock);
+}
+
+static void seq_ctrl_event_handler(
+	pvEventType evt, void *arg, pvType type, unsigned count, pvValue *value, pvStat status)
+{
+	CHAN	*ch = (CHAN *)arg;
+	PROG	*sp = ch->prog;
+	DBCHAN	*dbch;
+
+	if (evt != pvEventMonitor || type != pvTypeCTRL || !value || status != pvStatOK)
+		return;
+	epicsMutexMustLock(sp->lock);
+	dbch = ch->dbch;
+	if (dbch && !dbch->ctrl)
+		dbch->ctrl = new(pvCtrl);
+	if (dbch && dbch->ctrl)
+		memcpy(dbch->ctrl, value, sizeof(pvCtrl));
+	epicsMutexUnlock(sp->lock);
+
+	/* conditions may use pvUnits etc., as with pvConnectCount */
+	ss_wakeup(sp, 0);
+}
+
+/* Create the variable for control information, if the channel needs it */
+void seq_ctrl_connect(CHAN *ch)
+{
+	DBCHAN	*dbch = ch->dbch;
+
+	if (!ch->ctrl || !dbch)
+		return;
+	if (pvVarCreatePriority(
+			ch->prog->pvSys,	/* PV system context */
+			dbch->dbName,		/* PV name */
+			chanPriority(ch),	/* channel priority */
+			seq_ctrl_conn_handler,	/* connection handler routine */
+			seq_ctrl_event_handler,	/* event handler routine */
+			ch,			/* private data is CHAN struc */
+			&dbch->ctrlid) != pvStatOK)
+	{
+		/* not fatal, the builtins return defaults */
+		errlogSevPrintf(errlogMinor, "seq_ctrl_connect(var '%s', pv '%s'): "
+			"pvVarCreate() failure: %s\n", ch->varName, dbch->dbName,
+			pvVarGetMess(dbch->ctrlid));
+		dbch->ctrlid = nullPvVar;
+	}
+}
+
+/* Destroy the variable for control information; must be called without
+   the program lock, like pvVarDestroy for the channel itself */
+void seq_ctrl_disconnect(CHAN *ch, DBCHAN *dbch)
+{
+	if (pvVarIsDefined(dbch->ctrlid) && pvVarDestroy(&dbch->ctrlid) != pvStatOK)
+	{
+		errlogSevPrintf(errlogMinor, "seq_ctrl_disconnect(var '%s', pv '%s'): "
+			"pvVarDestroy() failure: %s\n", ch->varName, dbch->dbName,
+			pvVarGetMess(dbch->ctrlid));
+	}
+}
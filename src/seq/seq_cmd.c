@@ -25,12 +25,19 @@ struct sequencerProgram {
     struct sequencerProgram *next;
 };
 
+/* One pv system per backend specification (program parameter "pvsys") */
+struct pvSystemEntry {
+    char *spec;
+    pvSystem pvSys;
+    struct pvSystemEntry *next;
+};
+
 /* These are the only global variables in the whole seq library. */
 static struct
 {
     epicsMutexId lock;
     struct sequencerProgram *programs;
-    pvSystem pvSys;
+    struct pvSystemEntry *pvSystems;
 } globals;
 
 static void seqInitPvt(void *arg)
@@ -50,17 +57,39 @@ static void seqLazyInit()
 
 void createOrAttachPvSystem(struct program_instance *sp)
 {
+    struct pvSystemEntry *entry;
+    const char *spec = seqMacValGet(sp, "pvsys");
+
+    if (!spec || !spec[0])
+        spec = "ca";
     seqLazyInit();
     epicsMutexMustLock(globals.lock);
-    if (!pvSysIsDefined(globals.pvSys)) {
-        pvStat status = pvSysCreate(&globals.pvSys);
-        if (status != pvStatOK) {
-            errlogPrintf("getPvSystem: pvSysCreate() failure\n");
+    foreach(entry, globals.pvSystems) {
+        if (strcmp(entry->spec, spec) == 0)
+            break;
+    }
+    if (!entry) {
+        pvSystem pvSys;
+
+        if (pvSysCreateBackend(&pvSys, spec) != pvStatOK) {
+            errlogPrintf("getPvSystem: pvSysCreateBackend(\"%s\") failure\n", spec);
+            sp->pvSys = nullPvSys;
+            epicsMutexUnlock(globals.lock);
+            return;
         }
+        entry = (struct pvSystemEntry *)malloc(sizeof *entry);
+        if (!entry) {
+            errlogSevPrintf(errlogFatal, "createOrAttachPvSystem: out of memory\n");
+            exit(EXIT_FAILURE);
+        }
+        entry->spec = epicsStrDup(spec);
+        entry->pvSys = pvSys;
+        entry->next = globals.pvSystems;
+        globals.pvSystems = entry;
     } else {
-        pvSysAttach(globals.pvSys);
+        pvSysAttach(entry->pvSys);
     }
-    sp->pvSys = globals.pvSys;
+    sp->pvSys = entry->pvSys;
     epicsMutexUnlock(globals.lock);
 }
 
@@ -195,6 +224,23 @@ static void seqQueueShowCallFunc(const iocshArgBuf *args)
     }
 }
 
+/* seqMemShow */
+static const iocshArg seqMemShowArg0 = { "program/threadID",iocshArgString};
+static const iocshArg * const seqMemShowArgs[1] = {&seqMemShowArg0};
+static const iocshFuncDef seqMemShowFuncDef = {"seqMemShow",1,seqMemShowArgs};
+static void seqMemShowCallFunc(const iocshArgBuf *args)
+{
+    epicsThreadId id;
+    char *name = args[0].sval;
+
+    if ((name != NULL) && ((id = findThread(name)) != NULL))
+        seqMemShow(id);
+    else {
+        printf("No sequencer task specified.\n");
+        seqShow(NULL);
+    }
+}
+
 /* seqStop */
 static const iocshArg seqStopArg0 = { "program/threadID",iocshArgString};
 static const iocshArg * const seqStopArgs[1] = {&seqStopArg0};
@@ -252,6 +298,7 @@ epicsShareFunc void seqRegisterSequencerCommands(void)
         iocshRegister(&seqFuncDef,seqCallFunc);
         iocshRegister(&seqShowFuncDef,seqShowCallFunc);
         iocshRegister(&seqQueueShowFuncDef,seqQueueShowCallFunc);
+        iocshRegister(&seqMemShowFuncDef,seqMemShowCallFunc);
         iocshRegister(&seqStopFuncDef,seqStopCallFunc);
         iocshRegister(&seqChanShowFuncDef,seqChanShowCallFunc);
         iocshRegister(&seqcarFuncDef,seqcarCallFunc);
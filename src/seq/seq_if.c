@@ -189,6 +189,15 @@ epicsShareFunc pvStat seq_pvGetTmo(SS_ID ss, CH_ID chId, enum compType compType,
 	PVREQ		*req;
 	DBCHAN		*dbch = ch->dbch;
 	PVMETA		*meta = metaPtr(ch,ss);
+	PVREQ		**pending = ss->getReq + ssSlot(ss,ch);
+
+	if (isSpareSlot(ss, pending - ss->getReq))
+	{
+		errlogSevPrintf(errlogMajor,
+			"pvGet(%s): user error (not used by state set %s)\n",
+			ch->varName, ss->ssName);
+		return pvStatERROR;
+	}
 
 	/* Anonymous PV and safe mode, just copy from shared buffer.
 	   Note that completion is always immediate, so no distinction
@@ -214,7 +223,7 @@ epicsShareFunc pvStat seq_pvGetTmo(SS_ID ss, CH_ID chId, enum compType compType,
 		compType = optTest(sp, OPT_ASYNC) ? ASYNC : SYNC;
 	}
 
-	status = check_pending(pvEventGet, ss, ss->getReq + chId, ch->varName,
+	status = check_pending(pvEventGet, ss, pending, ch->varName,
 		dbch, meta, compType, tmo);
 	if (status != pvStatOK)
 		return status;
@@ -224,14 +233,14 @@ epicsShareFunc pvStat seq_pvGetTmo(SS_ID ss, CH_ID chId, enum compType compType,
 	req->ss = ss;
 	req->ch = ch;
 
-	assert(ss->getReq[chId] == NULL);
-	ss->getReq[chId] = req;
+	assert(*pending == NULL);
+	*pending = req;
 
 	/* Perform the PV get operation with a callback routine specified.
 	   Requesting more than db channel has available is ok. */
 	status = pvVarGetCallback(
 			&dbch->pvid,		/* PV id */
-			ch->type->getType,	/* request type */
+			dbch->reqType,		/* request type */
 			dbch->dbCount,		/* element count */
 			req);			/* user arg */
 	if (status != pvStatOK)
@@ -240,7 +249,7 @@ epicsShareFunc pvStat seq_pvGetTmo(SS_ID ss, CH_ID chId, enum compType compType,
 		errlogSevPrintf(errlogFatal,
 			"pvGet(var %s, pv %s): pvVarGetCallback() failure: %s\n",
 			ch->varName, dbch->dbName, pvVarGetMess(dbch->pvid));
-		ss->getReq[chId] = NULL;	/* cancel the request */
+		*pending = NULL;	/* cancel the request */
 		freeListFree(sp->pvReqPool, req);
 		check_connected(dbch, meta);
 		return status;
@@ -250,7 +259,7 @@ epicsShareFunc pvStat seq_pvGetTmo(SS_ID ss, CH_ID chId, enum compType compType,
 	if (compType == SYNC)
 	{
 		pvSysFlush(sp->pvSys);
-		status = wait_complete(pvEventGet, ss, ss->getReq + chId, dbch, meta, tmo);
+		status = wait_complete(pvEventGet, ss, pending, dbch, meta, tmo);
 		if (status != pvStatOK)
 			return status;
 		if (optTest(sp, OPT_SAFE))
@@ -281,7 +290,7 @@ epicsShareFunc boolean seq_pvGetComplete(
 				ch->varName);
 		return TRUE;
 	}
-	else if (!ss->getReq[chId])
+	else if (!ss->getReq[ssSlot(ss,ch)])
 	{
 		pvStat status = check_connected(ch->dbch, metaPtr(ch,ss));
 		if (status == pvStatOK && optTest(sp, OPT_SAFE))
@@ -351,7 +360,7 @@ epicsShareFunc void seq_pvGetCancel(
 	}
 	else
 	{
-		ss->getReq[chId] = NULL;	/* cancel the request */
+		ss->getReq[ssSlot(ss,ch)] = NULL;	/* cancel the request */
 	}
 }
 
@@ -401,22 +410,22 @@ static void anonymous_put(SS_ID ss, CHAN *ch)
 			type, size, ch->count, pv_size_n(type, ch->count), queue);
 		print_channel_value(DEBUG, ch, var);
 
-		/* Note: Must lock here because multiple state sets can issue
-		   pvPut calls concurrently. OTOH, no need to lock against CA
-		   callbacks, because anonymous and named PVs are disjoint. */
-		epicsMutexMustLock(ch->varLock);
-
+		/* Note: no need to lock, even though multiple state sets
+		   can issue pvPut calls concurrently, since the queue
+		   supports concurrent writers. */
 		full = seqQueuePutF(queue, putq_cp, &arg);
 		if (full)
 		{
-			errlogSevPrintf(errlogMinor,
-			  "pvPut on queued channel '%s' (anonymous): "
-			  "last queue element overwritten (queue is full)\n",
-			  ch->varName
-			);
+			size_t lost = seqQueueReportLost(queue,
+				QUEUE_LOSS_REPORT_INTERVAL);
+
+			if (lost)
+				errlogSevPrintf(errlogMinor,
+				  "pvPut on queued channel '%s' (anonymous): "
+				  "%u queue element(s) lost (queue is full)\n",
+				  ch->varName, (unsigned)lost
+				);
 		}
-
-		epicsMutexUnlock(ch->varLock);
 	}
 	else
 	{
@@ -451,9 +460,18 @@ epicsShareFunc pvStat seq_pvPutTmo(SS_ID ss, CH_ID chId, enum compType compType,
 	PVREQ	*req;
 	DBCHAN	*dbch = ch->dbch;
 	PVMETA	*meta = metaPtr(ch,ss);
+	PVREQ	**pending = ss->putReq + ssSlot(ss,ch);
 
 	DEBUG("pvPut: pv name=%s, var=%p\n", dbch ? dbch->dbName : "<anonymous>", var);
 
+	if (isSpareSlot(ss, pending - ss->putReq))
+	{
+		errlogSevPrintf(errlogMajor,
+			"pvPut(%s): user error (not used by state set %s)\n",
+			ch->varName, ss->ssName);
+		return pvStatERROR;
+	}
+
 	/* First handle anonymous PV (safe mode only) */
 	if (optTest(sp, OPT_SAFE) && !dbch)
 	{
@@ -476,7 +494,7 @@ epicsShareFunc pvStat seq_pvPutTmo(SS_ID ss, CH_ID chId, enum compType compType,
 	/* Determine whether to perform synchronous, asynchronous, or
 	   plain put ((+a) option was never honored for put, so DEFAULT
 	   means fire-and-forget) */
-	status = check_pending(pvEventPut, ss, ss->putReq + chId, ch->varName,
+	status = check_pending(pvEventPut, ss, pending, ch->varName,
 		dbch, meta, compType, tmo);
 	if (status != pvStatOK)
 		return status;
@@ -509,8 +527,8 @@ epicsShareFunc pvStat seq_pvPutTmo(SS_ID ss, CH_ID chId, enum compType compType,
 		req->ss = ss;
 		req->ch = ch;
 
-		assert(ss->putReq[chId] == NULL);
-		ss->putReq[chId] = req;
+		assert(*pending == NULL);
+		*pending = req;
 
 		status = pvVarPutCallback(
 				&dbch->pvid,		/* PV id */
@@ -523,7 +541,7 @@ epicsShareFunc pvStat seq_pvPutTmo(SS_ID ss, CH_ID chId, enum compType compType,
 			pv_call_failure(dbch, meta, status);
 			errlogSevPrintf(errlogFatal, "pvPut(var %s, pv %s): pvVarPutCallback() failure: %s\n",
 				ch->varName, dbch->dbName, pvVarGetMess(dbch->pvid));
-			ss->putReq[chId] = NULL;	/* cancel the request */
+			*pending = NULL;	/* cancel the request */
 			freeListFree(sp->pvReqPool, req);
 			check_connected(dbch, meta);
 			return status;
@@ -532,7 +550,7 @@ epicsShareFunc pvStat seq_pvPutTmo(SS_ID ss, CH_ID chId, enum compType compType,
 		if (compType == SYNC)			/* wait for completion */
 		{
 			pvSysFlush(sp->pvSys);
-			status = wait_complete(pvEventPut, ss, ss->putReq + chId, dbch, meta, tmo);
+			status = wait_complete(pvEventPut, ss, pending, dbch, meta, tmo);
 			if (status != pvStatOK)
 				return status;
 		}
@@ -572,7 +590,7 @@ static boolean seq_pvSinglePutComplete(
 				ch->varName);
 		return TRUE;
 	}
-	else if (!ss->putReq[chId])
+	else if (!ss->putReq[ssSlot(ss,ch)])
 	{
 		check_connected(ch->dbch, metaPtr(ch,ss));
 		return TRUE;
@@ -636,7 +654,7 @@ epicsShareFunc void seq_pvPutCancel(
 	}
 	else
 	{
-		ss->putReq[chId] = NULL;	/* cancel the request */
+		ss->putReq[ssSlot(ss,ch)] = NULL;	/* cancel the request */
 	}
 }
 
@@ -696,9 +714,13 @@ epicsShareFunc pvStat seq_pvAssign(SS_ID ss, CH_ID chId, const char *pvName)
 		epicsMutexUnlock(sp->lock);
 
 		status = pvVarDestroy(&dbch->pvid);
+		seq_ctrl_disconnect(ch, dbch);
 
 		epicsMutexMustLock(sp->lock);
 
+		/* events of the old pv that are still in the dispatch
+		   queue are now stale, see seq_ca.c */
+		ch->assignGen++;
 		sp->assignCount--;
 
 		if (dbch->connected)	/* see connection handler */
@@ -722,12 +744,17 @@ epicsShareFunc pvStat seq_pvAssign(SS_ID ss, CH_ID chId, const char *pvName)
 		}
 
 		free(dbch->dbName);
+		/* the new PV may have other units etc.; the builtins and
+		   the ctrl event handler test the pointer */
+		free(dbch->ctrl);
+		dbch->ctrl = NULL;
 	}
 
 	if (pvName[0] == 0)	/* new name is empty -> free resources */
 	{
 		if (dbch)
 		{
+			free(dbch->convBuf);
 			free(dbch);
 		}
 	}
@@ -751,25 +778,22 @@ epicsShareFunc pvStat seq_pvAssign(SS_ID ss, CH_ID chId, const char *pvName)
 			epicsMutexUnlock(sp->lock);
 			return pvStatERROR;
 		}
+		dbch->reqType = ch->type->getType;
 		ch->dbch = dbch;
 
-		status = pvVarCreate(
-			sp->pvSys,		/* PV system context */
-			dbch->dbName,		/* DB channel name */
-			seq_conn_handler,	/* connection handler routine */
-			seq_event_handler,	/* event handler routine */
-			ch,			/* user ptr is CHAN structure */
-			&dbch->pvid);		/* ptr to pvid */
+		status = seq_chan_create(ch);
 		if (status != pvStatOK)
 		{
 			errlogSevPrintf(errlogFatal, "pvAssign(var %s, pv %s): pvVarCreate() failure: "
 				"%s\n", ch->varName, dbch->dbName, pvVarGetMess(dbch->pvid));
 			free(ch->dbch->dbName);
+			free(ch->dbch->convBuf);
 			free(ch->dbch);
 		}
 		else
 		{
 			sp->assignCount++;
+			seq_ctrl_connect(ch);
 		}
 	}
 
@@ -987,11 +1011,18 @@ epicsShareFunc boolean seq_pvAssigned(SS_ID ss, CH_ID chId)
 /*
  * Return number elements in an array, which is the lesser of
  * the array size and the element count returned by the PV layer.
+ * For a dynamic monitor it is the number of elements in the last
+ * value received (0 if none yet).
  */
 epicsShareFunc unsigned seq_pvCount(SS_ID ss, CH_ID chId)
 {
 	CHAN *ch = ss->prog->chan + chId;
-	return ch->dbch ? ch->dbch->dbCount : ch->count;
+
+	if (!ch->dbch)
+		return ch->count;
+	if (ch->monitorDynamic)
+		return min(metaPtr(ch,ss)->count, ch->dbch->dbCount);
+	return ch->dbch->dbCount;
 }
 
 /*
@@ -1052,6 +1083,112 @@ epicsShareFunc epicsTimeStamp seq_pvTimeStamp(SS_ID ss, CH_ID chId)
 	}
 }
 
+/*
+ * Copy channel engineering units into the given buffer, which must hold
+ * pvUnitsSize characters, and return it; "" if not (yet) known.
+ */
+epicsShareFunc char *seq_pvUnits(SS_ID ss, CH_ID chId, char *units)
+{
+	PROG	*sp = ss->prog;
+	CHAN	*ch = sp->chan + chId;
+
+	epicsMutexMustLock(sp->lock);
+	if (ch->dbch && ch->dbch->ctrl)
+		strncpy(units, ch->dbch->ctrl->units, pvUnitsSize - 1);
+	else
+		units[0] = 0;
+	units[pvUnitsSize - 1] = 0;
+	epicsMutexUnlock(sp->lock);
+	return units;
+}
+
+/*
+ * Return channel display precision, 0 if not (yet) known.
+ */
+epicsShareFunc int seq_pvPrecision(SS_ID ss, CH_ID chId)
+{
+	PROG	*sp = ss->prog;
+	CHAN	*ch = sp->chan + chId;
+	int	precision = 0;
+
+	epicsMutexMustLock(sp->lock);
+	if (ch->dbch && ch->dbch->ctrl)
+		precision = ch->dbch->ctrl->precision;
+	epicsMutexUnlock(sp->lock);
+	return precision;
+}
+
+/*
+ * Get channel limits of the given kind. Returns pvStatERROR and
+ * leaves low and high alone if they are not (yet) known.
+ */
+epicsShareFunc pvStat seq_pvLimits(SS_ID ss, CH_ID chId,
+	double *low, double *high, enum pvLimitKind kind)
+{
+	PROG	*sp = ss->prog;
+	CHAN	*ch = sp->chan + chId;
+	pvStat	status = pvStatERROR;
+
+	epicsMutexMustLock(sp->lock);
+	if (ch->dbch && ch->dbch->ctrl)
+	{
+		pvCtrl	*ctrl = ch->dbch->ctrl;
+
+		status = pvStatOK;
+		switch (kind)
+		{
+		case pvLimitDISPLAY:
+			*low = ctrl->displayLow;
+			*high = ctrl->displayHigh;
+			break;
+		case pvLimitCONTROL:
+			*low = ctrl->controlLow;
+			*high = ctrl->controlHigh;
+			break;
+		case pvLimitALARM:
+			*low = ctrl->alarmLow;
+			*high = ctrl->alarmHigh;
+			break;
+		case pvLimitWARNING:
+			*low = ctrl->warningLow;
+			*high = ctrl->warningHigh;
+			break;
+		default:
+			status = pvStatERROR;
+		}
+	}
+	epicsMutexUnlock(sp->lock);
+	return status;
+}
+
+/*
+ * Return the index of the enum string (state name) of a channel,
+ * -1 if there is no such string or the strings are not (yet) known.
+ */
+epicsShareFunc int seq_pvChoice(SS_ID ss, CH_ID chId, const char *name)
+{
+	PROG	*sp = ss->prog;
+	CHAN	*ch = sp->chan + chId;
+	int	n, index = -1;
+
+	epicsMutexMustLock(sp->lock);
+	if (ch->dbch && ch->dbch->ctrl)
+	{
+		pvCtrl	*ctrl = ch->dbch->ctrl;
+
+		for (n = 0; n < ctrl->numChoices; n++)
+		{
+			if (strncmp(ctrl->choices[n], name, pvChoiceSize) == 0)
+			{
+				index = n;
+				break;
+			}
+		}
+	}
+	epicsMutexUnlock(sp->lock);
+	return index;
+}
+
 /*
  * Set an event flag, then wake up each state
  * set that might be waiting on that event flag.
@@ -1161,6 +1298,16 @@ epicsShareFunc boolean seq_efTestAndClear(SS_ID ss, EF_ID ev_flag)
 	return isSet;
 }
 
+/* Number of values in a queued message of the given size; for queues
+   with elements of varying size this may be less than dbCount */
+static size_t queued_count(CHAN *ch, size_t elemSize)
+{
+	pvType	type = ch->type->getType;
+	size_t	count = 1 + (elemSize - pv_size(type)) / pv_value_sizes[type];
+
+	return min(count, ch->dbch->dbCount);
+}
+
 struct getq_cp_arg {
 	CHAN	*ch;
 	void	*var;
@@ -1183,7 +1330,8 @@ static void *getq_cp(void *dest, const void *value, size_t elemSize)
 		meta->status = pv_status(value,type);
 		meta->severity = pv_severity(value,type);
 		meta->timeStamp = pv_stamp(value,type);
-		count = ch->dbch->dbCount;
+		count = queued_count(ch, elemSize);
+		meta->count = count;
 	}
 	return memcpy(var, pv_value_ptr(value,type), ch->type->size * count);
 }
@@ -1209,6 +1357,13 @@ epicsShareFunc boolean seq_pvGetQ(SS_ID ss, CH_ID chId)
 		);
 		return FALSE;
 	}
+	if (isSpareSlot(ss, ssSlot(ss,ch)))
+	{
+		errlogSevPrintf(errlogMajor,
+			"pvGetQ(%s): user error (not used by state set %s)\n",
+			ch->varName, ss->ssName);
+		return FALSE;
+	}
 
 	was_empty = seqQueueGetF(ch->queue, getq_cp, &arg);
 
@@ -1226,6 +1381,256 @@ epicsShareFunc boolean seq_pvGetQ(SS_ID ss, CH_ID chId)
 	return (!was_empty);
 }
 
+struct getq_many_arg {
+	CHAN		*ch;
+	char		*values;
+	seqPvMeta	*meta;
+};
+
+static void *getq_many_cp(void *dest, const void *value, size_t elemSize)
+{
+	struct getq_many_arg *arg = (struct getq_many_arg *)dest;
+	CHAN	*ch = arg->ch;
+	void	*var = arg->values;
+	pvType	type = ch->type->getType;
+	size_t	count = ch->count;
+
+	if (ch->dbch)
+	{
+		assert(pv_is_time_type(type));
+		if (arg->meta)
+		{
+			arg->meta->status = pv_status(value,type);
+			arg->meta->severity = pv_severity(value,type);
+			arg->meta->timeStamp = pv_stamp(value,type);
+		}
+		count = queued_count(ch, elemSize);
+	}
+	else if (arg->meta)
+	{
+		memset(arg->meta, 0, sizeof(seqPvMeta));
+	}
+	if (arg->meta)
+		arg->meta++;
+	/* values are spaced according to the declared variable size */
+	arg->values += ch->type->size * ch->count;
+	return memcpy(var, pv_value_ptr(value,type), ch->type->size * count);
+}
+
+/*
+ * Get up to n values from a queued PV.
+ */
+epicsShareFunc unsigned seq_pvGetQMany(SS_ID ss, CH_ID chId, void *values,
+	unsigned n, seqPvMeta *meta)
+{
+	PROG	*sp = ss->prog;
+	CHAN	*ch = sp->chan + chId;
+	EF_ID	ev_flag = ch->syncedTo;
+	size_t	num;
+	struct getq_many_arg arg = {ch, (char *)values, meta};
+
+	if (!ch->queue)
+	{
+		errlogSevPrintf(errlogMajor,
+			"pvGetQMany(%s): user error (not queued)\n",
+			ch->varName
+		);
+		return 0;
+	}
+
+	num = seqQueueGetBatchF(ch->queue, getq_many_cp, &arg, n);
+
+	if (ev_flag && num > 0)
+	{
+		epicsMutexMustLock(sp->lock);
+		/* If queue is now empty, clear the event flag */
+		if (seqQueueIsEmpty(ch->queue))
+		{
+			bitClear(sp->evFlags, ev_flag);
+		}
+		epicsMutexUnlock(sp->lock);
+	}
+
+	return (unsigned)num;
+}
+
+/* A queue taking part in a merge, see seq_pvGetQMerge */
+struct merge_node {
+	CHAN		*ch;
+	epicsTimeStamp	stamp;		/* time stamp of first element */
+	unsigned	index;		/* position in the list of channels */
+	boolean		taken;		/* whether elements were removed */
+};
+
+/* Number of merge nodes that are allocated on the stack */
+#define MERGE_LOCAL_NODES 16
+
+static void *merge_stamp_cp(void *dest, const void *value, size_t elemSize)
+{
+	struct merge_node *node = (struct merge_node *)dest;
+	CHAN	*ch = node->ch;
+
+	if (ch->dbch)
+		node->stamp = pv_stamp(value, ch->type->getType);
+	else
+		memset(&node->stamp, 0, sizeof(epicsTimeStamp));
+	return dest;
+}
+
+/* Update the node's time stamp from its queue; return FALSE if empty */
+static boolean merge_first(struct merge_node *node)
+{
+	return !seqQueueFirstF(node->ch->queue, merge_stamp_cp, node);
+}
+
+/* Order of the merge: older first, then by position in the list */
+static boolean merge_before(const struct merge_node *a, const struct merge_node *b)
+{
+	if (a->stamp.secPastEpoch != b->stamp.secPastEpoch)
+		return a->stamp.secPastEpoch < b->stamp.secPastEpoch;
+	if (a->stamp.nsec != b->stamp.nsec)
+		return a->stamp.nsec < b->stamp.nsec;
+	return a->index < b->index;
+}
+
+/* Restore the heap property below position i */
+static void merge_sift_down(struct merge_node *heap, unsigned num, unsigned i)
+{
+	struct merge_node node = heap[i];
+
+	for (;;)
+	{
+		unsigned child = 2 * i + 1;
+
+		if (child >= num)
+			break;
+		if (child + 1 < num && merge_before(heap + child + 1, heap + child))
+			child++;
+		if (!merge_before(heap + child, &node))
+			break;
+		heap[i] = heap[child];
+		i = child;
+	}
+	heap[i] = node;
+}
+
+/*
+ * Get up to n values from several queued PVs, oldest first.
+ */
+epicsShareFunc unsigned seq_pvGetQMerge(SS_ID ss, const CH_ID *chIds,
+	unsigned numChans, void *values, unsigned n, unsigned *which,
+	seqPvMeta *meta)
+{
+	PROG	*sp = ss->prog;
+	struct merge_node local[MERGE_LOCAL_NODES];
+	struct merge_node *nodes = local;
+	struct merge_node *heap;
+	CHAN	*first = 0;
+	unsigned num = 0, numHeap = 0, numNodes, i;
+	struct getq_many_arg arg = {0, (char *)values, meta};
+
+	for (i = 0; i < numChans; i++)
+	{
+		CHAN *ch;
+
+		if (chIds[i] >= sp->numChans)
+		{
+			errlogSevPrintf(errlogMajor,
+				"pvGetQMerge: user error (invalid channel index %u)\n",
+				chIds[i]);
+			return 0;
+		}
+		ch = sp->chan + chIds[i];
+		if (!ch->queue)
+		{
+			errlogSevPrintf(errlogMajor,
+				"pvGetQMerge(%s): user error (not queued)\n",
+				ch->varName);
+			return 0;
+		}
+		if (!first)
+			first = ch;
+		else if (ch->type != first->type || ch->count != first->count)
+		{
+			errlogSevPrintf(errlogMajor,
+				"pvGetQMerge(%s): user error (type differs from %s)\n",
+				ch->varName, first->varName);
+			return 0;
+		}
+	}
+	if (numChans > MERGE_LOCAL_NODES)
+	{
+		nodes = newArray(struct merge_node, numChans);
+		if (!nodes)
+		{
+			errlogSevPrintf(errlogFatal, "pvGetQMerge: calloc failed\n");
+			return 0;
+		}
+	}
+
+	/* The heap holds the channels with non-empty queues, keyed
+	   on the time stamp of their first element. It is built in
+	   place, in front of the channels found empty. */
+	heap = nodes;
+	for (i = 0; i < numChans; i++)
+	{
+		struct merge_node *node = nodes + numHeap;
+
+		node->ch = sp->chan + chIds[i];
+		node->index = i;
+		node->taken = FALSE;
+		if (merge_first(node))
+			numHeap++;
+	}
+	numNodes = numHeap;
+	for (i = numHeap / 2; i-- > 0;)
+		merge_sift_down(heap, numHeap, i);
+
+	while (num < n && numHeap > 0)
+	{
+		struct merge_node *top = heap;
+
+		arg.ch = top->ch;
+		if (!seqQueueGetF(top->ch->queue, getq_many_cp, &arg))
+		{
+			top->taken = TRUE;
+			if (which)
+				which[num] = top->index;
+			num++;
+		}
+		if (!merge_first(top))
+		{
+			/* keep it behind the heap, for clearing the event flag */
+			struct merge_node empty = *top;
+
+			heap[0] = heap[--numHeap];
+			heap[numHeap] = empty;
+		}
+		merge_sift_down(heap, numHeap, 0);
+	}
+
+	if (num > 0)
+	{
+		epicsMutexMustLock(sp->lock);
+		for (i = 0; i < numNodes; i++)
+		{
+			CHAN	*ch = nodes[i].ch;
+
+			/* If a queue is now empty, clear its event flag */
+			if (nodes[i].taken && ch->syncedTo &&
+				seqQueueIsEmpty(ch->queue))
+			{
+				bitClear(sp->evFlags, ch->syncedTo);
+			}
+		}
+		epicsMutexUnlock(sp->lock);
+	}
+
+	if (nodes != local)
+		free(nodes);
+	return num;
+}
+
 /*
  * Flush elements on syncQ queue and clear event flag.
  */
@@ -1258,6 +1663,62 @@ epicsShareFunc void seq_pvFlushQ(SS_ID ss, CH_ID chId)
 	}
 }
 
+/*
+ * Send the current value of a message channel's variable to each receiving
+ * state set and wake up those that received it. Returns whether all
+ * receivers got the message; a message is dropped for a receiver whose
+ * queue is full. This does not lock the program, so state sets that do not
+ * receive from this channel are never disturbed.
+ */
+epicsShareFunc boolean seq_msgSend(SS_ID ss, unsigned msgId)
+{
+	PROG		*sp = ss->prog;
+	seqMsgChan	*mc;
+	unsigned	n;
+	boolean		delivered = TRUE;
+
+	assert(msgId < sp->numMsgChans);
+	mc = sp->msgChans + msgId;
+
+	for (n = 0; n < mc->numReceivers; n++)
+	{
+		unsigned nss = mc->receivers[n];
+
+		if (seqQueuePut(sp->msgQueues[msgId * sp->numSS + nss], valPtr(mc, ss)))
+		{
+			DEBUG("msgSend(%s): queue full for ss=%u\n", mc->varName, nss);
+			delivered = FALSE;
+		}
+		else
+			epicsEventSignal(sp->ss[nss].syncSem);
+	}
+	return delivered;
+}
+
+/*
+ * Remove the oldest message this state set received on a message channel
+ * and store it in the channel's variable. Returns whether there was one.
+ */
+epicsShareFunc boolean seq_msgRecv(SS_ID ss, unsigned msgId)
+{
+	PROG		*sp = ss->prog;
+	seqMsgChan	*mc;
+	QUEUE		queue;
+
+	assert(msgId < sp->numMsgChans);
+	mc = sp->msgChans + msgId;
+	queue = sp->msgQueues[msgId * sp->numSS + ssNum(ss)];
+
+	if (!queue)
+	{
+		errlogSevPrintf(errlogMajor,
+			"msgRecv(%s): user error (state set %s is not a receiver)\n",
+			mc->varName, ss->ssName);
+		return FALSE;
+	}
+	return !seqQueueGet(queue, valPtr(mc, ss));
+}
+
 /*
  * Test whether a given delay has expired.
  *
@@ -11,9 +11,11 @@ in the file LICENSE that is included with this distribution.
 #include "seq.h"
 #include "seq_debug.h"
 
+static boolean init_arena(PROG *sp, seqProgram *seqProg);
 static boolean init_sprog(PROG *sp, seqProgram *seqProg);
 static boolean init_sscb(PROG *sp, SSCB *ss, seqSS *seqSS);
 static boolean init_chan(PROG *sp, CHAN *ch, seqChan *seqChan);
+static boolean init_msgchan(PROG *sp, unsigned nmc);
 
 /*
  * types for DB put/get, element size based on user variable type.
@@ -129,6 +131,29 @@ epicsShareFunc epicsThreadId epicsShareAPI seq(
 	if (sp->threadPriority > THREAD_PRIORITY)
 		sp->threadPriority = THREAD_PRIORITY;
 
+	/* Specify request types */
+	str = seqMacValGet(sp, "pvtype");
+	if (str && strcmp(str, "native") == 0)
+		sp->nativeType = TRUE;
+	else if (str && str[0] != '\0' && strcmp(str, "var") != 0)
+		errlogSevPrintf(errlogMinor, "seq: ignoring invalid pvtype '%s'\n", str);
+
+	/* Specify default channel priority */
+	str = seqMacValGet(sp, "pvpriority");
+	if (str && str[0] != '\0')
+	{
+		sscanf(str, "%u", &sp->pvPriority);
+	}
+	if (sp->pvPriority > pvPriorityMax)
+		sp->pvPriority = pvPriorityMax;
+
+	/* Specify event dispatch queue size (0=apply events in callbacks) */
+	str = seqMacValGet(sp, "pvdispatch");
+	if (str && str[0] != '\0')
+	{
+		sscanf(str, "%u", &sp->dispatchSize);
+	}
+
 	tid = epicsThreadCreate(threadName, sp->threadPriority,
 		sp->stackSize, sequencer, sp);
 	if (!tid)
@@ -150,7 +175,7 @@ epicsShareFunc epicsThreadId epicsShareAPI seq(
  */
 static boolean init_sprog(PROG *sp, seqProgram *seqProg)
 {
-	unsigned nss, nch;
+	unsigned nss, nch, nmc;
 
 	/* Copy information for state program */
 	sp->numSS = seqProg->numSS;
@@ -163,17 +188,12 @@ static boolean init_sprog(PROG *sp, seqProgram *seqProg)
 	sp->exitFunc = seqProg->exitFunc;
 	sp->varSize = seqProg->varSize;
 	sp->numQueues = seqProg->numQueues;
+	sp->msgChans = seqProg->msgChans;
+	sp->numMsgChans = seqProg->numMsgChans;
 
-	/* Allocate user variable area if reentrant option (+r) is set */
-	if (optTest(sp, OPT_REENT) && sp->varSize > 0)
-	{
-		sp->var = (SEQ_VARS *)newArray(char, sp->varSize);
-		if (!sp->var)
-		{
-			errlogSevPrintf(errlogFatal, "init_sprog: calloc failed\n");
-			return FALSE;
-		}
-	}
+	/* Allocate all fixed size tables in one go */
+	if (!init_arena(sp, seqProg))
+		return FALSE;
 
 	DEBUG("init_sprog: numSS=%d, numChans=%d, numEvFlags=%u, "
 		"progName=%s, varSize=%u\n", sp->numSS, sp->numChans,
@@ -199,68 +219,150 @@ static boolean init_sprog(PROG *sp, seqProgram *seqProg)
 		return FALSE;
 	}
 
-	/* Allocate an array for event flag bits. Note this does
-	   *not* reserve space for all event numbers (i.e. including
-	   channels), only for event flags. */
-	assert(NWORDS(sp->numEvFlags) > 0);
-	sp->evFlags = newArray(bitMask, NWORDS(sp->numEvFlags));
-	if (!sp->evFlags)
+	/* Initial pool for pv requests is 1kB on 32-bit systems */
+	freeListInitPvt(&sp->pvReqPool, 128, sizeof(PVREQ));
+	if (!sp->pvReqPool)
 	{
-		errlogSevPrintf(errlogFatal, "init_sprog: calloc failed\n");
+		errlogSevPrintf(errlogFatal, "init_sprog: freeListInitPvt failed\n");
 		return FALSE;
 	}
-	/* NOTE: event flags count from 1 upward */
-	sp->syncedChans = newArray(CHAN*, sp->numEvFlags+1);
 
-	/* Allocate and initialize syncQ queues */
-	if (sp->numQueues > 0)
+	/* Initialize state set structs */
+	for (nss = 0; nss < sp->numSS; nss++)
 	{
-		sp->queues = newArray(QUEUE, sp->numQueues);
-		if (!sp->queues)
-		{
-			errlogSevPrintf(errlogFatal, "init_sprog: calloc failed\n");
+		if (!init_sscb(sp, sp->ss + nss, seqProg->ss + nss))
 			return FALSE;
-		}
 	}
-	/* Initial pool for pv requests is 1kB on 32-bit systems */
-	freeListInitPvt(&sp->pvReqPool, 128, sizeof(PVREQ));
-	if (!sp->pvReqPool)
+
+	/* Initialize channel structs */
+	for (nch = 0; nch < sp->numChans; nch++)
 	{
-		errlogSevPrintf(errlogFatal, "init_sprog: freeListInitPvt failed\n");
-		return FALSE;
+		if (!init_chan(sp, sp->chan + nch, seqProg->chan + nch))
+			return FALSE;
 	}
 
-	/* Allocate array of state set structs and initialize it */
-	if (sp->numSS > 0)
+	/* Create message channel queues */
+	for (nmc = 0; nmc < sp->numMsgChans; nmc++)
 	{
-		sp->ss = newArray(SSCB, sp->numSS);
-		if (!sp->ss)
-		{
-			errlogSevPrintf(errlogFatal, "init_sprog: calloc failed\n");
+		if (!init_msgchan(sp, nmc))
 			return FALSE;
-		}
 	}
+	return TRUE;
+}
+
+/* Alignment of blocks inside the arena (enough for any C type we store) */
+#define ARENA_ALIGN	16
+#define arenaRound(n)	(((n) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+/*
+ * Take the next block of count elements of the given size from the arena.
+ * If the arena has not yet been allocated, only account for its size
+ * and return NULL.
+ */
+static void *arena_take(PROG *sp, size_t *used, size_t count, size_t size)
+{
+	size_t offset = *used;
+
+	if (count == 0)
+		return NULL;
+	*used += arenaRound(count * size);
+	return sp->arena ? (char *)sp->arena + offset : NULL;
+}
+
+/*
+ * Number of entries in the per state set channel tables: one for each
+ * channel the state set uses plus a spare one for all others, or one
+ * for each channel if the compiler did not generate a channel map.
+ * Only the first are ever used; the pv functions reject channels that
+ * map to the spare one, so that its entries stay empty.
+ */
+static unsigned num_slots(PROG *sp, seqSS *seqSS)
+{
+	if (!seqSS->chanMap)
+		return sp->numChans;
+	return seqSS->numMapped + 1;
+}
+
+/*
+ * Lay out all fixed size tables of a program instance: program and
+ * state set variable areas, event flags, state set and channel structs,
+ * and the per state set request and safe mode tables. Returns the
+ * total size needed.
+ */
+static size_t layout_arena(PROG *sp, seqProgram *seqProg)
+{
+	size_t used = 0;
+	unsigned nss;
+	size_t totalSlots = 0, slot = 0;
+	/* per state set tables are stored as one block each, sliced below */
+	PVREQ **getReq, **putReq;
+	PVMETA *metaData = NULL;
+	boolean *dirty = NULL;
+	char *var = NULL;
+	size_t varStride = arenaRound(sp->varSize);
+
+	sp->chan = (CHAN *)arena_take(sp, &used, sp->numChans, sizeof(CHAN));
+	sp->ss = (SSCB *)arena_take(sp, &used, sp->numSS, sizeof(SSCB));
+	/* Note this does *not* reserve space for all event numbers
+	   (i.e. including channels), only for event flags. */
+	assert(NWORDS(sp->numEvFlags) > 0);
+	sp->evFlags = (bitMask *)arena_take(sp, &used, NWORDS(sp->numEvFlags), sizeof(bitMask));
+	/* NOTE: event flags count from 1 upward */
+	sp->syncedChans = (CHAN **)arena_take(sp, &used, sp->numEvFlags+1, sizeof(CHAN*));
+	sp->queues = (QUEUE *)arena_take(sp, &used, sp->numQueues, sizeof(QUEUE));
+	sp->msgQueues = (QUEUE *)arena_take(sp, &used, sp->numMsgChans * sp->numSS, sizeof(QUEUE));
+
 	for (nss = 0; nss < sp->numSS; nss++)
+		totalSlots += num_slots(sp, seqProg->ss + nss);
+	getReq = (PVREQ **)arena_take(sp, &used, totalSlots, sizeof(PVREQ*));
+	putReq = (PVREQ **)arena_take(sp, &used, totalSlots, sizeof(PVREQ*));
+	if (optTest(sp, OPT_SAFE))
 	{
-		if (!init_sscb(sp, sp->ss + nss, seqProg->ss + nss))
-			return FALSE;
+		metaData = (PVMETA *)arena_take(sp, &used, totalSlots, sizeof(PVMETA));
+		dirty = (boolean *)arena_take(sp, &used, totalSlots, sizeof(boolean));
+		var = (char *)arena_take(sp, &used, sp->numSS, varStride);
 	}
 
-	/* Allocate array of channel structs and initialize it */
-	if (sp->numChans > 0)
+	/* User variable area (shared buffer) if reentrant option (+r) is set */
+	if (optTest(sp, OPT_REENT))
+		sp->var = (SEQ_VARS *)arena_take(sp, &used, sp->varSize, 1);
+
+	if (sp->arena)
 	{
-		sp->chan = newArray(CHAN, sp->numChans);
-		if (!sp->chan)
+		for (nss = 0; nss < sp->numSS; nss++)
 		{
-			errlogSevPrintf(errlogFatal, "init_sprog: calloc failed\n");
-			return FALSE;
+			SSCB *ss = sp->ss + nss;
+
+			ss->chanMap = seqProg->ss[nss].chanMap;
+			ss->numMapped = seqProg->ss[nss].numMapped;
+			ss->numSlots = num_slots(sp, seqProg->ss + nss);
+			ss->getReq = getReq ? getReq + slot : NULL;
+			ss->putReq = putReq ? putReq + slot : NULL;
+			ss->metaData = metaData ? metaData + slot : NULL;
+			ss->dirty = dirty ? dirty + slot : NULL;
+			if (var)
+				ss->var = (SEQ_VARS *)(var + nss * varStride);
+			slot += ss->numSlots;
 		}
 	}
-	for (nch = 0; nch < sp->numChans; nch++)
+	return used;
+}
+
+/*
+ * Allocate all fixed size tables of a program instance as a single block.
+ */
+static boolean init_arena(PROG *sp, seqProgram *seqProg)
+{
+	sp->arenaSize = layout_arena(sp, seqProg);
+	assert(sp->arenaSize > 0);
+	sp->arena = newArray(char, sp->arenaSize);
+	if (!sp->arena)
 	{
-		if (!init_chan(sp, sp->chan + nch, seqProg->chan + nch))
-			return FALSE;
+		errlogSevPrintf(errlogFatal, "init_arena: calloc failed\n");
+		return FALSE;
 	}
+	layout_arena(sp, seqProg);
+	DEBUG("init_arena: arenaSize=%u\n", sp->arenaSize);
 	return TRUE;
 }
 
@@ -288,30 +390,6 @@ static boolean init_sscb(PROG *sp, SSCB *ss, seqSS *seqSS)
 		return FALSE;
 	}
 
-	if (sp->numChans > 0)
-	{
-		ss->getReq = newArray(PVREQ*, sp->numChans);
-		if (!ss->getReq)
-		{
-			errlogSevPrintf(errlogFatal, "init_sscb: calloc failed\n");
-			return FALSE;
-		}
-		ss->putReq = newArray(PVREQ*, sp->numChans);
-		if (!ss->putReq)
-		{
-			errlogSevPrintf(errlogFatal, "init_sscb: calloc failed\n");
-			return FALSE;
-		}
-		if (optTest(sp, OPT_SAFE))
-		{
-			ss->metaData = newArray(PVMETA, sp->numChans);
-			if (!ss->metaData)
-			{
-				errlogSevPrintf(errlogFatal, "init_ss: calloc failed\n");
-				return FALSE;
-			}
-		}
-	}
 	/* note: do not pre-allocate request structures */
 	ss->dead = epicsEventCreate(epicsEventEmpty);
 	if (!ss->dead)
@@ -327,28 +405,15 @@ static boolean init_sscb(PROG *sp, SSCB *ss, seqSS *seqSS)
 	/* Allocate separate user variable area if safe mode option (+s) is set */
 	if (optTest(sp, OPT_SAFE))
 	{
-		if (sp->numChans > 0)
-		{
-			ss->dirty = newArray(boolean, sp->numChans);
-			if (!ss->dirty)
-			{
-				errlogSevPrintf(errlogFatal, "init_sscb: calloc failed\n");
-				return FALSE;
-			}
-		}
-		if (sp->varSize > 0)
+		ss->varLock = epicsMutexCreate();
+		if (!ss->varLock)
 		{
-			ss->var = (SEQ_VARS *)newArray(char, sp->varSize);
-			if (!ss->var)
-			{
-				errlogSevPrintf(errlogFatal, "init_sscb: calloc failed\n");
-				return FALSE;
-			}
+			errlogSevPrintf(errlogFatal, "init_sscb: epicsMutexCreate failed\n");
+			return FALSE;
 		}
 	}
 	else
 	{
-		ss->dirty = NULL;
 		ss->var = sp->var;
 	}
 	return TRUE;
@@ -374,6 +439,11 @@ static boolean init_chan(PROG *sp, CHAN *ch, seqChan *seqChan)
 		ch->nextSynced = fst;
 	}
 	ch->monitored = seqChan->monitored;
+	ch->monitorMask = seqChan->monitorMask;
+	ch->monitorDynamic = seqChan->monitorDynamic;
+	ch->filter = seqChan->filter;
+	ch->priority = seqChan->priority;
+	ch->ctrl = seqChan->ctrl;
 	ch->eventNum = seqChan->eventNum;
 
 	/* Fill in request type info */
@@ -407,6 +477,7 @@ static boolean init_chan(PROG *sp, CHAN *ch, seqChan *seqChan)
 				errlogSevPrintf(errlogFatal, "init_chan: epicsStrDup failed\n");
 				return FALSE;
 			}
+			dbch->reqType = ch->type->getType;
 			ch->dbch = dbch;
 			sp->assignCount++;
 			if (ch->monitored)
@@ -427,19 +498,45 @@ static boolean init_chan(PROG *sp, CHAN *ch, seqChan *seqChan)
 		   so that we can extract status etc when we remove
 		   the message. */
 		size_t size = pv_size_n(ch->type->getType, ch->count);
+		size_t bytes = seqChan->queueBytes;
 		QUEUE *q = sp->queues + seqChan->queueIndex;
 
+		/* Updates of a dynamic monitor vary in size and must be
+		   stored with it; without a buffer size, make room for
+		   queueSize updates of maximum size */
+		if (seqChan->monitorDynamic && !bytes &&
+			seqChan->queuePolicy != QP_GROW)
+		{
+			bytes = seqChan->queueSize * (seqQueueVarOverhead +
+				(size + sizeof(double) - 1) / sizeof(double) * sizeof(double));
+		}
+
 		if (*q == NULL)
 		{
-			*q = seqQueueCreate(seqChan->queueSize, size);
+			/* With a buffer size given, or if the queue may
+			   grow, messages are stored with their actual size */
+			*q = seqQueueCreatePolicy(seqChan->queueSize, size,
+				bytes, seqChan->queuePolicy);
 			if (!*q)
 			{
 				errlogSevPrintf(errlogFatal, "init_chan: seqQueueCreate failed\n");
 				return FALSE;
 			}
+			if (seqChan->queueStats)
+				seqQueueEnableStats(*q);
+			if (seqChan->queueSpill && !seqQueueSpill(*q, seqChan->queueSpill))
+			{
+				errlogSevPrintf(errlogFatal, "init_chan(varname=%s): "
+					"cannot create queue spill area\n", seqChan->varName);
+				return FALSE;
+			}
 		}
 		else if (seqQueueNumElems(*q) != seqChan->queueSize ||
-			 seqQueueElemSize(*q) != size)
+			 seqQueueElemSize(*q) != size ||
+			 seqQueueGetPolicy(*q) != seqChan->queuePolicy ||
+			 (seqQueueSpillArea(*q) != 0) != (seqChan->queueSpill != 0) ||
+			 (seqQueueNumBytes(*q) != 0) != (bytes != 0 ||
+				seqChan->queuePolicy == QP_GROW))
 		{
 			errlogSevPrintf(errlogFatal,
 				"init_chan(varname=%s): inconsistent shared queue definitions\n",
@@ -452,6 +549,17 @@ static boolean init_chan(PROG *sp, CHAN *ch, seqChan *seqChan)
 		DEBUG("  queue->numElems=%d, queue->elemSize=%d\n",
 			seqQueueNumElems(ch->queue), seqQueueElemSize(ch->queue));
 	}
+	/* In safe mode, a channel used by a single state set shares that
+	   state set's var lock, so that monitor events can be delivered
+	   directly into its buffer while it waits for events */
+	if (optTest(sp, OPT_SAFE) && seqChan->owner >= 0)
+	{
+		assert((unsigned)seqChan->owner < sp->numSS);
+		ch->owner = sp->ss + seqChan->owner;
+		ch->varLock = ch->owner->varLock;
+		DEBUG("  owner=%s\n", ch->owner->ssName);
+		return TRUE;
+	}
 	ch->varLock = epicsMutexCreate();
 	if (!ch->varLock)
 	{
@@ -461,6 +569,35 @@ static boolean init_chan(PROG *sp, CHAN *ch, seqChan *seqChan)
 	return TRUE;
 }
 
+/*
+ * Create the queues of a message channel, one for each receiving state set.
+ * A full queue drops new messages, so that a send never blocks and never
+ * takes a lock.
+ */
+static boolean init_msgchan(PROG *sp, unsigned nmc)
+{
+	seqMsgChan *mc = sp->msgChans + nmc;
+	unsigned n;
+
+	DEBUG("init_msgchan: varName=%s, size=%u, queueSize=%u, numReceivers=%u\n",
+		mc->varName, (unsigned)mc->size, mc->queueSize, mc->numReceivers);
+	for (n = 0; n < mc->numReceivers; n++)
+	{
+		unsigned nss = mc->receivers[n];
+		QUEUE *q = sp->msgQueues + nmc * sp->numSS + nss;
+
+		assert(nss < sp->numSS);
+		*q = seqQueueCreatePolicy(mc->queueSize, mc->size, 0, QP_DROP_NEWEST);
+		if (!*q)
+		{
+			errlogSevPrintf(errlogFatal, "init_msgchan(varname=%s): "
+				"seqQueueCreate failed\n", mc->varName);
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
 /* Free all allocated memory in a program structure */
 void seq_free(PROG *sp)
 {
@@ -472,16 +609,10 @@ void seq_free(PROG *sp)
 		SSCB *ss = sp->ss + nss;
 
 		epicsEventDestroy(ss->syncSem);
-		free(ss->metaData);
-
 		epicsEventDestroy(ss->dead);
-
-		if (optTest(sp, OPT_SAFE)) free(ss->dirty);
-		if (optTest(sp, OPT_SAFE)) free(ss->var);
+		if (ss->varLock) epicsMutexDestroy(ss->varLock);
 	}
 
-	free(sp->ss);
-
 	/* Delete program-wide semaphores */
 	epicsMutexDestroy(sp->lock);
 	epicsEventDestroy(sp->ready);
@@ -495,17 +626,19 @@ void seq_free(PROG *sp)
 		if (ch->dbch)
 		{
 			free(ch->dbch->dbName);
+			free(ch->dbch->convBuf);
+			free(ch->dbch->ctrl);
 			free(ch->dbch);
 		}
 	}
-	free(sp->chan);
 
 	for (nq = 0; nq < sp->numQueues; nq++)
 		seqQueueDestroy(sp->queues[nq]);
-	free(sp->queues);
 
-	free(sp->evFlags);
-	free(sp->syncedChans);
-	if (optTest(sp, OPT_REENT)) free(sp->var);
+	for (nq = 0; nq < sp->numMsgChans * sp->numSS; nq++)
+		if (sp->msgQueues[nq])
+			seqQueueDestroy(sp->msgQueues[nq]);
+
+	free(sp->arena);
 	free(sp);
 }
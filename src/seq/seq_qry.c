@@ -17,6 +17,8 @@ static int userInput(void);
 static void printValue(pr_fun *pr, void *val, unsigned count, int type);
 static SSCB *seqQryFind(epicsThreadId tid);
 static void seqShowAll(void);
+static const char *queuePolicyName(enum seqQueuePolicy policy);
+static void printQueueAges(const char *indent, QUEUE queue);
 
 void print_channel_value(pr_fun *pr, CHAN *ch, void *val)
 {
@@ -55,6 +57,12 @@ epicsShareFunc void epicsShareAPI seqShow(epicsThreadId tid)
 		optTest(sp, OPT_ASYNC), optTest(sp, OPT_DEBUG),
 		optTest(sp, OPT_NEWEF), optTest(sp, OPT_REENT),
 		optTest(sp, OPT_CONN));
+	if (sp->dispatchQueue)
+		printf("  event dispatch queue: size=%u, used=%u, highWater=%u, lost=%u\n",
+			(unsigned)seqQueueNumElems(sp->dispatchQueue),
+			(unsigned)seqQueueUsed(sp->dispatchQueue),
+			(unsigned)seqQueueHighWater(sp->dispatchQueue),
+			(unsigned)seqAtomicLoad(&sp->dispatchLost));
 	if (optTest(sp, OPT_REENT))
 		printf("  user variables: address = %p, length = %u\n",
 			sp->var, (unsigned)sp->varSize);
@@ -181,6 +189,13 @@ epicsShareFunc void epicsShareAPI seqChanShow(epicsThreadId tid, const char *str
 		else
 			printf("  Anonymous\n");
 
+		if (dbch && chanPriority(ch))
+			printf("  Priority %u\n", chanPriority(ch));
+
+		if (dbch && dbch->ctrl)
+			printf("  Units \"%s\", precision %d\n",
+				dbch->ctrl->units, dbch->ctrl->precision);
+
 		if(dbch && dbch->connected)
 			printf("  Connected\n");
 		else
@@ -291,6 +306,23 @@ epicsShareFunc void seqGatherStats(
 	*num_connected = stats.nConn;
 }
 
+epicsShareFunc unsigned seqGatherQueueStats(
+	epicsThreadId tid,
+	seqQueueStats *stats,
+	unsigned n
+)
+{
+	SSCB	*ss = tid ? seqFindStateSet(tid) : NULL;
+	PROG	*sp;
+	unsigned nq;
+
+	if (ss == NULL) return 0;
+	sp = ss->prog;
+	for (nq = 0; nq < n && nq < sp->numQueues; nq++)
+		seqQueueGetStats(sp->queues[nq], stats + nq);
+	return sp->numQueues;
+}
+
 /*
  * seqQueueShow() - Show syncQ queue information for a state program.
  */
@@ -310,13 +342,94 @@ epicsShareFunc void epicsShareAPI seqQueueShow(epicsThreadId tid)
 	{
 		QUEUE	queue = sp->queues[nq];
 
-		printf("  Queue #%d: numElems=%u, used=%u, elemSize=%u\n", nq,
+		printf("  Queue #%d: numElems=%u, used=%u, elemSize=%u", nq,
 			(unsigned)seqQueueNumElems(queue),
 			(unsigned)seqQueueUsed(queue),
 			(unsigned)seqQueueElemSize(queue));
+		if (seqQueueNumBytes(queue))
+			printf(" (max), numBytes=%u", (unsigned)seqQueueNumBytes(queue));
+		if (seqQueueGetPolicy(queue) == QP_GROW)
+			printf(" (limit %u)", (unsigned)seqQueueMaxBytes(queue));
+		printf("\n");
+		printf("    policy=%s, lost=%u, highWater=%u\n",
+			queuePolicyName(seqQueueGetPolicy(queue)),
+			(unsigned)seqQueueLost(queue),
+			(unsigned)seqQueueHighWater(queue));
+		printQueueAges("    ", queue);
+		if (seqQueueSpillArea(queue))
+		{
+			QUEUE	spill = seqQueueSpillArea(queue);
+
+			printf("    spill area: numBytes=%u, used=%u, highWater=%u\n",
+				(unsigned)seqQueueNumBytes(spill),
+				(unsigned)seqQueueUsed(spill),
+				(unsigned)seqQueueHighWater(spill));
+		}
 		dn = userInput();
 		nq += dn;
 	}
+	if (dn && sp->numMsgChans)
+	{
+		unsigned nmc, n;
+
+		printf("Number of message channels = %u\n", sp->numMsgChans);
+		for (nmc = 0; nmc < sp->numMsgChans; nmc++)
+		{
+			seqMsgChan *mc = sp->msgChans + nmc;
+
+			printf("  Message channel \"%s\": msgSize=%u, queueSize=%u\n",
+				mc->varName, (unsigned)mc->size, mc->queueSize);
+			for (n = 0; n < mc->numReceivers; n++)
+			{
+				unsigned nss = mc->receivers[n];
+				QUEUE	queue = sp->msgQueues[nmc * sp->numSS + nss];
+
+				printf("    receiver \"%s\": used=%u, lost=%u, highWater=%u\n",
+					sp->ss[nss].ssName,
+					(unsigned)seqQueueUsed(queue),
+					(unsigned)seqQueueLost(queue),
+					(unsigned)seqQueueHighWater(queue));
+				printQueueAges("      ", queue);
+			}
+		}
+	}
+}
+
+/*
+ * seqMemShow() - Show memory used for the run time tables of a state
+ * program, and how much the per state set channel maps save compared to
+ * tables with one entry for each channel.
+ */
+epicsShareFunc void epicsShareAPI seqMemShow(epicsThreadId tid)
+{
+	SSCB	*ss = seqQryFind(tid);
+	PROG	*sp;
+	unsigned nss;
+	size_t	slotSize = 2 * sizeof(PVREQ *);
+	size_t	totalSlots = 0;
+
+	if (ss == NULL) return;
+	sp = ss->prog;
+
+	if (optTest(sp, OPT_SAFE))
+		slotSize += sizeof(PVMETA) + sizeof(boolean);
+
+	printf("State Program: \"%s\"\n", sp->progName);
+	printf("  arena size = %u bytes\n", (unsigned)sp->arenaSize);
+	printf("  channels = %u, bytes per state set table entry = %u\n",
+		sp->numChans, (unsigned)slotSize);
+	for (nss = 0; nss < sp->numSS; nss++)
+	{
+		ss = sp->ss + nss;
+		totalSlots += ss->numSlots;
+		printf("  State Set: \"%s\", channels used = %u, table entries = %u, "
+			"table size = %u bytes\n", ss->ssName,
+			ss->chanMap ? ss->numMapped : sp->numChans, ss->numSlots,
+			(unsigned)(ss->numSlots * slotSize));
+	}
+	printf("  state set tables: %u bytes, %u bytes saved by channel maps\n",
+		(unsigned)(totalSlots * slotSize),
+		(unsigned)(((size_t)sp->numSS * sp->numChans - totalSlots) * slotSize));
 }
 
 /* Read one line from console and parse.
@@ -345,6 +458,42 @@ static int userInput(void)
 	return atoi(buf);
 }
 
+/* Print how long elements stayed in the queue */
+static void printQueueAges(const char *indent, QUEUE queue)
+{
+	static const char *bucketNames[seqQueueNumAgeBuckets] = {
+		"<1us", "<10us", "<100us", "<1ms", "<10ms", "<100ms", "<1s",
+		"<10s", ">=10s"
+	};
+	seqQueueStats	stats;
+	unsigned	b;
+
+	seqQueueGetStats(queue, &stats);
+	if (!stats.timed)
+		return;
+	printf("%sremoved=%u, maxAge=%gs, oldestAge=%gs\n", indent,
+		(unsigned)stats.removed, stats.maxAge, stats.oldestAge);
+	if (stats.removed == 0)
+		return;
+	printf("%sages:", indent);
+	for (b = 0; b < seqQueueNumAgeBuckets; b++)
+		printf(" %s=%u", bucketNames[b], (unsigned)stats.ageHist[b]);
+	printf("\n");
+}
+
+/* Name of a syncQ overflow policy, as in the syncq declaration */
+static const char *queuePolicyName(enum seqQueuePolicy policy)
+{
+	switch (policy)
+	{
+	case QP_OVERWRITE_LAST:	return "overwriteLast";
+	case QP_DROP_OLDEST:	return "dropOldest";
+	case QP_DROP_NEWEST:	return "dropNewest";
+	case QP_GROW:		return "grow";
+	}
+	return "?";
+}
+
 /* Print the current internal value of a database channel */
 static void printValue(pr_fun *pr, void *val, unsigned count, int type)
 {
@@ -4,32 +4,183 @@ Copyright (c) 2010-2015 Helmholtz-Zentrum Berlin f. Materialien
 This file is distributed subject to a Software License Agreement found
 in the file LICENSE that is included with this distribution.
 \*************************************************************************/
+/*************************************************************************\
+The queue is a bounded ring of slots, each with a sequence number, as
+described by Dmitry Vyukov for his MPMC queue. Producers claim a slot
+by advancing 'tail' with compare-and-swap, copy the data, and then
+publish it by setting the slot's sequence number to pos+1. Consumers do
+the same with 'head' and release the slot for the next round by setting
+its sequence number to pos+numSlots. The number of slots is the number
+of elements rounded up to a power of two (at least 2), so that positions can be
+mapped to slots with a mask; the number of elements is enforced by
+comparing tail and head.
+
+When the queue is full, a put overwrites the last (newest) element. To
+do this safely, the producer takes the slot away from readers by
+setting its sequence number back to pos, overwrites the data, and then
+publishes it again. This path takes a mutex to serialize overwriting
+producers; it is never taken as long as the queue is not full. A
+consumer that claimed the same slot waits until the overwrite is done.
+Alternatively, a full queue can discard the new element, or remove the
+first (oldest) element by advancing 'head' like a consumer would.
+
+A queue created with seqQueueCreateVar instead stores each element with
+its actual size in a ring of bytes, preceded by a small header. An
+element is never split at the end of the buffer; if it does not fit
+there, the rest is marked as unused and the element is placed at the
+beginning. Such queues are protected by the mutex. Head and tail then
+merely count elements, so that seqQueueUsed etc. work without locking.
+Queues that grow on demand are always of this kind, since the buffer
+can only be replaced while nobody else accesses it.
+
+The number of lost elements and the maximum number of used elements
+are counted with atomic operations, in the producers' cache line.
+
+If statistics are turned on (seqQueueEnableStats), each element is
+stamped with the (monotonic, if available) time of its put: fixed size
+queues keep the stamps in an array beside the slots, queues for
+elements of varying size in the element's header. Consumers enter the
+time an element spent in the queue into a histogram with decade
+buckets, and remember the maximum; these are atomic counters in a cache
+line of their own. Elements removed to make room or by a flush are not
+counted, as they are already counted as lost resp. were never consumed.
+Otherwise the clock is never read.
+
+A queue can have a spill area: a second queue for elements of varying
+size whose buffer is a memory mapped file. A put that finds the queue
+full, or the spill area not empty, goes to the spill area instead, and
+gets take elements from the spill area when the queue itself is empty.
+This keeps the order of each producer's elements: a get only goes to
+the spill area if the spill area was not empty before the queue was
+found empty (with no element still being written), since from then on
+puts go to the spill area as well.
+\*************************************************************************/
 #include "seq.h"
 #include "seq_debug.h"
+#include "seq_atomic.h"
 
 struct seqQueue {
-    size_t          wr;
-    size_t          rd;
+    /* consumer and producer positions, each in its own cache line */
+    seqAtomicSize   head;
+    char            pad1[SEQ_CACHE_LINE - sizeof(seqAtomicSize)];
+    seqAtomicSize   tail;
+    seqAtomicSize   lost;       /* number of elements lost */
+    seqAtomicSize   highWater;  /* maximum number of used elements */
+    char            pad2[SEQ_CACHE_LINE - 3 * sizeof(seqAtomicSize)];
+    /* consumer statistics, in their own cache line(s) */
+    seqAtomicSize   maxAge;     /* longest residence time in microseconds */
+    seqAtomicSize   ageHist[seqQueueNumAgeBuckets];
+    char            pad3[SEQ_CACHE_LINE - (seqQueueNumAgeBuckets + 1)
+                        * sizeof(seqAtomicSize) % SEQ_CACHE_LINE];
+    /* read-only after creation */
     size_t          numElems;
     size_t          elemSize;
-    boolean         overflow;
-    epicsMutexId    mutex;
+    size_t          mask;       /* number of slots minus one */
+    seqAtomicSize   *seq;       /* sequence number for each slot */
+    double          *stamp;     /* time of put for each slot */
     char            *buffer;
+    epicsMutexId    mutex;      /* serializes overwriting puts */
+    enum seqQueuePolicy policy; /* what to do if full */
+    size_t          maxBytes;   /* limit for growing numBytes */
+    QUEUE           spill;      /* spill area, or NULL */
+    boolean         mapped;     /* buffer is a mapped file */
+    boolean         timed;      /* residence time statistics on */
+    /* loss reports, protected by mutex */
+    size_t          reported;   /* lost elements already reported */
+    epicsTimeStamp  lastReport; /* time of last report */
+    /* variable size elements, protected by mutex */
+    size_t          numBytes;   /* buffer size in bytes, 0 if fixed size */
+    size_t          rd;         /* offset of first (oldest) element */
+    size_t          wr;         /* offset of free space after last element */
+    size_t          last;       /* offset of last (newest) element */
 };
 
+/* header of an element of a variable size queue */
+typedef struct {
+    size_t          size;       /* size of the element, or varWrap */
+    size_t          prev;       /* offset of the previous element */
+    double          stamp;      /* time of put */
+} VARHDR;
+
+STATIC_ASSERT(sizeof(VARHDR)==seqQueueVarOverhead);
+
+#define varWrap         ((size_t)-1)
+#define varAlign        sizeof(double)
+#define varRecSize(n)   (sizeof(VARHDR) + ((n) + varAlign - 1) / varAlign * varAlign)
+#define varHdr(q,off)   ((VARHDR *)((q)->buffer + (off)))
+/* initial size of growing queues, in elements of maximum size */
+#define varGrowInitial  4
+
+#define slotPtr(q,pos)  ((q)->buffer + ((pos) & (q)->mask) * (q)->elemSize)
+#define slotSeq(q,pos)  ((q)->seq + ((pos) & (q)->mask))
+#define slotStamp(q,pos) ((q)->stamp + ((pos) & (q)->mask))
+/* signed distance between positions, robust against wrap-around */
+#define posDiff(a,b)    ((ptrdiff_t)((a) - (b)))
+
+static size_t used(const QUEUE q);
+
+/* Number of retries before a producer that waits for a consumer to
+   release a slot starts yielding the processor */
+#define putSpins        16
+
+/* Back off before retrying a put that found the next slot not yet
+   released by a consumer (which may have been preempted) */
+static void put_backoff(unsigned *spins)
+{
+    if (++*spins > putSpins)
+        epicsThreadSleep(0.0);
+}
+
+/* Current time in seconds, for time stamping elements */
+static double now_sec(void)
+{
+#if EPICS_VERSION > 3 || (EPICS_VERSION == 3 && (EPICS_REVISION > 16 \
+    || (EPICS_REVISION == 16 && EPICS_MODIFICATION >= 1)))
+    return epicsMonotonicGet() * 1e-9;
+#else
+    epicsTimeStamp now;
+
+    epicsTimeGetCurrent(&now);
+    return now.secPastEpoch + now.nsec * 1e-9;
+#endif
+}
+
+/* Time stamp for an element put now */
+#define put_stamp(q)    ((q)->timed ? now_sec() : 0.0)
+
 epicsShareFunc boolean seqQueueInvariant(QUEUE q)
 {
-    return (q != NULL)
-        && q->elemSize > 0
+    size_t head, tail;
+
+    if (q == NULL)
+        return FALSE;
+    head = seqAtomicLoad(&q->head);
+    tail = seqAtomicLoad(&q->tail);
+    if (q->numBytes)
+        return q->elemSize > 0
+            && q->numElems > 0
+            && q->numElems <= seqQueueMaxNumElems
+            && q->numBytes >= varRecSize(q->elemSize)
+            && q->numBytes <= q->maxBytes
+            && q->rd <= q->numBytes
+            && q->wr <= q->numBytes
+            && q->last < q->numBytes
+            && posDiff(tail, head) >= 0
+            && (size_t)posDiff(tail, head) <= q->numElems;
+    return q->elemSize > 0
         && q->numElems > 0
         && q->numElems <= seqQueueMaxNumElems
-        && q->rd < q->numElems
-        && q->wr < q->numElems;
+        && q->numElems <= q->mask + 1
+        && ((q->mask + 1) & q->mask) == 0
+        && q->policy != QP_GROW
+        && posDiff(tail, head) >= 0
+        && (size_t)posDiff(tail, head) <= q->numElems;
 }
 
-epicsShareFunc QUEUE seqQueueCreate(size_t numElems, size_t elemSize)
+static QUEUE create_fixed(size_t numElems, size_t elemSize)
 {
     QUEUE q = new(struct seqQueue);
+    size_t numSlots, i;
 
     if (!q) {
         errlogSevPrintf(errlogFatal, "seqQueueCreate: out of memory\n");
@@ -51,58 +202,692 @@ epicsShareFunc QUEUE seqQueueCreate(size_t numElems, size_t elemSize)
         free(q);
         return 0;
     }
-    DEBUG("%s:%d:calloc(%u,%u)\n",__FILE__,__LINE__,numElems, elemSize);
-    q->buffer = (char *)calloc(numElems, elemSize);
+    /* at least two slots, otherwise a released slot (pos+numSlots)
+       would look like a published one (pos+1) */
+    for (numSlots = 2; numSlots < numElems; numSlots <<= 1)
+        ;
+    DEBUG("%s:%d:calloc(%u,%u)\n",__FILE__,__LINE__,numSlots, elemSize);
+    q->buffer = (char *)calloc(numSlots, elemSize);
     if (!q->buffer) {
         errlogSevPrintf(errlogFatal, "seqQueueCreate: out of memory\n");
         free(q);
         return 0;
     }
+    q->seq = newArray(seqAtomicSize, numSlots);
+    q->stamp = newArray(double, numSlots);
+    if (!q->seq || !q->stamp) {
+        errlogSevPrintf(errlogFatal, "seqQueueCreate: out of memory\n");
+        free(q->stamp);
+        free(q->seq);
+        free(q->buffer);
+        free(q);
+        return 0;
+    }
     q->mutex = epicsMutexCreate();
     if (!q->mutex) {
         errlogSevPrintf(errlogFatal, "seqQueueCreate: out of memory\n");
+        free(q->stamp);
+        free(q->seq);
         free(q->buffer);
         free(q);
         return 0;
     }
+    for (i = 0; i < numSlots; i++)
+        seqAtomicInit(q->seq + i, i);
     q->elemSize = elemSize;
     q->numElems = numElems;
-    q->overflow = FALSE;
-    q->rd = q->wr = 0;
+    q->mask = numSlots - 1;
+    seqAtomicInit(&q->head, 0);
+    seqAtomicInit(&q->tail, 0);
+    return q;
+}
+
+static QUEUE create_var(size_t numElems, size_t maxElemSize,
+    size_t numBytes, boolean grow, boolean map)
+{
+    QUEUE q = new(struct seqQueue);
+    size_t maxBytes;
+
+    if (!q) {
+        errlogSevPrintf(errlogFatal, "seqQueueCreateVar: out of memory\n");
+        return 0;
+    }
+    /* check arguments to establish invariants */
+    if (numElems == 0) {
+        errlogSevPrintf(errlogFatal, "seqQueueCreateVar: numElems must be positive\n");
+        free(q);
+        return 0;
+    }
+    if (maxElemSize == 0) {
+        errlogSevPrintf(errlogFatal, "seqQueueCreateVar: maxElemSize must be positive\n");
+        free(q);
+        return 0;
+    }
+    if (numElems > seqQueueMaxNumElems) {
+        errlogSevPrintf(errlogFatal, "seqQueueCreateVar: numElems too large\n");
+        free(q);
+        return 0;
+    }
+    if (grow && !numBytes) {
+        /* enough for numElems elements of maximum size */
+        if (numElems > ((size_t)-1) / varRecSize(maxElemSize))
+            numBytes = (size_t)-1;
+        else
+            numBytes = numElems * varRecSize(maxElemSize);
+    }
+    if (numBytes < varRecSize(maxElemSize)) {
+        errlogSevPrintf(errlogFatal, "seqQueueCreateVar: numBytes too small "
+            "for an element of maximum size\n");
+        free(q);
+        return 0;
+    }
+    /* keep the end of the buffer aligned */
+    maxBytes = numBytes = numBytes / varAlign * varAlign;
+    if (grow)
+        numBytes = min(maxBytes, varGrowInitial * varRecSize(maxElemSize));
+    if (map) {
+        q->buffer = (char *)seqSpillMap(numBytes);
+        if (!q->buffer) {
+            free(q);
+            return 0;
+        }
+        q->mapped = TRUE;
+    } else {
+        DEBUG("%s:%d:calloc(%u,%u)\n",__FILE__,__LINE__,numBytes, 1);
+        q->buffer = (char *)calloc(numBytes, 1);
+        if (!q->buffer) {
+            errlogSevPrintf(errlogFatal, "seqQueueCreateVar: out of memory\n");
+            free(q);
+            return 0;
+        }
+    }
+    q->mutex = epicsMutexCreate();
+    if (!q->mutex) {
+        errlogSevPrintf(errlogFatal, "seqQueueCreateVar: out of memory\n");
+        if (q->mapped)
+            seqSpillUnmap(q->buffer, numBytes);
+        else
+            free(q->buffer);
+        free(q);
+        return 0;
+    }
+    q->elemSize = maxElemSize;
+    q->numElems = numElems;
+    q->numBytes = numBytes;
+    q->maxBytes = maxBytes;
+    q->rd = q->wr = q->last = 0;
+    seqAtomicInit(&q->head, 0);
+    seqAtomicInit(&q->tail, 0);
+    return q;
+}
+
+epicsShareFunc QUEUE seqQueueCreate(size_t numElems, size_t elemSize)
+{
+    return seqQueueCreatePolicy(numElems, elemSize, 0, QP_OVERWRITE_LAST);
+}
+
+epicsShareFunc QUEUE seqQueueCreateVar(size_t numElems, size_t maxElemSize,
+    size_t numBytes)
+{
+    return seqQueueCreatePolicy(numElems, maxElemSize, numBytes,
+        QP_OVERWRITE_LAST);
+}
+
+epicsShareFunc QUEUE seqQueueCreatePolicy(size_t numElems, size_t elemSize,
+    size_t numBytes, enum seqQueuePolicy policy)
+{
+    QUEUE q;
+
+    if (numBytes || policy == QP_GROW)
+        q = create_var(numElems, elemSize, numBytes, policy == QP_GROW, FALSE);
+    else
+        q = create_fixed(numElems, elemSize);
+    if (q)
+        q->policy = policy;
     return q;
 }
 
+epicsShareFunc boolean seqQueueSpill(QUEUE q, size_t numBytes)
+{
+    if (q->spill) {
+        errlogSevPrintf(errlogFatal, "seqQueueSpill: queue already has a spill area\n");
+        return FALSE;
+    }
+    q->spill = create_var(seqQueueMaxNumElems, q->elemSize, numBytes, FALSE, TRUE);
+    if (!q->spill)
+        return FALSE;
+    /* the spill area cannot grow, it overwrites instead */
+    q->spill->policy = q->policy == QP_GROW ? QP_OVERWRITE_LAST : q->policy;
+    q->spill->timed = q->timed;
+    return TRUE;
+}
+
+epicsShareFunc void seqQueueEnableStats(QUEUE q)
+{
+    q->timed = TRUE;
+    if (q->spill)
+        q->spill->timed = TRUE;
+}
+
 epicsShareFunc void seqQueueDestroy(QUEUE q)
 {
+    if (q->spill)
+        seqQueueDestroy(q->spill);
     epicsMutexDestroy(q->mutex);
-    free(q->buffer);
+    free(q->stamp);
+    free(q->seq);
+    if (q->mapped)
+        seqSpillUnmap(q->buffer, q->numBytes);
+    else
+        free(q->buffer);
     free(q);
 }
 
+/* Variable size elements; all of these must be called with the mutex
+   taken. */
+
+/* Number of elements in a variable size queue */
+static size_t var_count(QUEUE q)
+{
+    return (size_t)posDiff(seqAtomicLoad(&q->tail), seqAtomicLoad(&q->head));
+}
+
+/* Whether a record of the given size can be placed at the end of
+   the buffer resp. after the last element, and where */
+static boolean var_fits(QUEUE q, size_t recSize, size_t *pos)
+{
+    if (var_count(q) == 0) {
+        q->rd = q->wr = 0;
+        *pos = 0;
+        return recSize <= q->numBytes;
+    }
+    if (q->wr > q->rd) {
+        /* used space is [rd,wr), free is [wr,numBytes) and [0,rd) */
+        if (recSize <= q->numBytes - q->wr) {
+            *pos = q->wr;
+            return TRUE;
+        }
+        if (recSize <= q->rd) {
+            *pos = 0;
+            return TRUE;
+        }
+        return FALSE;
+    }
+    /* wrapped: free space is [wr,rd) */
+    *pos = q->wr;
+    return recSize <= q->rd - q->wr;
+}
+
+/* Offset of the element at or after off, skipping unused space at
+   the end of the buffer */
+static size_t var_unwrap(QUEUE q, size_t off)
+{
+    if (q->numBytes - off < sizeof(VARHDR) || varHdr(q, off)->size == varWrap)
+        return 0;
+    return off;
+}
+
+/* Remove the last (newest) element */
+static void var_drop_last(QUEUE q)
+{
+    size_t prev = varHdr(q, q->last)->prev;
+
+    seqAtomicStore(&q->tail, seqAtomicLoad(&q->tail) - 1);
+    if (var_count(q) == 0) {
+        q->rd = q->wr = q->last = 0;
+    } else {
+        q->last = prev;
+        q->wr = prev + varRecSize(varHdr(q, prev)->size);
+    }
+}
+
+/* Remove the first (oldest) element */
+static void var_drop_first(QUEUE q)
+{
+    q->rd = var_unwrap(q, q->rd);
+    q->rd += varRecSize(varHdr(q, q->rd)->size);
+    seqAtomicStore(&q->head, seqAtomicLoad(&q->head) + 1);
+    if (var_count(q) == 0)
+        q->rd = q->wr = q->last = 0;
+    else
+        q->rd = var_unwrap(q, q->rd);
+}
+
+/* Replace the buffer with one of twice the size (at most maxBytes),
+   copying the elements to its beginning. Return whether successful. */
+static boolean var_grow(QUEUE q)
+{
+    size_t numBytes, n, off, pos = 0, prev = 0;
+    char *buffer;
+
+    if (q->numBytes >= q->maxBytes)
+        return FALSE;
+    numBytes = q->numBytes > q->maxBytes / 2 ? q->maxBytes : 2 * q->numBytes;
+    DEBUG("%s:%d:calloc(%u,%u)\n",__FILE__,__LINE__,numBytes, 1);
+    buffer = (char *)calloc(numBytes, 1);
+    if (!buffer)
+        return FALSE;
+    for (n = var_count(q), off = q->rd; n > 0; n--) {
+        VARHDR *hdr;
+        size_t recSize;
+
+        off = var_unwrap(q, off);
+        hdr = varHdr(q, off);
+        recSize = varRecSize(hdr->size);
+        memcpy(buffer + pos, hdr, recSize);
+        ((VARHDR *)(buffer + pos))->prev = prev;
+        prev = pos;
+        pos += recSize;
+        off += recSize;
+    }
+    free(q->buffer);
+    q->buffer = buffer;
+    q->numBytes = numBytes;
+    q->rd = 0;
+    q->wr = pos;
+    q->last = prev;
+    return TRUE;
+}
+
+/* Raise an atomic counter to n, if it is less */
+static void update_max(seqAtomicSize *p, size_t n)
+{
+    size_t old = seqAtomicLoad(p);
+
+    while (n > old) {
+        size_t prev = seqAtomicCas(p, old, n);
+
+        if (prev == old)
+            break;
+        old = prev;
+    }
+}
+
+/* Histogram bucket for an element put at the given time, and the
+   time it spent in the queue in microseconds (saturating) */
+static unsigned age_bucket(double stamp, double now, size_t *us)
+{
+    double age = now - stamp, limit = 1e-6;
+    unsigned b;
+
+    if (age < 0)
+        age = 0;
+    *us = age * 1e6 >= (double)(size_t)-1 ? (size_t)-1 : (size_t)(age * 1e6);
+    for (b = 0; b < seqQueueNumAgeBuckets - 1 && age >= limit; b++)
+        limit *= 10;
+    return b;
+}
+
+/* Count a consumed element that was put at the given time */
+static void record_age(QUEUE q, double stamp, double now)
+{
+    size_t us;
+    unsigned b = age_bucket(stamp, now, &us);
+
+    (void)seqAtomicAdd(q->ageHist + b, 1);
+    update_max(&q->maxAge, us);
+}
+
+/* Make room for an element of the given size, applying the policy if
+   the queue is full, and return where to put it, or NULL if the new
+   element is to be discarded. For a reservation (only), room is made
+   solely by removing the first element or by growing. */
+static void *var_reserve(QUEUE q, size_t size, boolean reserve, boolean *lost)
+{
+    size_t recSize = varRecSize(size);
+    size_t pos;
+
+    /* the queue is empty at the latest, and then the element fits */
+    while (var_count(q) == q->numElems || !var_fits(q, recSize, &pos)) {
+        if (q->policy == QP_GROW && var_count(q) < q->numElems && var_grow(q))
+            continue;
+        if (reserve && (q->policy != QP_DROP_OLDEST || q->spill))
+            return NULL;
+        (void)seqAtomicAdd(&q->lost, 1);
+        *lost = TRUE;
+        if (q->policy == QP_DROP_NEWEST)
+            return NULL;
+        else if (q->policy == QP_DROP_OLDEST)
+            var_drop_first(q);
+        else
+            var_drop_last(q);
+    }
+    if (pos == 0 && q->wr != 0 && q->numBytes - q->wr >= sizeof(VARHDR)) {
+        /* mark the rest of the buffer as unused */
+        varHdr(q, q->wr)->size = varWrap;
+    }
+    varHdr(q, pos)->size = size;
+    varHdr(q, pos)->prev = q->last;
+    return varHdr(q, pos) + 1;
+}
+
+/* Append an element placed by var_reserve, with its actual size
+   (which may be less than reserved) */
+static void var_commit(QUEUE q, void *elem, size_t size)
+{
+    VARHDR *hdr = (VARHDR *)elem - 1;
+    size_t pos = (size_t)((char *)hdr - q->buffer);
+
+    hdr->size = size;
+    hdr->stamp = put_stamp(q);
+    q->last = pos;
+    q->wr = pos + varRecSize(size);
+    seqAtomicStore(&q->tail, seqAtomicLoad(&q->tail) + 1);
+    update_max(&q->highWater, var_count(q));
+}
+
+static boolean var_put(QUEUE q, seqQueueFunc *put, const void *arg, size_t size)
+{
+    boolean lost = FALSE;
+    void *elem;
+
+    epicsMutexMustLock(q->mutex);
+    if (!q->spill)
+        elem = var_reserve(q, size, FALSE, &lost);
+    else if (var_count(q->spill) == 0)
+        elem = var_reserve(q, size, TRUE, &lost);
+    else
+        elem = 0;
+    if (elem) {
+        put(elem, arg, size);
+        var_commit(q, elem, size);
+    } else if (q->spill) {
+        lost = seqQueuePutN(q->spill, put, arg, size);
+    }
+    epicsMutexUnlock(q->mutex);
+    return lost;
+}
+
+static size_t var_get(QUEUE q, seqQueueFunc *get, void *arg, size_t n,
+    boolean record)
+{
+    double now;
+    size_t num;
+
+    record = record && q->timed;
+    now = record ? now_sec() : 0;
+    epicsMutexMustLock(q->mutex);
+    for (num = 0; num < n && var_count(q) > 0; num++) {
+        VARHDR *hdr;
+
+        q->rd = var_unwrap(q, q->rd);
+        hdr = varHdr(q, q->rd);
+        get(arg, hdr + 1, hdr->size);
+        if (record)
+            record_age(q, hdr->stamp, now);
+        var_drop_first(q);
+    }
+    epicsMutexUnlock(q->mutex);
+    return num;
+}
+
+static void var_flush(QUEUE q)
+{
+    epicsMutexMustLock(q->mutex);
+    seqAtomicStore(&q->head, seqAtomicLoad(&q->tail));
+    q->rd = q->wr = q->last = 0;
+    epicsMutexUnlock(q->mutex);
+}
+
 epicsShareFunc boolean seqQueueGet(QUEUE q, void *value)
 {
     return seqQueueGetF(q, memcpy, value);
 }
 
+/* Claim the first element of a fixed size queue for reading; return
+   FALSE if the queue is empty. */
+static boolean claim_first(QUEUE q, size_t *ppos)
+{
+    size_t pos;
+
+    for (;;) {
+        ptrdiff_t dif;
+
+        pos = seqAtomicLoad(&q->head);
+        dif = posDiff(seqAtomicLoadAcq(slotSeq(q, pos)), pos + 1);
+        if (dif == 0) {
+            if (seqAtomicCas(&q->head, pos, pos + 1) == pos)
+                break;
+        } else if (dif < 0) {
+            /* not (yet) written, or being overwritten */
+            return FALSE;
+        }
+        /* else another consumer was faster, try again */
+    }
+    /* wait until a concurrent overwrite of this element is done */
+    while (seqAtomicLoadAcq(slotSeq(q, pos)) != pos + 1)
+        epicsThreadSleep(0.0);
+    *ppos = pos;
+    return TRUE;
+}
+
+/* Whether the spill area has elements; to be called before looking
+   at the queue itself, see spill_next */
+static boolean spilled(QUEUE q)
+{
+    return q->spill && used(q->spill) > 0;
+}
+
+/* Whether a get that found the queue empty should continue in the
+   spill area, given the result of spilled() beforehand */
+static boolean spill_next(QUEUE q, boolean wasSpilled)
+{
+    return wasSpilled && used(q) == 0;
+}
+
+/* Remove the first element, like seqQueueGetF; record its residence
+   time only if record is TRUE */
+static boolean get_first(QUEUE q, seqQueueFunc *get, void *arg, boolean record)
+{
+    boolean wasSpilled = spilled(q);
+    size_t pos;
+
+    if (q->numBytes) {
+        if (var_get(q, get, arg, 1, record) == 1)
+            return FALSE;
+    } else if (claim_first(q, &pos)) {
+        double stamp = *slotStamp(q, pos);
+
+        get(arg, slotPtr(q, pos), q->elemSize);
+        seqAtomicStoreRel(slotSeq(q, pos), pos + q->mask + 1);
+        if (record && q->timed)
+            record_age(q, stamp, now_sec());
+        return FALSE;
+    }
+    if (spill_next(q, wasSpilled))
+        return get_first(q->spill, get, arg, record);
+    return TRUE;
+}
+
 epicsShareFunc boolean seqQueueGetF(QUEUE q, seqQueueFunc *get, void *arg)
 {
-    if (q->wr == q->rd) {
-        if (!q->overflow) {
-            return TRUE;
+    return get_first(q, get, arg, TRUE);
+}
+
+epicsShareFunc void *seqQueuePeek(QUEUE q, size_t *size)
+{
+    boolean wasSpilled = spilled(q);
+    size_t pos;
+
+    if (q->numBytes) {
+        VARHDR *hdr;
+
+        epicsMutexMustLock(q->mutex);
+        if (var_count(q) == 0) {
+            epicsMutexUnlock(q->mutex);
+            return spill_next(q, wasSpilled) ? seqQueuePeek(q->spill, size) : NULL;
         }
-        epicsMutexLock(q->mutex);
-        get(arg, q->buffer + q->rd * q->elemSize, q->elemSize);
-        /* check again, a put might have intervened */
-        if (q->wr == q->rd && q->overflow)
-            q->overflow = FALSE;
-        else
-            q->rd = (q->rd + 1) % q->numElems;
+        q->rd = var_unwrap(q, q->rd);
+        hdr = varHdr(q, q->rd);
+        if (q->timed)
+            record_age(q, hdr->stamp, now_sec());
+        if (size)
+            *size = hdr->size;
+        return hdr + 1;
+    }
+    if (!claim_first(q, &pos))
+        return spill_next(q, wasSpilled) ? seqQueuePeek(q->spill, size) : NULL;
+    if (q->timed)
+        record_age(q, *slotStamp(q, pos), now_sec());
+    if (size)
+        *size = q->elemSize;
+    return slotPtr(q, pos);
+}
+
+epicsShareFunc void seqQueueRelease(QUEUE q, void *elem)
+{
+    if (q->spill && (char *)elem >= q->spill->buffer
+        && (char *)elem < q->spill->buffer + q->spill->numBytes) {
+        seqQueueRelease(q->spill, elem);
+    } else if (q->numBytes) {
+        var_drop_first(q);
         epicsMutexUnlock(q->mutex);
     } else {
-        get(arg, q->buffer + q->rd * q->elemSize, q->elemSize);
-        q->rd = (q->rd + 1) % q->numElems;
+        seqAtomicSize *seq = q->seq + ((char *)elem - q->buffer) / q->elemSize;
+
+        /* a claimed slot's sequence number is pos+1 */
+        seqAtomicStoreRel(seq, seqAtomicLoad(seq) + q->mask);
     }
-    return FALSE;
+}
+
+static void *no_copy(void *dest, const void *src, size_t elemSize)
+{
+    return dest;
+}
+
+/* Call get for the first element, if any, and store the time of its
+   put in *stamp; return whether there was an element. Does not look
+   at the spill area. */
+static boolean first(QUEUE q, seqQueueFunc *get, void *arg, double *stamp)
+{
+    boolean found = FALSE;
+
+    epicsMutexMustLock(q->mutex);
+    if (q->numBytes) {
+        if (var_count(q) > 0) {
+            VARHDR *hdr;
+
+            q->rd = var_unwrap(q, q->rd);
+            hdr = varHdr(q, q->rd);
+            get(arg, hdr + 1, hdr->size);
+            *stamp = hdr->stamp;
+            found = TRUE;
+        }
+    } else {
+        /* The mutex keeps overwriting producers away. A consumer may
+           still remove the element while we look at it, and once it
+           releases the slot, a producer may write to it; this is
+           detected by checking the sequence number afterwards. */
+        for (;;) {
+            size_t pos = seqAtomicLoad(&q->head);
+            ptrdiff_t dif = posDiff(seqAtomicLoadAcq(slotSeq(q, pos)), pos + 1);
+
+            if (dif < 0)
+                break;
+            if (dif == 0) {
+                get(arg, slotPtr(q, pos), q->elemSize);
+                *stamp = *slotStamp(q, pos);
+                seqAtomicFenceAcq();
+                if (seqAtomicLoad(slotSeq(q, pos)) == pos + 1) {
+                    found = TRUE;
+                    break;
+                }
+            }
+            /* else another consumer was faster, try again */
+        }
+    }
+    epicsMutexUnlock(q->mutex);
+    return found;
+}
+
+epicsShareFunc boolean seqQueueFirstF(QUEUE q, seqQueueFunc *get, void *arg)
+{
+    boolean wasSpilled = spilled(q);
+    double stamp;
+
+    if (first(q, get, arg, &stamp))
+        return FALSE;
+    if (spill_next(q, wasSpilled))
+        return seqQueueFirstF(q->spill, get, arg);
+    return TRUE;
+}
+
+/* Copy elements to consecutive memory, advancing the destination
+   pointer (which is passed by reference). */
+static void *batch_cp(void *dest, const void *src, size_t elemSize)
+{
+    char **pp = (char **)dest;
+    char *p = *pp;
+
+    *pp += elemSize;
+    return memcpy(p, src, elemSize);
+}
+
+epicsShareFunc size_t seqQueueGetBatch(QUEUE q, void *values, size_t n)
+{
+    char *p = (char *)values;
+
+    return seqQueueGetBatchF(q, batch_cp, &p, n);
+}
+
+static size_t get_batch(QUEUE q, seqQueueFunc *get, void *arg, size_t n)
+{
+    size_t pos, num, i, maxAge = 0;
+    size_t hist[seqQueueNumAgeBuckets];
+    unsigned b;
+    double now;
+
+    if (n == 0)
+        return 0;
+    if (n > q->numElems)
+        n = q->numElems;
+    if (q->numBytes)
+        return var_get(q, get, arg, n, TRUE);
+    for (;;) {
+        ptrdiff_t dif;
+
+        pos = seqAtomicLoad(&q->head);
+        dif = posDiff(seqAtomicLoadAcq(slotSeq(q, pos)), pos + 1);
+        if (dif == 0) {
+            /* count consecutive published elements */
+            for (num = 1; num < n; num++) {
+                if (seqAtomicLoadAcq(slotSeq(q, pos + num)) != pos + num + 1)
+                    break;
+            }
+            /* claim them all at once */
+            if (seqAtomicCas(&q->head, pos, pos + num) == pos)
+                break;
+        } else if (dif < 0) {
+            /* not (yet) written, or being overwritten */
+            return 0;
+        }
+        /* else another consumer was faster, try again */
+    }
+    /* collect the statistics locally, to touch the counters only once */
+    memset(hist, 0, sizeof(hist));
+    now = q->timed ? now_sec() : 0;
+    for (i = pos; i != pos + num; i++) {
+        /* wait until a concurrent overwrite of this element is done */
+        while (seqAtomicLoadAcq(slotSeq(q, i)) != i + 1)
+            epicsThreadSleep(0.0);
+        if (q->timed) {
+            size_t us;
+
+            hist[age_bucket(*slotStamp(q, i), now, &us)]++;
+            if (us > maxAge)
+                maxAge = us;
+        }
+        get(arg, slotPtr(q, i), q->elemSize);
+        seqAtomicStoreRel(slotSeq(q, i), i + q->mask + 1);
+    }
+    if (!q->timed)
+        return num;
+    for (b = 0; b < seqQueueNumAgeBuckets; b++) {
+        if (hist[b])
+            (void)seqAtomicAdd(q->ageHist + b, hist[b]);
+    }
+    update_max(&q->maxAge, maxAge);
+    return num;
 }
 
 epicsShareFunc boolean seqQueuePut(QUEUE q, const void *value)
@@ -110,49 +895,226 @@ epicsShareFunc boolean seqQueuePut(QUEUE q, const void *value)
     return seqQueuePutF(q, memcpy, value);
 }
 
+epicsShareFunc size_t seqQueueGetBatchF(QUEUE q, seqQueueFunc *get, void *arg,
+    size_t n)
+{
+    boolean wasSpilled = spilled(q);
+    size_t num = get_batch(q, get, arg, n);
+
+    if (num < n && spill_next(q, wasSpilled))
+        num += get_batch(q->spill, get, arg, n - num);
+    return num;
+}
+
+/* Overwrite the last element of a full queue. Return FALSE if the
+   queue turned out not to be full, so that the caller should retry
+   a normal put. */
+static boolean overwrite_last(QUEUE q, seqQueueFunc *put, const void *arg,
+    size_t size)
+{
+    boolean done = FALSE;
+
+    epicsMutexMustLock(q->mutex);
+    for (;;) {
+        size_t tail = seqAtomicLoad(&q->tail);
+        size_t last = tail - 1;
+        size_t head = seqAtomicLoad(&q->head);
+
+        if ((size_t)posDiff(tail, head) < q->numElems)
+            break;
+        /* take the last slot away from consumers; fails if the
+           producer that claimed it has not yet published it */
+        if (seqAtomicCas(slotSeq(q, last), last + 1, last) != last + 1) {
+            epicsThreadSleep(0.0);
+            continue;
+        }
+        /* a consumer or producer may have intervened meanwhile */
+        if (seqAtomicLoad(&q->tail) != tail ||
+            (size_t)posDiff(tail, seqAtomicLoad(&q->head)) < q->numElems) {
+            seqAtomicStoreRel(slotSeq(q, last), last + 1);
+            continue;
+        }
+        put(slotPtr(q, last), arg, size);
+        *slotStamp(q, last) = put_stamp(q);
+        seqAtomicStoreRel(slotSeq(q, last), last + 1);
+        (void)seqAtomicAdd(&q->lost, 1);
+        done = TRUE;
+        break;
+    }
+    epicsMutexUnlock(q->mutex);
+    return done;
+}
+
+/* Remove the first element of a full queue as a consumer would;
+   return whether an element was removed */
+static boolean drop_first(QUEUE q)
+{
+    if (used(q) == q->numElems && !get_first(q, no_copy, 0, FALSE)) {
+        (void)seqAtomicAdd(&q->lost, 1);
+        return TRUE;
+    }
+    return FALSE;
+}
+
+/* Put to the spill area, or apply the queue's policy, when a put found
+   the queue full. Return FALSE if the caller should retry a normal put;
+   set *lost if an element was lost. */
+static boolean put_full(QUEUE q, seqQueueFunc *put, const void *arg,
+    size_t size, boolean *lost)
+{
+    if (q->spill) {
+        if (used(q) < q->numElems)
+            return FALSE;
+        *lost = seqQueuePutN(q->spill, put, arg, size);
+        return TRUE;
+    }
+    switch (q->policy) {
+    case QP_DROP_NEWEST:
+        if (used(q) < q->numElems)
+            return FALSE;
+        (void)seqAtomicAdd(&q->lost, 1);
+        *lost = TRUE;
+        return TRUE;
+    case QP_DROP_OLDEST:
+        /* make room, then retry */
+        if (drop_first(q))
+            *lost = TRUE;
+        return FALSE;
+    default:
+        if (!overwrite_last(q, put, arg, size))
+            return FALSE;
+        *lost = TRUE;
+        return TRUE;
+    }
+}
+
 epicsShareFunc boolean seqQueuePutF(QUEUE q, seqQueueFunc *put, const void *arg)
 {
-    boolean r = FALSE;
+    return seqQueuePutN(q, put, arg, q->elemSize);
+}
 
-    if (q->overflow || (q->wr + 1) % q->numElems == q->rd) {
-        epicsMutexLock(q->mutex);
-        if ((q->wr + 1) % q->numElems == q->rd) {
-            if (q->overflow) {
-                r = TRUE;   /* we will overwrite the last element */
-            }
-            q->overflow = TRUE;
-        } else if (q->overflow) {
-            /* we had a get since the last put, so
-               can now eliminate overflow flag and instead
-               increment the write pointer */
-            q->wr = (q->wr + 1) % q->numElems;
-            if ((q->wr + 1) % q->numElems != q->rd) {
-                q->overflow = FALSE;
+epicsShareFunc boolean seqQueuePutN(QUEUE q, seqQueueFunc *put, const void *arg,
+    size_t size)
+{
+    boolean lost = FALSE;
+    unsigned spins = 0;
+
+    assert(size <= q->elemSize);
+    if (q->numBytes)
+        return var_put(q, put, arg, size);
+    /* keep the order: once spilling, continue until the spill area is empty */
+    if (q->spill && used(q->spill) > 0)
+        return seqQueuePutN(q->spill, put, arg, size);
+    for (;;) {
+        size_t pos = seqAtomicLoad(&q->tail);
+        ptrdiff_t dif = posDiff(seqAtomicLoadAcq(slotSeq(q, pos)), pos);
+
+        if (dif == 0) {
+            if ((size_t)posDiff(pos, seqAtomicLoad(&q->head)) >= q->numElems) {
+                if (put_full(q, put, arg, size, &lost))
+                    return lost;
+            } else if (seqAtomicCas(&q->tail, pos, pos + 1) == pos) {
+                ptrdiff_t n;
+
+                put(slotPtr(q, pos), arg, size);
+                *slotStamp(q, pos) = put_stamp(q);
+                seqAtomicStoreRel(slotSeq(q, pos), pos + 1);
+                n = posDiff(pos + 1, seqAtomicLoad(&q->head));
+                if (n > 0)
+                    update_max(&q->highWater, (size_t)n);
+                return lost;
             }
+        } else if (dif < 0) {
+            /* slot not yet released by the consumer of the previous
+               round; this means the queue is full, or nearly so */
+            if (put_full(q, put, arg, size, &lost))
+                return lost;
+            put_backoff(&spins);
         }
-        put(q->buffer + q->wr * q->elemSize, arg, q->elemSize);
-        if (!q->overflow) {
-            q->wr = (q->wr + 1) % q->numElems;
+        /* else another producer was faster, try again */
+    }
+}
+
+epicsShareFunc void *seqQueueReserve(QUEUE q, size_t size)
+{
+    unsigned spins = 0;
+
+    assert(size <= q->elemSize);
+    /* a put must go to the spill area then */
+    if (q->spill && used(q->spill) > 0)
+        return NULL;
+    if (q->numBytes) {
+        boolean lost = FALSE;
+        void *elem;
+
+        epicsMutexMustLock(q->mutex);
+        elem = var_reserve(q, size, TRUE, &lost);
+        if (!elem)
+            epicsMutexUnlock(q->mutex);
+        return elem;
+    }
+    for (;;) {
+        size_t pos = seqAtomicLoad(&q->tail);
+        ptrdiff_t dif = posDiff(seqAtomicLoadAcq(slotSeq(q, pos)), pos);
+
+        if (dif == 0 && (size_t)posDiff(pos, seqAtomicLoad(&q->head)) < q->numElems) {
+            if (seqAtomicCas(&q->tail, pos, pos + 1) == pos)
+                return slotPtr(q, pos);
+        } else if (dif <= 0 && used(q) == q->numElems) {
+            if (q->policy != QP_DROP_OLDEST || q->spill)
+                return NULL;
+            drop_first(q);
+        } else if (dif <= 0) {
+            /* a consumer has not yet released the slot */
+            put_backoff(&spins);
         }
+        /* else another producer was faster; try again */
+    }
+}
+
+epicsShareFunc void seqQueueCommit(QUEUE q, void *elem, size_t size)
+{
+    if (q->numBytes) {
+        var_commit(q, elem, size);
         epicsMutexUnlock(q->mutex);
     } else {
-        put(q->buffer + q->wr * q->elemSize, arg, q->elemSize);
-        q->wr = (q->wr + 1) % q->numElems;
+        seqAtomicSize *seq = q->seq + ((char *)elem - q->buffer) / q->elemSize;
+        /* a reserved slot's sequence number is its position */
+        size_t pos = seqAtomicLoad(seq);
+        ptrdiff_t n;
+
+        *slotStamp(q, pos) = put_stamp(q);
+        seqAtomicStoreRel(seq, pos + 1);
+        n = posDiff(pos + 1, seqAtomicLoad(&q->head));
+        if (n > 0)
+            update_max(&q->highWater, (size_t)n);
     }
-    return r;
 }
 
 epicsShareFunc void seqQueueFlush(QUEUE q)
 {
-    epicsMutexLock(q->mutex);
-    q->rd = q->wr;
-    q->overflow = FALSE;
-    epicsMutexUnlock(q->mutex);
+    size_t n = used(q);
+
+    if (q->spill)
+        seqQueueFlush(q->spill);
+    if (q->numBytes) {
+        var_flush(q);
+        return;
+    }
+    /* remove only what is there now, concurrent puts may follow */
+    while (n-- > 0 && !get_first(q, no_copy, 0, FALSE))
+        ;
 }
 
 static size_t used(const QUEUE q)
 {
-    return (q->numElems + q->wr - q->rd) % q->numElems + (q->overflow ? 1 : 0);
+    size_t head = seqAtomicLoad(&q->head);
+    ptrdiff_t n = posDiff(seqAtomicLoad(&q->tail), head);
+
+    /* head may have moved past the tail we read */
+    if (n < 0)
+        return 0;
+    return (size_t)n > q->numElems ? q->numElems : (size_t)n;
 }
 
 epicsShareFunc size_t seqQueueFree(const QUEUE q)
@@ -162,17 +1124,17 @@ epicsShareFunc size_t seqQueueFree(const QUEUE q)
 
 epicsShareFunc size_t seqQueueUsed(const QUEUE q)
 {
-    return used(q);
+    return used(q) + (q->spill ? used(q->spill) : 0);
 }
 
 epicsShareFunc boolean seqQueueIsEmpty(const QUEUE q)
 {
-    return q->wr == q->rd && !q->overflow;
+    return seqQueueUsed(q) == 0;
 }
 
 epicsShareFunc boolean seqQueueIsFull(const QUEUE q)
 {
-    return (q->wr + 1) % q->numElems == q->rd && q->overflow;
+    return used(q) == q->numElems;
 }
 
 epicsShareFunc size_t seqQueueNumElems(const QUEUE q)
@@ -184,3 +1146,94 @@ epicsShareFunc size_t seqQueueElemSize(const QUEUE q)
 {
     return q->elemSize;
 }
+
+epicsShareFunc size_t seqQueueNumBytes(const QUEUE q)
+{
+    return q->numBytes;
+}
+
+epicsShareFunc size_t seqQueueMaxBytes(const QUEUE q)
+{
+    return q->maxBytes;
+}
+
+epicsShareFunc enum seqQueuePolicy seqQueueGetPolicy(const QUEUE q)
+{
+    return q->policy;
+}
+
+epicsShareFunc size_t seqQueueLost(const QUEUE q)
+{
+    return seqAtomicLoad(&q->lost) + (q->spill ? seqQueueLost(q->spill) : 0);
+}
+
+epicsShareFunc QUEUE seqQueueSpillArea(const QUEUE q)
+{
+    return q->spill;
+}
+
+epicsShareFunc size_t seqQueueHighWater(const QUEUE q)
+{
+    return seqAtomicLoad(&q->highWater);
+}
+
+/* Add the consumer statistics of q to stats */
+static void add_ages(QUEUE q, seqQueueStats *stats)
+{
+    double maxAge = seqAtomicLoad(&q->maxAge) * 1e-6;
+    unsigned b;
+
+    for (b = 0; b < seqQueueNumAgeBuckets; b++) {
+        size_t n = seqAtomicLoad(q->ageHist + b);
+
+        stats->ageHist[b] += n;
+        stats->removed += n;
+    }
+    if (maxAge > stats->maxAge)
+        stats->maxAge = maxAge;
+}
+
+epicsShareFunc void seqQueueGetStats(QUEUE q, seqQueueStats *stats)
+{
+    double stamp;
+
+    memset(stats, 0, sizeof(seqQueueStats));
+    stats->numElems = q->numElems;
+    stats->used = seqQueueUsed(q);
+    stats->lost = seqQueueLost(q);
+    stats->highWater = seqQueueHighWater(q);
+    stats->timed = q->timed;
+    if (!q->timed)
+        return;
+    add_ages(q, stats);
+    if (q->spill)
+        add_ages(q->spill, stats);
+    /* elements in the spill area are newer than those in the queue */
+    if (first(q, no_copy, 0, &stamp)
+        || (q->spill && first(q->spill, no_copy, 0, &stamp))) {
+        stats->oldestAge = now_sec() - stamp;
+        if (stats->oldestAge < 0)
+            stats->oldestAge = 0;
+    }
+}
+
+epicsShareFunc size_t seqQueueReportLost(QUEUE q, double interval)
+{
+    epicsTimeStamp now;
+    size_t n = 0;
+
+    /* never block a producer just for reporting */
+    if (epicsMutexTryLock(q->mutex) != epicsMutexLockOK)
+        return 0;
+    epicsTimeGetCurrent(&now);
+    if (epicsTimeDiffInSeconds(&now, &q->lastReport) >= interval) {
+        size_t lost = seqQueueLost(q);
+
+        n = lost - q->reported;
+        q->reported = lost;
+        if (n > 0)
+            q->lastReport = now;
+    }
+    epicsMutexUnlock(q->mutex);
+    return n;
+}
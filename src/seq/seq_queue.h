@@ -7,21 +7,51 @@ in the file LICENSE that is included with this distribution.
 /*************************************************************************\
 This module implements fifo queues, similar to and inspired by
 epicsRingBytes, but with a fixed element size and such that a put
-overwrites the last element if the queue is full. Put and get
-operations always work on a single element.
+overwrites the last element if the queue is full. Put operations
+always work on a single element; get operations can also remove
+several elements at once.
 
-The implementation allows one reader and one writer to access the queue
-without taking a mutex, except where unavoidable, i.e. when the queue is
-full.
+The implementation allows any number of readers and writers to access
+the queue concurrently. It is lock-free, except that a put to a full
+queue (which overwrites the last element) takes a mutex. Note that the
+buffer is allocated with the number of elements rounded up to the next
+power of two.
+
+Alternatively, a queue can store elements of varying size (up to a
+maximum) in a buffer with a given number of bytes, so that memory is
+not wasted on elements that are smaller than the maximum. Such queues
+are protected by a mutex, but never allocate memory after creation.
+If a put finds no room for the new element, it overwrites the last
+element, and if that is not enough, removes further elements from the
+end of the queue.
+
+What a put does if the queue is full can be chosen on creation (see
+enum seqQueuePolicy). A queue that grows always stores elements of
+varying size; it starts small and doubles its buffer when needed, up
+to a limit. Queues count the elements lost and remember the maximum
+number of elements ever used. If turned on (seqQueueEnableStats), each
+element is time stamped when put, so that gets can keep a histogram of
+how long elements stayed in the queue (see seqQueueGetStats).
+
+A queue can be given a spill area in a memory mapped file, which takes
+further elements when the queue is full, and from which gets continue
+transparently once the queue is empty.
 \*************************************************************************/
 #ifndef INCLseq_queueh
 #define INCLseq_queueh
 
+#include "seqStats.h"
+
 typedef struct seqQueue *QUEUE;
 
 /* to avoid overflow when calculating next put/get positions */
 #define seqQueueMaxNumElems (((size_t)-1)>>1)
 
+/* bytes needed per element of a queue for elements of varying
+   size, in addition to the element's data (rounded up to a
+   multiple of sizeof(double)) */
+#define seqQueueVarOverhead (2*sizeof(size_t)+sizeof(double))
+
 /* Create a new queue with the given element size and
    number of elements and return it, if successful,
    otherwise return NULL.
@@ -32,6 +62,40 @@ typedef struct seqQueue *QUEUE;
 */
 epicsShareFunc QUEUE seqQueueCreate(size_t numElems, size_t elemSize);
 
+/* Create a new queue for elements of varying size, with
+   at most numElems elements of at most maxElemSize bytes,
+   stored in a buffer of numBytes bytes. Return it, if
+   successful, otherwise return NULL.
+   Restrictions as for seqQueueCreate, and additionally
+      numBytes must be large enough for an element
+      of maxElemSize bytes plus seqQueueVarOverhead
+*/
+epicsShareFunc QUEUE seqQueueCreateVar(size_t numElems, size_t maxElemSize,
+    size_t numBytes);
+
+/* Create a new queue with the given policy for puts to a
+   full queue. If numBytes is non-zero, or the policy is
+   QP_GROW, elements are of varying size. A growing queue
+   holds at most numBytes bytes, or if numBytes is zero,
+   enough for numElems elements of maximum size.
+   seqQueueCreate(n,s) == seqQueueCreatePolicy(n,s,0,QP_OVERWRITE_LAST)
+   */
+epicsShareFunc QUEUE seqQueueCreatePolicy(size_t numElems, size_t elemSize,
+    size_t numBytes, enum seqQueuePolicy policy);
+
+/* Add a spill area of numBytes bytes to a new queue, before
+   it is used. When the queue is full, puts go to the spill
+   area, which stores elements of varying size like a queue
+   created with seqQueueCreateVar; when the spill area is
+   full too, the queue's policy applies there. Return
+   whether successful; this fails on systems without
+   memory mapped files. */
+epicsShareFunc boolean seqQueueSpill(QUEUE q, size_t numBytes);
+
+/* Turn on residence time statistics for a new queue, before
+   it is used. This costs two reads of the clock per element. */
+epicsShareFunc void seqQueueEnableStats(QUEUE q);
+
 /* Return whether all invariants are satisfied */
 epicsShareFunc boolean seqQueueInvariant(QUEUE q);
 
@@ -45,7 +109,7 @@ epicsShareFunc boolean seqQueueInvariant(QUEUE q);
 
    Note that seqQueueGet returns FALSE on success and
    that seqQueuePut returns FALSE if no element was
-   overwritten. */
+   lost. */
 
 /* Destroy the queue, freeing all memory. */
 epicsShareFunc void seqQueueDestroy(QUEUE q);
@@ -57,9 +121,18 @@ epicsShareFunc void seqQueueDestroy(QUEUE q);
    bytes. */
 epicsShareFunc boolean seqQueueGet(QUEUE q, void *value);
 
+/* Get up to n elements from the queue at once and return
+   how many were available. The values argument must point
+   to a memory area with at least n*seqQueueElemSize(q)
+   bytes; the elements are stored consecutively, oldest
+   first. */
+epicsShareFunc size_t seqQueueGetBatch(QUEUE q, void *values, size_t n);
+
 /* Put an element into the queue. Return whether the
-   queue was full and therefore its last element was
-   overwritten. The value argument must point to a
+   queue was full and therefore an element was lost:
+   depending on the policy, the last element was
+   overwritten, the first removed, or the new one
+   discarded. The value argument must point to a
    memory area with at least seqQueueElemSize(q)
    bytes. */
 epicsShareFunc boolean seqQueuePut(QUEUE q, const void *value);
@@ -67,22 +140,60 @@ epicsShareFunc boolean seqQueuePut(QUEUE q, const void *value);
 /* Remove all elements. Cheap. */
 epicsShareFunc void seqQueueFlush(QUEUE q);
 
-/* How many free elements are left. */
+/* How many free elements are left (not counting a spill area). */
 epicsShareFunc size_t seqQueueFree(const QUEUE q);
 
-/* How many elements are used up. */
+/* How many elements are used up, including a spill area. */
 epicsShareFunc size_t seqQueueUsed(const QUEUE q);
 
 /* Number of elements (fixed on construction). */
 epicsShareFunc size_t seqQueueNumElems(const QUEUE q);
 
-/* Element size (fixed on construction). */
+/* Element size (fixed on construction). For queues
+   with elements of varying size, the maximum size. */
 epicsShareFunc size_t seqQueueElemSize(const QUEUE q);
 
+/* Buffer size in bytes for queues with elements of
+   varying size, 0 for all others. */
+epicsShareFunc size_t seqQueueNumBytes(const QUEUE q);
+
+/* Limit for the buffer size of a growing queue; for
+   other queues with elements of varying size the same
+   as seqQueueNumBytes. */
+epicsShareFunc size_t seqQueueMaxBytes(const QUEUE q);
+
+/* Policy for puts to a full queue (fixed on construction). */
+epicsShareFunc enum seqQueuePolicy seqQueueGetPolicy(const QUEUE q);
+
+/* The spill area as a queue of its own, for inspection
+   only, or NULL if there is none. */
+epicsShareFunc QUEUE seqQueueSpillArea(const QUEUE q);
+
+/* How many elements were lost since creation. */
+epicsShareFunc size_t seqQueueLost(const QUEUE q);
+
+/* Maximum number of elements used since creation. */
+epicsShareFunc size_t seqQueueHighWater(const QUEUE q);
+
+/* Fill in statistics for the queue, including its spill area.
+   Residence times count elements removed by a get, batch get,
+   or peek, from their put (or commit) on; elements removed by
+   a flush or to make room for others are not counted. They
+   (and removed) are only recorded if statistics have been
+   turned on with seqQueueEnableStats, otherwise they are 0. */
+epicsShareFunc void seqQueueGetStats(QUEUE q, seqQueueStats *stats);
+
+/* Return how many elements were lost since the last time
+   this returned non-zero, but only if that was at least
+   interval seconds ago; otherwise return 0. Meant to rate
+   limit error messages about overflowing queues. */
+epicsShareFunc size_t seqQueueReportLost(QUEUE q, double interval);
+
 /* Whether empty, same as seqQueueUsed(q)==0 */
 epicsShareFunc boolean seqQueueIsEmpty(const QUEUE q);
 
-/* Whether full, same as seqQueueFree(q)==0 */
+/* Whether full, same as seqQueueFree(q)==0; a queue with
+   a spill area still accepts elements then */
 epicsShareFunc boolean seqQueueIsFull(const QUEUE q);
 
 
@@ -90,14 +201,68 @@ epicsShareFunc boolean seqQueueIsFull(const QUEUE q);
 typedef void* seqQueueFunc(void *dest, const void *src, size_t elemSize);
 
 /* Like seqQueueGet but does not copy the element's data;
-   instead the user supplied function is called.
+   instead the user supplied function is called. Its
+   elemSize argument is the actual size of the element.
    seqQueueGet(q,v) == seqQueueGetF(q,memcpy,v)
    */
 epicsShareFunc boolean seqQueueGetF(QUEUE q, seqQueueFunc *f, void *arg);
 
+/* Like seqQueueGetF but leaves the first element in the queue.
+   If other threads remove elements concurrently, the function
+   may be called more than once, and with an element that has
+   already been removed (but not yet overwritten), so it should
+   do no more than copy what it needs. Takes the queue's mutex.
+   */
+epicsShareFunc boolean seqQueueFirstF(QUEUE q, seqQueueFunc *f, void *arg);
+
+/* Like seqQueueGetBatch but does not copy the elements' data;
+   instead the user supplied function is called once for each
+   element, always with the same arg, so it must keep track of
+   the destination itself.
+   */
+epicsShareFunc size_t seqQueueGetBatchF(QUEUE q, seqQueueFunc *f, void *arg,
+    size_t n);
+
 /* Like seqQueuePut but does not copy the element's data;
    instead the user supplied function is called.
    seqQueuePut(q,v) == seqQueuePutF(q,memcpy,v) */
 epicsShareFunc boolean seqQueuePutF(QUEUE q, seqQueueFunc *f, const void *arg);
 
+/* Like seqQueuePutF but for an element of the given size,
+   which must not exceed seqQueueElemSize(q). Only queues
+   with elements of varying size remember the size.
+   seqQueuePutF(q,f,v) == seqQueuePutN(q,f,v,seqQueueElemSize(q)) */
+epicsShareFunc boolean seqQueuePutN(QUEUE q, seqQueueFunc *f, const void *arg,
+    size_t size);
+
+/* Zero-copy access: a producer can reserve room for an
+   element, write it in place, and then commit it; a consumer
+   can peek at the first element in place and then release it.
+   Each reserve or peek that returns non-NULL must be followed
+   by exactly one commit resp. release from the same thread,
+   and soon: for queues with elements of varying size, the
+   mutex is held in between, and in other queues, producers
+   that have gone round the ring wait for a peeked slot.
+
+   seqQueueReserve returns a pointer to room for an element
+   of the given size (at most seqQueueElemSize(q)), or NULL
+   if the queue is full and room could only be made by losing
+   an element other than the first (depending on the policy);
+   use seqQueuePutN in that case. */
+epicsShareFunc void *seqQueueReserve(QUEUE q, size_t size);
+
+/* Append the reserved element to the queue. For queues with
+   elements of varying size, size is the actual size of the
+   element and may be less than the size reserved. */
+epicsShareFunc void seqQueueCommit(QUEUE q, void *elem, size_t size);
+
+/* Remove the first element from the queue, but leave its data
+   in place until seqQueueRelease is called. Return a pointer to
+   it and, if size is not NULL, store its size there. Return
+   NULL if the queue is empty. */
+epicsShareFunc void *seqQueuePeek(QUEUE q, size_t *size);
+
+/* Release an element returned by seqQueuePeek */
+epicsShareFunc void seqQueueRelease(QUEUE q, void *elem);
+
 #endif /* INCLseq_queueh */
@@ -50,6 +50,9 @@ extern "C" {
 #define OPT_DOENTRYFROMSELF	((seqMask)1u<<1)	/* Do entry{} even if from same state */
 #define OPT_DOEXITTOSELF	((seqMask)1u<<2)	/* Do exit{} even if to same state */
 
+/* Channel priority if the assign clause gives none */
+#define PRIORITY_DEFAULT	((unsigned)-1)
+
 #ifndef TRUE
 #define TRUE	1
 #endif
@@ -65,9 +68,18 @@ typedef seqBool SEQ_EVENT_FUNC(SS_ID ssId, int *transNum, int *nextState);
 typedef void SEQ_SS_FUNC(SS_ID ssId);
 typedef void SEQ_PROG_FUNC(PROG_ID progId);
 
+/* What a put does if a syncQ queue is full */
+enum seqQueuePolicy {
+	QP_OVERWRITE_LAST,		/* overwrite the last (newest) element */
+	QP_DROP_OLDEST,			/* remove the first (oldest) element */
+	QP_DROP_NEWEST,			/* discard the new element */
+	QP_GROW				/* allocate more memory, up to a limit */
+};
+
 typedef const struct seqChan seqChan;
 typedef const struct seqState seqState;
 typedef const struct seqSS seqSS;
+typedef const struct seqMsgChan seqMsgChan;
 
 /* Static information about a channel */
 struct seqChan
@@ -80,8 +92,24 @@ struct seqChan
 	unsigned	eventNum;	/* event number for this channel */
 	EF_ID		efId;		/* event flag id if synced */
 	seqBool		monitored;	/* whether channel should be monitored */
+	unsigned	monitorMask;	/* events to monitor, bits as
+					   pvMonitorXxx in pv.h (0=default) */
+	seqBool		monitorDynamic;	/* whether monitor delivers only the
+					   elements the server has */
+	const char	*filter;	/* channel filter (JSON), or NULL */
 	unsigned	queueSize;	/* syncQ queue size (0=not queued) */
 	unsigned	queueIndex;	/* syncQ queue index */
+	unsigned	queueBytes;	/* syncQ buffer size for elements of
+					   varying size (0=fixed size) */
+	enum seqQueuePolicy queuePolicy; /* syncQ overflow policy */
+	unsigned	queueSpill;	/* syncQ spill area size in bytes
+					   (0=none) */
+	seqBool		queueStats;	/* whether to record residence times */
+	int		owner;		/* index of the only state set that
+					   uses this channel, or -1 */
+	unsigned	priority;	/* channel priority (or PRIORITY_DEFAULT) */
+	seqBool		ctrl;		/* whether to cache control information
+					   (units, limits, etc.) */
 };
 
 /* Static information about a state */
@@ -93,6 +121,7 @@ struct seqState
 	SEQ_SS_FUNC	*entryFunc;	/* statements performed on entry to state */
 	SEQ_SS_FUNC	*exitFunc;	/* statements performed on exit from state */
 	const seqMask	*eventMask;	/* event mask for this state */
+	const seqMask	*readMask;	/* channels read in this state */
 	seqMask		options;	/* state option mask */
 };
 
@@ -102,6 +131,20 @@ struct seqSS
 	const char	*ssName;	/* state set name */
 	seqState	*states;	/* array of state blocks */
 	unsigned	numStates;	/* number of states in this state set */
+	const unsigned	*chanMap;	/* sorted indices of channels used in
+					   this state set, NULL if all */
+	unsigned	numMapped;	/* number of entries in chanMap */
+};
+
+/* Static information about a message channel between state sets */
+struct seqMsgChan
+{
+	const char	*varName;	/* message variable name */
+	size_t		offset;		/* offset to message variable */
+	size_t		size;		/* size of a message */
+	unsigned	queueSize;	/* messages per receiver */
+	const unsigned	*receivers;	/* indices of receiving state sets */
+	unsigned	numReceivers;	/* number of entries in receivers */
 };
 
 /* Static information about a state program */
@@ -121,6 +164,8 @@ struct seqProgram
 	SEQ_SS_FUNC	*entryFunc;	/* entry function */
 	SEQ_SS_FUNC	*exitFunc;	/* exit function */
 	unsigned	numQueues;	/* number of syncQ queues */
+	seqMsgChan	*msgChans;	/* table of message channels */
+	unsigned	numMsgChans;	/* number of message channels */
 };
 
 epicsShareFunc void seq_efInit(PROG_ID sp, EF_ID ev_flag, unsigned val);
@@ -0,0 +1,77 @@
+/*************************************************************************\
+Copyright (c) 2010-2015 Helmholtz-Zentrum Berlin f. Materialien
+                        und Energie GmbH, Germany (HZB)
+This file is distributed subject to a Software License Agreement found
+in the file LICENSE that is included with this distribution.
+\*************************************************************************/
+/*************************************************************************\
+Spill areas for syncQ queues, as memory mapped files
+
+The file is created in the directory given by the environment variable
+SEQ_SPILL_DIR (default /tmp) and removed right away, so that it goes
+away with the mapping, even if the IOC crashes. Only the pages actually
+written occupy memory, and the kernel can write them back to the file
+when memory is tight.
+\*************************************************************************/
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "seq.h"
+#include "seq_debug.h"
+
+#define SPILL_NAME "/seqSpillXXXXXX"
+
+void *seqSpillMap(size_t numBytes)
+{
+	const char	*dir = getenv("SEQ_SPILL_DIR");
+	char		*path;
+	int		fd;
+	void		*addr;
+
+	if (!dir || !*dir)
+		dir = "/tmp";
+	path = newArray(char, strlen(dir) + sizeof(SPILL_NAME));
+	if (!path)
+	{
+		errlogSevPrintf(errlogFatal, "seqSpillMap: out of memory\n");
+		return NULL;
+	}
+	strcpy(path, dir);
+	strcat(path, SPILL_NAME);
+	fd = mkstemp(path);
+	if (fd < 0)
+	{
+		errlogSevPrintf(errlogFatal, "seqSpillMap: cannot create '%s': %s\n",
+			path, strerror(errno));
+		free(path);
+		return NULL;
+	}
+	unlink(path);
+	if (ftruncate(fd, (off_t)numBytes) != 0)
+	{
+		errlogSevPrintf(errlogFatal, "seqSpillMap: cannot extend '%s' to %lu bytes: %s\n",
+			path, (unsigned long)numBytes, strerror(errno));
+		close(fd);
+		free(path);
+		return NULL;
+	}
+	addr = mmap(NULL, numBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (addr == MAP_FAILED)
+	{
+		errlogSevPrintf(errlogFatal, "seqSpillMap: cannot map '%s': %s\n",
+			path, strerror(errno));
+		addr = NULL;
+	}
+	DEBUG("seqSpillMap: mapped %lu bytes of '%s' at %p\n",
+		(unsigned long)numBytes, path, addr);
+	close(fd);
+	free(path);
+	return addr;
+}
+
+void seqSpillUnmap(void *addr, size_t numBytes)
+{
+	munmap(addr, numBytes);
+}
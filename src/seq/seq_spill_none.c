@@ -0,0 +1,21 @@
+/*************************************************************************\
+Copyright (c) 2010-2015 Helmholtz-Zentrum Berlin f. Materialien
+                        und Energie GmbH, Germany (HZB)
+This file is distributed subject to a Software License Agreement found
+in the file LICENSE that is included with this distribution.
+\*************************************************************************/
+/*************************************************************************\
+Spill areas for syncQ queues, on systems without memory mapped files
+\*************************************************************************/
+#include "seq.h"
+
+void *seqSpillMap(size_t numBytes)
+{
+	errlogSevPrintf(errlogFatal, "seqSpillMap: spilling queues to files "
+		"is not supported on this system\n");
+	return NULL;
+}
+
+void seqSpillUnmap(void *addr, size_t numBytes)
+{
+}
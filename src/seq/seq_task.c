@@ -53,6 +53,13 @@ void sequencer (void *arg)	/* ptr to original (global) state program table */
 		}
 	}
 
+	/* Start event dispatch, if requested, before events can come in */
+	if (!seq_dispatch_start(sp))
+	{
+		sp->die = TRUE;
+		goto exit;
+	}
+
 	/* Attach to PV system */
 	pvSysAttach(sp->pvSys);
 
@@ -114,6 +121,8 @@ void sequencer (void *arg)	/* ptr to original (global) state program table */
 exit:
 	DEBUG("   Disconnect all channels\n");
 	seq_disconnect(sp);
+	DEBUG("   Stop event dispatch\n");
+	seq_dispatch_stop(sp);
 	DEBUG("   Remove program instance from list\n");
 	seqDelProg(sp);
 
@@ -126,24 +135,38 @@ exit:
 }
 
 /*
- * ss_read_buffer_static() - static version of ss_read_buffer.
+ * ss_read_buffer_static() - static version of ss_read_buffer,
+ * given the channel's slot in the state set's tables.
  * This is to enable inlining in the for loop in ss_read_all_buffer.
  */
-static void ss_read_buffer_static(SSCB *ss, CHAN *ch, boolean dirty_only)
+static void ss_read_buffer_static(SSCB *ss, CHAN *ch, ptrdiff_t nch, boolean dirty_only)
 {
 	char *val = valPtr(ch,ss);
 	char *buf = bufPtr(ch);
-	ptrdiff_t nch = chNum(ch);
 	/* Must take dbCount for db channels, else we overwrite
 	   elements we didn't get */
 	size_t count = ch->dbch ? ch->dbch->dbCount : ch->count;
-	size_t var_size = ch->type->size * count;
+	size_t var_size;
 
 	if (!ss->dirty[nch] && dirty_only)
 		return;
 
 	epicsMutexMustLock(ch->varLock);
 
+	/* Likewise, a dynamic monitor may have delivered fewer; the shared
+	   buffer has stale elements beyond those */
+	if (ch->dbch && ch->monitorDynamic)
+		count = min(ch->dbch->metaData.count, count);
+	var_size = ch->type->size * count;
+
+	/* The single consumer already has the latest value */
+	if (ch->direct && ss == ch->owner)
+	{
+		ss->dirty[nch] = FALSE;
+		epicsMutexUnlock(ch->varLock);
+		return;
+	}
+
 	DEBUG("ss %s: before read %s", ss->ssName, ch->varName);
 	print_channel_value(DEBUG, ch, val);
 
@@ -170,22 +193,59 @@ static void ss_read_buffer_static(SSCB *ss, CHAN *ch, boolean dirty_only)
  */
 void ss_read_buffer(SSCB *ss, CHAN *ch, boolean dirty_only)
 {
-	ss_read_buffer_static(ss, ch, dirty_only);
+	ss_read_buffer_static(ss, ch, ssSlot(ss,ch), dirty_only);
 }
 
 /*
  * ss_read_all_buffer() - Call ss_read_buffer_static
- * for all channels.
+ * for all channels. If the state set has a channel map,
+ * only the channels in it can be dirty, and their slots
+ * are the positions in the map, so no search is needed.
  */
 static void ss_read_all_buffer(PROG *sp, SSCB *ss)
 {
 	unsigned nch;
 
+	if (ss->chanMap)
+	{
+		for (nch = 0; nch < ss->numMapped; nch++)
+			ss_read_buffer_static(ss, sp->chan + ss->chanMap[nch], nch, TRUE);
+		return;
+	}
 	for (nch = 0; nch < sp->numChans; nch++)
 	{
 		CHAN *ch = sp->chan + nch;
 		/* Call static version so it gets inlined */
-		ss_read_buffer_static(ss, ch, TRUE);
+		ss_read_buffer_static(ss, ch, nch, TRUE);
+	}
+}
+
+/*
+ * ss_read_state_buffer() - Call ss_read_buffer_static
+ * for all channels the given state reads. Other
+ * channels stay dirty until a state that reads
+ * them becomes current.
+ */
+static void ss_read_state_buffer(PROG *sp, SSCB *ss, STATE *st)
+{
+	unsigned nch;
+
+	if (ss->chanMap)
+	{
+		for (nch = 0; nch < ss->numMapped; nch++)
+		{
+			CHAN *ch = sp->chan + ss->chanMap[nch];
+			if (bitTest(st->readMask, ch->eventNum))
+				ss_read_buffer_static(ss, ch, nch, TRUE);
+		}
+		return;
+	}
+	for (nch = 0; nch < sp->numChans; nch++)
+	{
+		CHAN *ch = sp->chan + nch;
+		if (bitTest(st->readMask, ch->eventNum))
+			/* Call static version so it gets inlined */
+			ss_read_buffer_static(ss, ch, nch, TRUE);
 	}
 }
 
@@ -201,11 +261,36 @@ void ss_read_buffer_selective(PROG *sp, SSCB *ss, EF_ID ev_flag)
 	while (ch)
 	{
 		/* Call static version so it gets inlined */
-		ss_read_buffer_static(ss, ch, TRUE);
+		ss_read_buffer_static(ss, ch, ssSlot(ss,ch), TRUE);
 		ch = ch->nextSynced;
 	}
 }
 
+/*
+ * ss_slot() - Find a channel (by index) in a state set's channel map,
+ * using binary search. Channels the state set does not use all map to
+ * the spare slot at the end.
+ */
+ptrdiff_t ss_slot(SSCB *ss, ptrdiff_t nch)
+{
+	const unsigned *map = ss->chanMap;
+	unsigned lo = 0, hi = ss->numMapped;
+
+	assert(map);
+	while (lo < hi)
+	{
+		unsigned mid = lo + (hi - lo) / 2;
+
+		if (map[mid] < (unsigned)nch)
+			lo = mid + 1;
+		else if (map[mid] > (unsigned)nch)
+			hi = mid;
+		else
+			return mid;
+	}
+	return ss->numMapped;
+}
+
 /*
  * ss_write_buffer() - Copy given value and meta data
  * to shared buffer. In safe mode, if dirtify is TRUE then
@@ -215,15 +300,37 @@ void ss_write_buffer(CHAN *ch, void *val, PVMETA *meta, boolean dirtify)
 {
 	PROG *sp = ch->prog;
 	char *buf = bufPtr(ch);		/* shared buffer */
-	/* Must use dbCount for db channels, else we overwrite
-	   elements we didn't get */
-	size_t count = ch->dbch ? ch->dbch->dbCount : ch->count;
+	/* Must use the count received (at most dbCount) for db
+	   channels, else we overwrite elements we didn't get */
+	size_t count = ch->dbch ? (meta ? meta->count : ch->dbch->dbCount) : ch->count;
 	size_t var_size = ch->type->size * count;
-	ptrdiff_t nch = chNum(ch);
 	unsigned nss;
 
 	epicsMutexMustLock(ch->varLock);
 
+	/* If the only state set using this channel is waiting for events,
+	   it cannot be looking at its buffer, so we deliver directly into
+	   it, instead of into the shared buffer. */
+	if (ch->owner && ch->owner->waiting && dirtify)
+	{
+		SSCB *ss = ch->owner;
+		ptrdiff_t nch = ssSlot(ss,ch);
+
+		memcpy(valPtr(ch,ss), val, var_size);
+		if (ch->dbch && meta)
+			/* structure copy */
+			ss->metaData[nch] = *meta;
+		ss->dirty[nch] = FALSE;
+		ch->direct = TRUE;
+
+		DEBUG("ss_write_buffer: direct write %s to ss %s", ch->varName,
+			ss->ssName);
+		print_channel_value(DEBUG, ch, valPtr(ch,ss));
+
+		epicsMutexUnlock(ch->varLock);
+		return;
+	}
+
 	DEBUG("ss_write_buffer: before write %s", ch->varName);
 	print_channel_value(DEBUG, ch, buf);
 
@@ -231,17 +338,39 @@ void ss_write_buffer(CHAN *ch, void *val, PVMETA *meta, boolean dirtify)
 	if (ch->dbch && meta)
 		/* structure copy */
 		ch->dbch->metaData = *meta;
+	ch->direct = FALSE;
 
 	DEBUG("ss_write_buffer: after write %s", ch->varName);
 	print_channel_value(DEBUG, ch, buf);
 
 	if (optTest(sp, OPT_SAFE) && dirtify)
 		for (nss = 0; nss < sp->numSS; nss++)
-			sp->ss[nss].dirty[nch] = TRUE;
+		{
+			SSCB *ss = sp->ss + nss;
+			ptrdiff_t nch = ssSlot(ss,ch);
+
+			/* skip state sets that do not use the channel */
+			if (!isSpareSlot(ss,nch))
+				ss->dirty[nch] = TRUE;
+		}
 
 	epicsMutexUnlock(ch->varLock);
 }
 
+/*
+ * ss_set_waiting() - Mark state set as waiting for events (or not).
+ * While waiting, monitor events for channels that only this state set
+ * uses are delivered directly into its buffer (safe mode only).
+ */
+static void ss_set_waiting(SSCB *ss, boolean waiting)
+{
+	if (!ss->varLock)
+		return;
+	epicsMutexMustLock(ss->varLock);
+	ss->waiting = waiting;
+	epicsMutexUnlock(ss->varLock);
+}
+
 /*
  * ss_entry() - Thread entry point for all state sets.
  * Provides the main loop for state set processing.
@@ -297,6 +426,10 @@ static void ss_entry(void *arg)
 		if (st->entryFunc && (ss->prevState != ss->currentState
 			|| optTest(st, OPT_DOENTRYFROMSELF)))
 		{
+			/* Variables this state reads may still be dirty
+			   if the previous state did not read them */
+			if (optTest(sp, OPT_SAFE))
+				ss_read_state_buffer(sp, ss, st);
 			st->entryFunc(ss);
 		}
 
@@ -326,17 +459,20 @@ static void ss_entry(void *arg)
 			/* Wake up on PV event, event flag, or expired delay */
 			DEBUG("before epicsEventWaitWithTimeout(ss=%d,timeout=%f)\n",
 				ss - sp->ss, ss->wakeupTime - now);
+			ss_set_waiting(ss, TRUE);
 			epicsEventWaitWithTimeout(ss->syncSem, ss->wakeupTime - now);
+			ss_set_waiting(ss, FALSE);
 			DEBUG("after epicsEventWaitWithTimeout()\n");
 
 			/* Check whether we have been asked to exit */
 			if (sp->die) goto exit;
 
 			/* Copy dirty variable values from CA buffer
-			 * to user (safe mode only).
+			 * to user (safe mode only), but only for
+			 * channels this state can observe.
 			 */
 			if (optTest(sp, OPT_SAFE))
-				ss_read_all_buffer(sp, ss);
+				ss_read_state_buffer(sp, ss, st);
 
 			ss->wakeupTime = epicsINF;
 
@@ -38,11 +38,13 @@ static void analyse_assign(SymTable st, ChanList *chan_list, Node *scope, Node *
 static void analyse_monitor(SymTable st, Node *scope, Node *defn);
 static void analyse_sync(SymTable st, Node *scope, Node *defn);
 static void analyse_syncq(SymTable st, SyncQList *syncq_list, Node *scope, Node *defn);
-static void assign_subscript(ChanList *chan_list, Node *defn, Var *vp, Node *subscr, Node *pv_name);
-static void assign_single(ChanList *chan_list, Node *defn, Var *vp, Node *pv_name);
-static void assign_multi(ChanList *chan_list, Node *defn, Var *vp, Node *pv_name_list);
+static void analyse_msgchan(SymTable st, MsgChanList *msgchan_list, Node *scope, Node *defn);
+static void assign_subscript(ChanList *chan_list, Node *defn, Var *vp, Node *subscr, Node *pv_name, uint priority);
+static void assign_single(ChanList *chan_list, Node *defn, Var *vp, Node *pv_name, uint priority);
+static void assign_multi(ChanList *chan_list, Node *defn, Var *vp, Node *pv_name_list, uint priority);
 static Chan *new_channel(ChanList *chan_list, Var *vp, uint count, uint index);
 static SyncQ *new_sync_queue(SyncQList *syncq_list, uint size);
+static MsgChan *new_msg_chan(MsgChanList *msgchan_list, Var *vp, uint size);
 static void connect_variables(SymTable st, Node *scope);
 static void connect_state_change_stmts(SymTable st, Node *scope);
 static uint connect_states(SymTable st, Node *ss_list);
@@ -50,6 +52,9 @@ static void check_states_reachable_from_first(Node *ss);
 static void add_var(Var *vp, Node *scope);
 static Var *find_var(SymTable st, char *name, Node *scope);
 static uint assign_ef_bits(Node *scope);
+static void classify_variables(Node *prog);
+static void connect_msg_chans(Program *p);
+static void mark_ctrl_chans(Program *p);
 
 Program *analyse_program(Node *prog, Options options)
 {
@@ -77,9 +82,10 @@ Program *analyse_program(Node *prog, Options options)
 
 	p->chan_list = new(ChanList);
 	p->syncq_list = new(SyncQList);
+	p->msgchan_list = new(MsgChanList);
 
 #ifdef DEBUG
-	report("created symbol table, channel list, and syncq list\n");
+	report("created symbol table, channel list, syncq list, and msgchan list\n");
 #endif
 
 	analyse_definitions(p);
@@ -89,6 +95,9 @@ Program *analyse_program(Node *prog, Options options)
 	foreach(ss, prog->prog_statesets)
 		check_states_reachable_from_first(ss);
 	p->num_event_flags = assign_ef_bits(p->prog);
+	classify_variables(p->prog);
+	connect_msg_chans(p);
+	mark_ctrl_chans(p);
 	return p;
 }
 
@@ -169,6 +178,9 @@ static void analyse_defns(Node *defn_list, Node *scope, Program *p)
 		case D_SYNCQ:
 			analyse_syncq(p->sym_table, p->syncq_list, scope, defn);
 			break;
+		case D_MSGCHAN:
+			analyse_msgchan(p->sym_table, p->msgchan_list, scope, defn);
+			break;
 		case T_TEXT:
 			break;
 		default:
@@ -488,10 +500,42 @@ static void analyse_declaration(SymTable st, Node *scope, Node *defn)
 	}
 }
 
+/* Highest channel priority, the same as CA_PRIORITY_MAX
+   and pvPriorityMax in pv.h */
+#define MAX_PRIORITY 99
+
+/* Parse options of an assign clause; return whether they are valid */
+static int assign_options(Node *defn, uint *priority)
+{
+	Node	*op;
+
+	foreach (op, defn->assign_opts)
+	{
+		char *name, *value;
+
+		assert(op->tag == E_BINOP);
+		name = op->binop_left->token.str;
+		value = op->binop_right->token.str;
+		if (strcmp(name, "priority") != 0)
+		{
+			error_at_node(op, "unknown assign option '%s'\n", name);
+			return FALSE;
+		}
+		if (!strtoui(value, MAX_PRIORITY + 1, priority))
+		{
+			error_at_node(op, "channel priority '%s' out of range "
+				"(0..%d)\n", value, MAX_PRIORITY);
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
 static void analyse_assign(SymTable st, ChanList *chan_list, Node *scope, Node *defn)
 {
 	char *name;
 	Var *vp;
+	uint priority = NO_PRIORITY;
 
 	assert(chan_list);		/* precondition */
 	assert(scope);			/* precondition */
@@ -523,21 +567,23 @@ static void analyse_assign(SymTable st, ChanList *chan_list, Node *scope, Node *
 	{
 		warning_at_node(defn, "state local assign is deprecated\n");
 	}
+	if (!assign_options(defn, &priority))
+		return;
 	if (defn->assign_subscr)
 	{
-		assign_subscript(chan_list, defn, vp, defn->assign_subscr, defn->assign_pvs);
+		assign_subscript(chan_list, defn, vp, defn->assign_subscr, defn->assign_pvs, priority);
 	}
 	else if (!defn->assign_pvs)
 	{
-		assign_single(chan_list, defn, vp, 0);
+		assign_single(chan_list, defn, vp, 0, priority);
 	}
 	else if (defn->assign_pvs->tag == E_INIT)
 	{
-		assign_multi(chan_list, defn, vp, defn->assign_pvs->init_elems);
+		assign_multi(chan_list, defn, vp, defn->assign_pvs->init_elems, priority);
 	}
 	else
 	{
-		assign_single(chan_list, defn, vp, defn->assign_pvs);
+		assign_single(chan_list, defn, vp, defn->assign_pvs, priority);
 	}
 }
 
@@ -548,7 +594,8 @@ static void assign_single(
 	ChanList	*chan_list,
 	Node		*defn,
 	Var		*vp,
-	Node		*pv_name
+	Node		*pv_name,
+	uint		priority
 )
 {
 	char *name = pv_name ? pv_name->token.str : "";
@@ -570,6 +617,7 @@ static void assign_single(
 	vp->chan.single = new_channel(
 		chan_list, vp, type_array_length1(vp->type) * type_array_length2(vp->type), 0);
 	vp->chan.single->name = name;
+	vp->chan.single->priority = priority;
 }
 
 static void assign_elem(
@@ -577,7 +625,8 @@ static void assign_elem(
 	Node		*defn,
 	Var		*vp,
 	uint		n_subscr,
-	char		*pv_name
+	char		*pv_name,
+	uint		priority
 )
 {
 	assert(chan_list);				/* precondition */
@@ -606,6 +655,7 @@ static void assign_elem(
 		return;
 	}
 	vp->chan.multi[n_subscr]->name = pv_name;
+	vp->chan.multi[n_subscr]->priority = priority;
 }
 
 /* Assign an array element to a channel.
@@ -615,7 +665,8 @@ static void assign_subscript(
 	Node		*defn,
 	Var		*vp,
 	Node		*subscr,
-	Node		*pv_name
+	Node		*pv_name,
+	uint		priority
 )
 {
 	uint n_subscr;
@@ -647,7 +698,7 @@ static void assign_subscript(
 			vp->name, subscr->token.str);
 		return;
 	}
-	assign_elem(chan_list, defn, vp, n_subscr, pv_name->token.str);
+	assign_elem(chan_list, defn, vp, n_subscr, pv_name->token.str, priority);
 }
 
 /* Assign an array variable to multiple channels.
@@ -657,7 +708,8 @@ static void assign_multi(
 	ChanList	*chan_list,
 	Node		*defn,
 	Var		*vp,
-	Node		*pv_name_list
+	Node		*pv_name_list,
+	uint		priority
 )
 {
 	Node	*pv_name;
@@ -692,16 +744,91 @@ static void assign_multi(
 				"in multiple assign to variable '%s'\n", vp->name);
 			break;
 		}
-		assign_elem(chan_list, defn, vp, n_subscr++, pv_name->token.str);
+		assign_elem(chan_list, defn, vp, n_subscr++, pv_name->token.str, priority);
 	}
 	/* for the remaining array elements, assign to "" */
 	while (n_subscr < type_array_length1(vp->type))
 	{
-		assign_elem(chan_list, defn, vp, n_subscr++, "");
+		assign_elem(chan_list, defn, vp, n_subscr++, "", priority);
 	}
 }
 
-static void monitor_var(Node *defn, Var *vp)
+/* Events a monitor clause can select; the bits are those of
+   pvMonitorValue etc. in pv.h, which are those of DBE_VALUE etc. */
+static const struct { const char *name; uint bit; } monitor_events[] =
+{
+	{ "value",	1 },
+	{ "archive",	2 },
+	{ "log",	2 },
+	{ "alarm",	4 },
+	{ "property",	8 },
+	{ 0, 0 }
+};
+
+/* Parse options of a monitor clause into the monitor fields of opts;
+   return whether they are valid */
+static int monitor_options(Node *defn, Chan *opts)
+{
+	Node	*op;
+
+	foreach (op, defn->monitor_opts)
+	{
+		char *name;
+
+		if (op->tag == E_CONST)
+		{
+			int i;
+
+			name = op->token.str;
+			if (strcmp(name, "dynamic") == 0)
+			{
+				opts->monitor_dynamic = TRUE;
+				continue;
+			}
+			for (i = 0; monitor_events[i].name; i++)
+			{
+				if (strcmp(name, monitor_events[i].name) == 0)
+					break;
+			}
+			if (!monitor_events[i].name)
+			{
+				error_at_node(op, "unknown monitor option '%s'\n", name);
+				return FALSE;
+			}
+			opts->monitor_mask |= monitor_events[i].bit;
+			continue;
+		}
+		assert(op->tag == E_BINOP);
+		name = op->binop_left->token.str;
+		if (strcmp(name, "filter") != 0)
+		{
+			error_at_node(op, "unknown monitor option '%s'\n", name);
+			return FALSE;
+		}
+		if (opts->filter)
+		{
+			error_at_node(op, "more than one filter for monitor\n");
+			return FALSE;
+		}
+		opts->filter = op->binop_right->token.str;
+		if (opts->filter[0] != '{')
+		{
+			error_at_node(op, "channel filter must be a JSON object\n");
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+static void monitor_chan(Chan *cp, Chan *opts)
+{
+	cp->monitor = TRUE;
+	cp->monitor_dynamic = opts->monitor_dynamic;
+	cp->monitor_mask = opts->monitor_mask;
+	cp->filter = opts->filter;
+}
+
+static void monitor_var(Node *defn, Var *vp, Chan *opts)
 {
 	assert(defn);
 	assert(vp);
@@ -724,7 +851,7 @@ static void monitor_var(Node *defn, Var *vp)
 	vp->monitor = M_SINGLE;			/* strengthen if M_MULTI */
 	if (vp->assign == M_SINGLE)
 	{
-		vp->chan.single->monitor = TRUE;
+		monitor_chan(vp->chan.single, opts);
 	}
 	else
 	{
@@ -732,12 +859,12 @@ static void monitor_var(Node *defn, Var *vp)
 		assert(vp->assign == M_MULTI);	/* by L2a and else */
 		for (n = 0; n < type_array_length1(vp->type); n++)
 		{
-			vp->chan.multi[n]->monitor = TRUE;
+			monitor_chan(vp->chan.multi[n], opts);
 		}
 	}
 }
 
-static void monitor_elem(Node *defn, Var *vp, Node *subscr)
+static void monitor_elem(Node *defn, Var *vp, Node *subscr, Chan *opts)
 {
 	uint	n_subscr;
 
@@ -792,13 +919,14 @@ static void monitor_elem(Node *defn, Var *vp, Node *subscr)
 			vp->name, n_subscr);
 		return;					/* nothing to do */
 	}
-	vp->chan.multi[n_subscr]->monitor = TRUE;	/* do it */
+	monitor_chan(vp->chan.multi[n_subscr], opts);	/* do it */
 }
 
 static void analyse_monitor(SymTable st, Node *scope, Node *defn)
 {
 	Var	*vp;
 	char	*var_name;
+	Chan	opts;
 
 	assert(scope);
 	assert(defn);
@@ -824,13 +952,16 @@ static void analyse_monitor(SymTable st, Node *scope, Node *defn)
 	{
 		warning_at_node(defn, "state local monitor is deprecated\n");
 	}
+	memset(&opts, 0, sizeof(opts));
+	if (!monitor_options(defn, &opts))
+		return;
 	if (defn->monitor_subscr)
 	{
-		monitor_elem(defn, vp, defn->monitor_subscr);
+		monitor_elem(defn, vp, defn->monitor_subscr, &opts);
 	}
 	else
 	{
-		monitor_var(defn, vp);
+		monitor_var(defn, vp, &opts);
 	}
 }
 
@@ -1073,12 +1204,90 @@ static void syncq_elem(Node *defn, Var *vp, Node *subscr, SyncQ *qp)
 	vp->chan.multi[n_subscr]->syncq = qp;		/* do it */
 }
 
+/* Overflow policies for syncq clauses and their names in the run time system */
+static const struct { const char *name, *c_name; } syncq_policies[] =
+{
+	{ "overwriteLast",	"QP_OVERWRITE_LAST" },
+	{ "dropOldest",		"QP_DROP_OLDEST" },
+	{ "dropNewest",		"QP_DROP_NEWEST" },
+	{ "grow",		"QP_GROW" },
+	{ 0, 0 }
+};
+
+/* Parse options of a syncq clause; return whether they are valid */
+static int syncq_options(Node *defn, uint *n_bytes, const char **policy,
+	uint *n_spill, int *stats)
+{
+	Node	*op;
+
+	foreach (op, defn->syncq_opts)
+	{
+		char *name, *value;
+
+		if (op->tag == E_CONST)
+		{
+			int i;
+
+			name = op->token.str;
+			if (strcmp(name, "stats") == 0)
+			{
+				*stats = TRUE;
+				continue;
+			}
+			for (i = 0; syncq_policies[i].name; i++)
+			{
+				if (strcmp(name, syncq_policies[i].name) == 0)
+					break;
+			}
+			if (!syncq_policies[i].name)
+			{
+				error_at_node(op, "unknown syncq option '%s'\n", name);
+				return FALSE;
+			}
+			if (*policy)
+			{
+				error_at_node(op, "more than one overflow policy for syncq\n");
+				return FALSE;
+			}
+			*policy = syncq_policies[i].c_name;
+			continue;
+		}
+		assert(op->tag == E_BINOP);
+		name = op->binop_left->token.str;
+		value = op->binop_right->token.str;
+		if (strcmp(name, "bytes") == 0)
+		{
+			if (!strtoui(value, UINT_MAX, n_bytes) || *n_bytes < 1)
+			{
+				error_at_node(op, "queue buffer size '%s' out of range\n", value);
+				return FALSE;
+			}
+		}
+		else if (strcmp(name, "spill") == 0)
+		{
+			if (!strtoui(value, UINT_MAX, n_spill) || *n_spill < 1)
+			{
+				error_at_node(op, "queue spill size '%s' out of range\n", value);
+				return FALSE;
+			}
+		}
+		else
+		{
+			error_at_node(op, "unknown syncq option '%s'\n", name);
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
 static void analyse_syncq(SymTable st, SyncQList *syncq_list, Node *scope, Node *defn)
 {
 	char	*var_name;
 	Var	*vp, *evp = 0;
 	SyncQ	*qp;
-	uint	n_size = 0;
+	uint	n_size = 0, n_bytes = 0, n_spill = 0;
+	const char *policy = 0;
+	int	stats = FALSE;
 
 	assert(scope);
 	assert(defn);
@@ -1120,6 +1329,8 @@ static void analyse_syncq(SymTable st, SyncQList *syncq_list, Node *scope, Node
 			defn->syncq_size->token.str);
 		return;
 	}
+	if (!syncq_options(defn, &n_bytes, &policy, &n_spill, &stats))
+		return;
 	if (defn->syncq_evflag)
 	{
 		char *ef_name = defn->syncq_evflag->token.str;
@@ -1145,6 +1356,10 @@ static void analyse_syncq(SymTable st, SyncQList *syncq_list, Node *scope, Node
 		evp->chan.evflag->queued = TRUE;
 	}
 	qp = new_sync_queue(syncq_list, n_size);
+	qp->bytes = n_bytes;
+	qp->policy = policy ? policy : "QP_OVERWRITE_LAST";
+	qp->spill = n_spill;
+	qp->stats = stats;
 	if (defn->syncq_subscr)
 	{
 		if (evp)
@@ -1159,6 +1374,63 @@ static void analyse_syncq(SymTable st, SyncQList *syncq_list, Node *scope, Node
 	}
 }
 
+static void analyse_msgchan(SymTable st, MsgChanList *msgchan_list, Node *scope, Node *defn)
+{
+	char	*var_name;
+	Var	*vp;
+	uint	n_size;
+
+	assert(scope);
+	assert(defn);
+	assert(defn->tag == D_MSGCHAN);
+
+	var_name = defn->token.str;
+	assert(var_name);
+
+	if (!defn->msgchan_size)
+		return;		/* syntax error already reported */
+	vp = find_var(st, var_name, scope);
+	if (!vp)
+	{
+		error_at_node(defn, "variable '%s' not declared\n", var_name);
+		return;
+	}
+	if (vp->scope != scope)
+	{
+		error_at_node(defn, "cannot use variable '%s' as message channel: "
+			"msgchan must be in the same scope as declaration\n",
+			var_name);
+		return;
+	}
+	if (vp->type->tag == T_EVFLAG || vp->type->tag == T_FUNCTION
+		|| vp->type->tag == T_VOID || vp->type->tag == T_NONE)
+	{
+		error_at_node(defn, "variable '%s' cannot be used as message channel\n",
+			var_name);
+		return;
+	}
+	if (vp->assign != M_NONE)
+	{
+		error_at_node(defn, "variable '%s' is assigned to a pv and cannot "
+			"be used as message channel\n", var_name);
+		return;
+	}
+	if (vp->msgchan)
+	{
+		error_at_node(defn, "variable '%s' already used as message channel\n",
+			var_name);
+		return;
+	}
+	if (!strtoui(defn->msgchan_size->token.str, UINT_MAX, &n_size) || n_size < 1)
+	{
+		error_at_node(defn->msgchan_size, "queue size '%s' out of range\n",
+			defn->msgchan_size->token.str);
+		return;
+	}
+	vp->msgchan = new_msg_chan(msgchan_list, vp, n_size);
+	vp->msgchan->decl = defn;
+}
+
 /* Allocate a channel structure for this variable, add it to the channel list,
    and initialize members index, var, and count. Also increase channel
    count in the list. */
@@ -1169,6 +1441,7 @@ static Chan *new_channel(ChanList *chan_list, Var *vp, uint count, uint index)
 	cp->var = vp;
 	cp->count = count;
 	cp->index = index;
+	cp->priority = NO_PRIORITY;
 	if (index == 0)
 		vp->index = chan_list->num_elems;
 	chan_list->num_elems++;
@@ -1203,6 +1476,27 @@ static SyncQ *new_sync_queue(SyncQList *syncq_list, uint size)
 	return qp;
 }
 
+/* Allocate a message channel structure, add it to the message channel list,
+   and initialize members index, var, and size. Also increase message channel
+   count in the list. */
+static MsgChan *new_msg_chan(MsgChanList *msgchan_list, Var *vp, uint size)
+{
+	MsgChan *mp = new(MsgChan);
+
+	mp->index = msgchan_list->num_elems++;
+	mp->var = vp;
+	mp->size = size;
+
+	if (!msgchan_list->first)
+		msgchan_list->first = mp;
+	else
+		msgchan_list->last->next = mp;
+	msgchan_list->last = mp;
+	mp->next = 0;
+
+	return mp;
+}
+
 /* Add a variable to a scope (append to the end of the var_list) */
 void add_var(Var *vp, Node *scope)
 {
@@ -1421,6 +1715,7 @@ static uint connect_states(SymTable st, Node *prog)
 #endif
 			sp->extra.e_state->index = num_states++;
 		}
+		ssp->extra.e_ss->index = num_ss;
 		ssp->extra.e_ss->num_states = num_states;
 #ifdef DEBUG
 		report("connect_states: ss = %s, num_states = %d\n", ssp->token.str, num_states);
@@ -1609,3 +1904,201 @@ static uint assign_ef_bits(Node *scope)
 	}
 	return num_event_flags;
 }
+
+/* Record that the variable is referenced from the given state set
+   (or from outside of any state set if ssp is NULL). */
+static void use_var(Var *vp, Node *ssp)
+{
+	if (vp->shared)
+		return;
+	if (ssp && (!vp->owner || vp->owner == ssp))
+	{
+		vp->owner = ssp;
+	}
+	else
+	{
+		vp->owner = 0;
+		vp->shared = TRUE;
+	}
+}
+
+static int iter_share_variable(Node *ep, Node *scope, void *parg)
+{
+	assert(ep->tag == E_VAR);
+	use_var(ep->extra.e_var, 0);
+	return FALSE;
+}
+
+typedef struct {
+	Node	*prog;
+	Node	*ssp;	/* current state set (or NULL) */
+} classify_arg;
+
+static int iter_classify_variables(Node *ep, Node *scope, void *parg)
+{
+	classify_arg *pca = (classify_arg *)parg;
+	Var	*vp;
+
+	switch (ep->tag)
+	{
+	case E_VAR:
+		use_var(ep->extra.e_var, pca->ssp);
+		return FALSE;
+	case E_PRE:
+		/* a pointer to a variable may be used anywhere */
+		if (strcmp(ep->token.str, "&") == 0)
+		{
+			traverse_syntax_tree(ep->pre_operand, bit(E_VAR), 0, scope,
+				iter_share_variable, 0);
+			return FALSE;
+		}
+		return TRUE;
+	case T_TEXT:
+		/* top-level C code has no access to variables (in reentrant
+		   mode), other embedded C code may reference any of them */
+		if (scope == pca->prog)
+			return FALSE;
+		foreach (vp, var_list_from_scope(pca->prog)->first)
+			use_var(vp, pca->ssp);
+		return FALSE;
+	default:
+		assert(impossible);
+		return FALSE;
+	}
+}
+
+/* Find out which variables are referenced by a single state set only.
+   References from function definitions and from entry and exit blocks
+   count as references from outside of state sets, as do variables whose
+   address is taken. */
+static void classify_variables(Node *prog)
+{
+	classify_arg ca;
+
+	ca.prog = prog;
+	ca.ssp = 0;
+	traverse_syntax_tree(prog, bit(E_VAR)|bit(E_PRE)|bit(T_TEXT),
+		bit(D_SS), 0, iter_classify_variables, &ca);
+	foreach (ca.ssp, prog->prog_statesets)
+	{
+		traverse_syntax_tree(ca.ssp, bit(E_VAR)|bit(E_PRE)|bit(T_TEXT),
+			0, 0, iter_classify_variables, &ca);
+	}
+}
+
+typedef struct {
+	Node	*ssp;	/* current state set (or NULL) */
+	uint	num_ss;	/* number of state sets */
+} msg_chan_arg;
+
+static int iter_connect_msg_chans(Node *ep, Node *scope, void *parg)
+{
+	msg_chan_arg *pma = (msg_chan_arg *)parg;
+	struct func_symbol *fsym;
+	MsgChan	*mp;
+	uint	n;
+
+	assert(ep->tag == E_FUNC);
+	if (ep->func_expr->tag != E_BUILTIN)
+		return TRUE;
+	fsym = ep->func_expr->extra.e_builtin;
+	if (strcmp(fsym->name, "msgSend") != 0 && strcmp(fsym->name, "msgRecv") != 0)
+		return TRUE;
+	/* wrong arguments are reported when generating the call */
+	if (!ep->func_args || ep->func_args->tag != E_VAR
+		|| !ep->func_args->extra.e_var->msgchan)
+		return TRUE;
+	mp = ep->func_args->extra.e_var->msgchan;
+	if (strcmp(fsym->name, "msgSend") == 0)
+	{
+		mp->num_senders++;
+		return TRUE;
+	}
+	if (!pma->ssp)
+	{
+		error_at_node(ep, "calling msgRecv is only allowed inside a state set\n");
+		return TRUE;
+	}
+	for (n = 0; n < mp->num_receivers; n++)
+		if (mp->receivers[n] == pma->ssp->extra.e_ss->index)
+			return TRUE;
+	if (!mp->receivers)
+		mp->receivers = newArray(uint, pma->num_ss);
+	mp->receivers[mp->num_receivers++] = pma->ssp->extra.e_ss->index;
+	return TRUE;
+}
+
+/* Find the senders and receivers of each message channel. The receivers
+   are the state sets that call msgRecv on it, in order of state set index. */
+static void connect_msg_chans(Program *p)
+{
+	msg_chan_arg ma;
+	MsgChan	*mp;
+
+	if (!p->msgchan_list->first)
+		return;
+	ma.ssp = 0;
+	ma.num_ss = p->num_ss;
+	traverse_syntax_tree(p->prog, bit(E_FUNC), bit(D_SS), 0,
+		iter_connect_msg_chans, &ma);
+	foreach (ma.ssp, p->prog->prog_statesets)
+	{
+		traverse_syntax_tree(ma.ssp, bit(E_FUNC), 0, 0,
+			iter_connect_msg_chans, &ma);
+	}
+	foreach (mp, p->msgchan_list->first)
+	{
+		if (!mp->num_receivers)
+			warning_at_node(mp->decl, "message channel '%s' has no receivers\n",
+				mp->var->name);
+		else if (!mp->num_senders)
+			warning_at_node(mp->decl, "message channel '%s' has no senders\n",
+				mp->var->name);
+	}
+}
+
+static int iter_mark_ctrl_chans(Node *ep, Node *scope, void *parg)
+{
+	struct func_symbol *fsym;
+	const struct param **ppp;
+	Node	*ap;
+
+	assert(ep->tag == E_FUNC);
+	if (ep->func_expr->tag != E_BUILTIN)
+		return TRUE;
+	fsym = ep->func_expr->extra.e_builtin;
+	for (ppp = fsym->params, ap = ep->func_args; *ppp && ap; ppp++, ap = ap->next)
+	{
+		Var	*vp = 0;
+
+		if ((*ppp)->type != PT_PV_CTRL)
+			continue;
+		/* wrong arguments are reported when generating the call */
+		if (ap->tag == E_VAR)
+			vp = ap->extra.e_var;
+		else if (ap->tag == E_SUBSCR && ap->subscr_operand->tag == E_VAR)
+			vp = ap->subscr_operand->extra.e_var;
+		if (!vp)
+			continue;
+		if (vp->assign == M_SINGLE)
+		{
+			vp->chan.single->ctrl = TRUE;
+		}
+		else if (vp->assign == M_MULTI)
+		{
+			uint n;
+			/* the subscript is usually not known at compile time */
+			for (n = 0; n < type_array_length1(vp->type); n++)
+				vp->chan.multi[n]->ctrl = TRUE;
+		}
+	}
+	return TRUE;
+}
+
+/* Mark the channels whose control information (units, limits, etc.)
+   is used, so that the run time system caches it */
+static void mark_ctrl_chans(Program *p)
+{
+	traverse_syntax_tree(p->prog, bit(E_FUNC), 0, 0,
+		iter_mark_ctrl_chans, 0);
+}
@@ -43,6 +43,10 @@ static struct const_symbol const_symbols[] =
     {"pvSevrMINOR",         CT_OTHER },
     {"pvSevrMAJOR",         CT_OTHER },
     {"pvSevrINVALID",       CT_OTHER },
+    {"pvLimitDISPLAY",      CT_OTHER },
+    {"pvLimitCONTROL",      CT_OTHER },
+    {"pvLimitALARM",        CT_OTHER },
+    {"pvLimitWARNING",      CT_OTHER },
     {"seqg_var",            CT_OTHER },
     {"seqg_env",            CT_OTHER },
     {0,                     CT_OTHER }
@@ -51,7 +55,9 @@ static struct const_symbol const_symbols[] =
 /* single parameter descriptors */
 static const struct param efP       = { PT_EF, 0 };
 static const struct param pvP       = { PT_PV, 0 };
+static const struct param pvCtrlP   = { PT_PV_CTRL, 0 };
 static const struct param pvArrayP  = { PT_PV_ARRAY, 0 };
+static const struct param msgChanP  = { PT_MSGCHAN, 0 };
 static const struct param noDefP    = { PT_OTHER, 0 };
 static const struct param compTypeP = { PT_OTHER, "DEFAULT" };
 static const struct param tmoP      = { PT_OTHER, "DEFAULT_TIMEOUT" };
@@ -59,6 +65,7 @@ static const struct param boolP     = { PT_OTHER, "FALSE" };
 static const struct param ptrP      = { PT_OTHER, "NULL" };
 static const struct param lengthP   = { PT_OTHER, 0 };
 static const struct param defLenP   = { PT_OTHER, "1" };
+static const struct param limitP    = { PT_OTHER, "pvLimitDISPLAY" };
 
 /* multiple parameter descriptors */
 static const struct param *noParams[]                    = {0};
@@ -66,10 +73,17 @@ static const struct param *otherParams[]                 = {&noDefP,0};
 static const struct param *efParams[]                    = {&efP,0};
 static const struct param *assignParams[]                = {&pvP,&noDefP,0};
 static const struct param *pvParams[]                    = {&pvP,0};
+static const struct param *pvCtrlParams[]                = {&pvCtrlP,0};
+static const struct param *pvChoiceParams[]              = {&pvCtrlP,&noDefP,0};
+static const struct param *pvUnitsParams[]               = {&pvCtrlP,&noDefP,0};
+static const struct param *pvLimitsParams[]              = {&pvCtrlP,&noDefP,&noDefP,&limitP,0};
+static const struct param *msgChanParams[]               = {&msgChanP,0};
 static const struct param *pvArrayParams[]               = {&pvArrayP,&lengthP,0};
 static const struct param *pvSyncParams[]                = {&pvP,&efP,0};
 static const struct param *pvArraySyncParams[]           = {&pvArrayP,&lengthP,&efP,0};
 static const struct param *pvGetPutParams[]              = {&pvP,&compTypeP,&tmoP,0};
+static const struct param *pvGetQManyParams[]            = {&pvP,&noDefP,&lengthP,&ptrP,0};
+static const struct param *pvGetQMergeParams[]           = {&noDefP,&lengthP,&noDefP,&lengthP,&ptrP,&ptrP,0};
 static const struct param *pvArrayGetPutCompleteParams[] = {&pvArrayP,&lengthP,&boolP,&ptrP,0};
 /* for backward compatibility */
 static const struct param *pvPutCompleteParams[]         = {&pvP,&defLenP,&boolP,&ptrP,0};
@@ -83,12 +97,15 @@ static struct func_symbol func_symbols[] =
     {"efTest",              0,          FALSE,  FALSE,  efParams                    },
     {"efTestAndClear",      0,          FALSE,  FALSE,  efParams                    },
     {"macValueGet",         0,          FALSE,  FALSE,  otherParams                 },
+    {"msgRecv",             0,          FALSE,  FALSE,  msgChanParams               },
+    {"msgSend",             0,          TRUE,   FALSE,  msgChanParams               },
     {"optGet",              0,          FALSE,  FALSE,  otherParams                 },
     {"pvAssign",            0,          FALSE,  FALSE,  assignParams                },
     {"pvAssignCount",       0,          FALSE,  FALSE,  noParams                    },
     {"pvAssignSubst",       0,          FALSE,  FALSE,  assignParams                },
     {"pvAssigned",          0,          FALSE,  FALSE,  pvParams                    },
     {"pvChannelCount",      0,          FALSE,  FALSE,  noParams                    },
+    {"pvChoice",            0,          FALSE,  FALSE,  pvChoiceParams              },
     {"pvConnectCount",      0,          FALSE,  FALSE,  noParams                    },
     {"pvConnected",         0,          FALSE,  FALSE,  pvParams                    },
     {"pvArrayConnected",    0,          FALSE,  FALSE,  pvArrayParams               },
@@ -102,11 +119,15 @@ static struct func_symbol func_symbols[] =
     {"pvGetComplete",       0,          FALSE,  FALSE,  pvParams                    },
     {"pvArrayGetComplete",  0,          FALSE,  FALSE,  pvArrayGetPutCompleteParams },
     {"pvGetQ",              0,          FALSE,  FALSE,  pvParams                    },
+    {"pvGetQMany",          0,          FALSE,  FALSE,  pvGetQManyParams            },
+    {"pvGetQMerge",         0,          FALSE,  FALSE,  pvGetQMergeParams           },
     {"pvIndex",             0,          FALSE,  FALSE,  pvParams                    },
+    {"pvLimits",            0,          FALSE,  FALSE,  pvLimitsParams              },
     {"pvMessage",           0,          FALSE,  FALSE,  pvParams                    },
     {"pvMonitor",           0,          FALSE,  FALSE,  pvParams                    },
     {"pvArrayMonitor",      0,          FALSE,  FALSE,  pvArrayParams               },
     {"pvName",              0,          FALSE,  FALSE,  pvParams                    },
+    {"pvPrecision",         0,          FALSE,  FALSE,  pvCtrlParams                },
     {"pvPut",               "pvPutTmo", FALSE,  FALSE,  pvGetPutParams              },
     {"pvPutCancel",         0,          FALSE,  FALSE,  pvParams                    },
     {"pvArrayPutCancel",    0,          FALSE,  FALSE,  pvArrayParams               },
@@ -119,6 +140,7 @@ static struct func_symbol func_symbols[] =
     {"pvSync",              0,          FALSE,  FALSE,  pvSyncParams                },
     {"pvArraySync",         0,          FALSE,  FALSE,  pvArraySyncParams           },
     {"pvTimeStamp",         0,          FALSE,  FALSE,  pvParams                    },
+    {"pvUnits",             0,          FALSE,  FALSE,  pvUnitsParams               },
     {0,                     0,          FALSE,  FALSE,  0                           }
 };
 
@@ -22,7 +22,9 @@ enum const_type {
 enum param_type {
     PT_EF,
     PT_PV,
+    PT_PV_CTRL,                 /* PT_PV whose control information is used */
     PT_PV_ARRAY,
+    PT_MSGCHAN,
     PT_OTHER
 };
 
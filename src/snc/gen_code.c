@@ -294,6 +294,7 @@ static void gen_global_defn(Node *ep)
                 break;
 	case D_ASSIGN:
 	case D_MONITOR:
+	case D_MSGCHAN:
 	case D_OPTION:
 	case D_SYNC:
 	case D_SYNCQ:
@@ -25,6 +25,7 @@ void indent(int level);
 #define NM_CHANS	"seqg_chans"
 #define NM_STATES	"seqg_states"
 #define NM_STATESETS	"seqg_statesets"
+#define NM_MSGCHANS	"seqg_msgchans"
 
 /* names and name prefixes for generated functions */
 #define NM_ENTRY	"seqg_entry"
@@ -33,6 +34,9 @@ void indent(int level);
 #define NM_ACTION	"seqg_action"
 #define NM_EVENT	"seqg_event"
 #define NM_MASK		"seqg_mask"
+#define NM_READMASK	"seqg_readmask"
+#define NM_CHANMAP	"seqg_chanmap"
+#define NM_MSGRECV	"seqg_msgrecv"
 
 /* names of generated function arguments */
 #define NM_VAR		"seqg_var"
@@ -47,6 +47,10 @@ static void gen_ef_arg(
 	const char	*func_name,	/* function name */
 	Node		*ap,		/* argument expression */
 	uint		index);		/* argument index */
+static void gen_msgchan_arg(
+	const char	*func_name,	/* function name */
+	Node		*ap,		/* argument expression */
+	uint		index);		/* argument index */
 static void gen_pv_arg(
 	int		context,
 	const char	*func_name,	/* function name */
@@ -591,11 +595,15 @@ static void gen_builtin_call(int context, Node *ep)
 				gen_ef_arg(context, fsym->name, ap, n);
 				break;
 			case PT_PV:
+			case PT_PV_CTRL:
 				gen_pv_arg(context, fsym->name, ap, n, FALSE);
 				break;
 			case PT_PV_ARRAY:
 				gen_pv_arg(context, fsym->name, ap, n, TRUE);
 				break;
+			case PT_MSGCHAN:
+				gen_msgchan_arg(fsym->name, ap, n);
+				break;
 			}
 		}
 		ppp++;
@@ -627,6 +635,21 @@ static void gen_ef_arg(
 		gen_var_access(ap->extra.e_var);
 }
 
+/* Check a message channel argument */
+static void gen_msgchan_arg(
+	const char	*func_name,	/* function name */
+	Node		*ap,		/* argument expression */
+	uint		index		/* argument index */
+)
+{
+	if (ap->tag != E_VAR || !ap->extra.e_var->msgchan)
+		error_at_node(ap,
+			"argument %d to built-in function %s must be a message channel\n",
+			index, func_name);
+	else
+		gen_code("%d/*%s*/", ap->extra.e_var->msgchan->index, ap->extra.e_var->name);
+}
+
 static void gen_pv_arg(
 	int		context,
 	const char	*func_name,	/* function name */
@@ -28,28 +28,44 @@ in the file LICENSE that is included with this distribution.
 typedef struct event_mask_args {
 	seqMask	*event_words;
 	uint	num_event_flags;
+	uint	num_channels;
+	int	read_set;	/* computing a read set, not an event mask */
 } event_mask_args;
 
+#define bitnum(var_ix, ch_ix, num_efs) ((var_ix)+(ch_ix)+(num_efs)+1)
+
 static void gen_channel_table(ChanList *chan_list, uint num_event_flags, int opt_reent);
 static void gen_channel(Chan *cp, uint num_event_flags, int opt_reent);
-static void gen_state_table(Node *ss_list, uint num_event_flags, uint num_channels);
+static void gen_state_table(Node *prog, uint num_event_flags, uint num_channels);
 static void fill_state_struct(Node *sp, char *ss_name, uint ss_num);
+static void gen_msgchan_table(MsgChanList *msgchan_list, int opt_reent);
 static void gen_prog_table(Program *p);
 static void encode_options(Options options);
 static void encode_state_options(StateOptions options);
 static void gen_ss_table(Node *ss_list);
 static void gen_state_event_mask(Node *sp, uint num_event_flags,
 	seqMask *event_words, uint num_event_words);
+static void gen_common_read_mask(Node *prog, uint num_event_flags,
+	uint num_channels, seqMask *read_words, uint num_event_words);
+static void gen_state_read_mask(Node *sp, uint num_event_flags,
+	uint num_channels, const seqMask *common_words,
+	seqMask *read_words, uint num_event_words);
+static void add_read_mask(Node *ep, event_mask_args *rm_args);
+static void gen_ss_chan_map(Node *ssp, uint ss_num, uint num_event_flags,
+	uint num_channels, const seqMask *used_words);
 static int iter_event_mask_scalar(Node *ep, Node *scope, void *parg);
 static int iter_event_mask_array(Node *ep, Node *scope, void *parg);
+static int iter_read_mask_text(Node *ep, Node *scope, void *parg);
+static int iter_read_mask_common(Node *ep, Node *scope, void *parg);
 
 /* Generate all kinds of tables for a SNL program. */
 void gen_tables(Program *p)
 {
 	gen_code("\n/************************ Tables ************************/\n");
 	gen_channel_table(p->chan_list, p->num_event_flags, p->options.reent);
-	gen_state_table(p->prog->prog_statesets, p->num_event_flags, p->chan_list->num_elems);
+	gen_state_table(p->prog, p->num_event_flags, p->chan_list->num_elems);
 	gen_ss_table(p->prog->prog_statesets);
+	gen_msgchan_table(p->msgchan_list, p->options.reent);
 	gen_prog_table(p);
 }
 
@@ -62,7 +78,7 @@ static void gen_channel_table(ChanList *chan_list, uint num_event_flags, int opt
 	{
 		gen_code("\n/* Channel table */\n");
 		gen_code("static seqChan " NM_CHANS "[] = {\n");
-		gen_code("\t/* chName, offset, varName, varType, count, eventNum, efId, monitored, queueSize, queueIndex */\n");
+		gen_code("\t/* chName, offset, varName, varType, count, eventNum, efId, monitored, monitorMask, monitorDynamic, filter, queueSize, queueIndex, queueBytes, queuePolicy, queueSpill, queueStats, owner, priority, ctrl */\n");
 		foreach (cp, chan_list->first)
 		{
 			gen_channel(cp, num_event_flags, opt_reent);
@@ -164,20 +180,40 @@ static void gen_channel(Chan *cp, uint num_event_flags, int opt_reent)
 	gen_code("%d, ", num_event_flags + vp->index + cp->index + 1);
 	/* event flag number (or 0) */
 	gen_code("%d, ", ef_num);
-	/* monitor flag */
-	gen_code("%d, ", cp->monitor);
+	/* monitor flag, events, dynamic count, and channel filter */
+	gen_code("%d, %u, %d, ", cp->monitor, cp->monitor_mask, cp->monitor_dynamic);
+	if (cp->filter)
+		gen_code("\"%s\", ", cp->filter);
+	else
+		gen_code("0, ");
 	/* syncQ queue */
 	if (!cp->syncq)
-		gen_code("0, 0");
+		gen_code("0, 0, 0, QP_OVERWRITE_LAST, 0, 0");
 	else if (!cp->syncq->size)
-		gen_code("DEFAULT_QUEUE_SIZE, %d", cp->syncq->index);
+		gen_code("DEFAULT_QUEUE_SIZE, %d, %u, %s, %u, %d", cp->syncq->index,
+			cp->syncq->bytes, cp->syncq->policy, cp->syncq->spill,
+			cp->syncq->stats);
+	else
+		gen_code("%d, %d, %u, %s, %u, %d", cp->syncq->size, cp->syncq->index,
+			cp->syncq->bytes, cp->syncq->policy, cp->syncq->spill,
+			cp->syncq->stats);
+	/* state set that exclusively uses the channel (or -1) */
+	if (vp->owner)
+		gen_code(", %d", vp->owner->extra.e_ss->index);
+	else
+		gen_code(", -1");
+	/* channel priority */
+	if (cp->priority == NO_PRIORITY)
+		gen_code(", PRIORITY_DEFAULT");
 	else
-		gen_code("%d, %d", cp->syncq->size, cp->syncq->index);
+		gen_code(", %u", cp->priority);
+	/* whether to cache control information */
+	gen_code(", %d", cp->ctrl);
 	gen_code("}");
 }
 
-/* Generate state event mask and table */
-static void gen_state_table(Node *ss_list, uint num_event_flags, uint num_channels)
+/* Generate state event and read masks and table */
+static void gen_state_table(Node *prog, uint num_event_flags, uint num_channels)
 {
 	Node	*ssp;
 	Node	*sp;
@@ -185,13 +221,30 @@ static void gen_state_table(Node *ss_list, uint num_event_flags, uint num_channe
 	uint	num_event_words = NWORDS(num_event_flags + num_channels);
 	uint	ss_num = 0;
 	seqMask	*event_mask = newArray(seqMask, num_event_words);
+	seqMask	*common_mask = newArray(seqMask, num_event_words);
+	seqMask	*used_mask = newArray(seqMask, num_event_words);
+	seqMask	*prog_mask = newArray(seqMask, num_event_words);
+	event_mask_args pm_args = { prog_mask, num_event_flags, num_channels, TRUE };
 
 	/* NOTE: Bit zero of event mask is not used. Bit 1 to num_event_flags
-	   are used for event flags, then come channels. */
+	   are used for event flags, then come channels. Read masks use the
+	   same layout, but only the channel bits are relevant. */
+
+	gen_common_read_mask(prog, num_event_flags, num_channels,
+		common_mask, num_event_words);
+
+	/* The program's entry and exit blocks run in the first state set */
+	for (n = 0; n < num_event_words; n++)
+		prog_mask[n] = 0;
+	add_read_mask(prog->prog_entry, &pm_args);
+	add_read_mask(prog->prog_exit, &pm_args);
 
 	/* For each state set... */
-	foreach (ssp, ss_list)
+	foreach (ssp, prog->prog_statesets)
 	{
+		for (n = 0; n < num_event_words; n++)
+			used_mask[n] = ss_num == 0 ? prog_mask[n] : 0;
+
 		/* Generate event mask array */
 		gen_code("\n/* Event masks for state set \"%s\" */\n", ssp->token.str);
 		foreach (sp, ssp->ss_states)
@@ -204,6 +257,25 @@ static void gen_state_table(Node *ss_list, uint num_event_flags, uint num_channe
 			gen_code("};\n");
 		}
 
+		/* Generate read mask array */
+		gen_code("\n/* Read masks for state set \"%s\" */\n", ssp->token.str);
+		foreach (sp, ssp->ss_states)
+		{
+			gen_state_read_mask(sp, num_event_flags, num_channels,
+				common_mask, event_mask, num_event_words);
+			gen_code("static const seqMask " NM_READMASK "_%s_%d_%s[] = {\n",
+				ssp->token.str, ss_num, sp->token.str);
+			for (n = 0; n < num_event_words; n++)
+			{
+				gen_code("\t0x%08x,\n", event_mask[n]);
+				used_mask[n] |= event_mask[n];
+			}
+			gen_code("};\n");
+		}
+
+		/* Generate channel index map */
+		gen_ss_chan_map(ssp, ss_num, num_event_flags, num_channels, used_mask);
+
 		/* Generate table of state structures */
 		gen_code("\n/* State table for state set \"%s\" */\n", ssp->token.str);
 		gen_code("static seqState " NM_STATES "_%s[] = {\n", ssp->token.str);
@@ -214,6 +286,39 @@ static void gen_state_table(Node *ss_list, uint num_event_flags, uint num_channe
 		gen_code("};\n");
 		ss_num++;
 	}
+	free(event_mask);
+	free(common_mask);
+	free(used_mask);
+	free(prog_mask);
+}
+
+/* Generate the sorted list of channels a state set uses, i.e. those that
+   are referenced in any of its states (see read masks), plus, for the
+   first state set, those referenced in the program's entry and exit
+   blocks. The run time system uses it to allocate per state set tables
+   only for these channels. If all channels are used, no list is generated. */
+static void gen_ss_chan_map(Node *ssp, uint ss_num, uint num_event_flags,
+	uint num_channels, const seqMask *used_words)
+{
+	StateSet *ss = ssp->extra.e_ss;
+	uint	ix;
+
+	ss->num_chans = 0;
+	for (ix = 0; ix < num_channels; ix++)
+		if (bitTest(used_words, bitnum(0,ix,num_event_flags)))
+			ss->num_chans++;
+	ss->all_chans = ss->num_chans == num_channels;
+	if (ss->all_chans)
+		return;
+
+	gen_code("\n/* Channels used by state set \"%s\" */\n", ssp->token.str);
+	gen_code("static const unsigned " NM_CHANMAP "_%s_%d[] = {", ssp->token.str, ss_num);
+	if (!ss->num_chans)
+		gen_code(" 0 ");	/* no empty arrays in C */
+	for (ix = 0; ix < num_channels; ix++)
+		if (bitTest(used_words, bitnum(0,ix,num_event_flags)))
+			gen_code("\n\t%d,", ix);
+	gen_code("\n};\n");
 }
 
 /* Generate a state struct */
@@ -234,6 +339,7 @@ static void fill_state_struct(Node *sp, char *ss_name, uint ss_num)
 	else
 		gen_code("0,\n");
 	gen_code("\t/* event mask array */  " NM_MASK "_%s_%d_%s,\n", ss_name, ss_num, sp->token.str);
+	gen_code("\t/* read mask array */   " NM_READMASK "_%s_%d_%s,\n", ss_name, ss_num, sp->token.str);
 	gen_code("\t/* state options */     ");
 	encode_state_options(sp->extra.e_state->options);
 	gen_code("\n\t},\n");
@@ -269,12 +375,61 @@ static void gen_ss_table(Node *ss_list)
 		gen_code("\t{\n");
 		gen_code("\t/* state set name */    \"%s\",\n", ssp->token.str);
 		gen_code("\t/* states */            " NM_STATES "_%s,\n", ssp->token.str);
-		gen_code("\t/* number of states */  %d\n", ssp->extra.e_ss->num_states);
+		gen_code("\t/* number of states */  %d,\n", ssp->extra.e_ss->num_states);
+		if (ssp->extra.e_ss->all_chans)
+			gen_code("\t/* channel map */       0,\n");
+		else
+			gen_code("\t/* channel map */       " NM_CHANMAP "_%s_%d,\n",
+				ssp->token.str, num_ss - 1);
+		gen_code("\t/* num. mapped chans */ %d\n", ssp->extra.e_ss->num_chans);
 		gen_code("\t},\n");
 	}
 	gen_code("};\n");
 }
 
+/* Generate message channel table, and for each message channel an
+   array with the indices of the receiving state sets */
+static void gen_msgchan_table(MsgChanList *msgchan_list, int opt_reent)
+{
+	MsgChan	*mp;
+	uint	n;
+
+	if (!msgchan_list->first)
+	{
+		gen_code("\n/* No message channels */\n");
+		gen_code("#define " NM_MSGCHANS " 0\n");
+		return;
+	}
+	gen_code("\n/* Message channel receivers */\n");
+	foreach (mp, msgchan_list->first)
+	{
+		if (!mp->num_receivers)
+			continue;
+		gen_code("static const unsigned " NM_MSGRECV "_%s[] = {", mp->var->name);
+		for (n = 0; n < mp->num_receivers; n++)
+			gen_code("%s%d", n ? ", " : "", mp->receivers[n]);
+		gen_code("};\n");
+	}
+	gen_code("\n/* Message channel table */\n");
+	gen_code("static seqMsgChan " NM_MSGCHANS "[] = {\n");
+	gen_code("\t/* varName, offset, size, queueSize, receivers, numReceivers */\n");
+	foreach (mp, msgchan_list->first)
+	{
+		gen_code("\t{\"%s\", ", mp->var->name);
+		if (opt_reent)
+			gen_code("offsetof(struct %s, %s), sizeof(((struct %s *)0)->%s), ",
+				NM_VARS, mp->var->name, NM_VARS, mp->var->name);
+		else
+			gen_code("(size_t)&%s, sizeof(%s), ", mp->var->name, mp->var->name);
+		gen_code("%d, ", mp->size);
+		if (mp->num_receivers)
+			gen_code(NM_MSGRECV "_%s, %d},\n", mp->var->name, mp->num_receivers);
+		else
+			gen_code("0, 0},\n");
+	}
+	gen_code("};\n");
+}
+
 /* Generate a single program structure ("seqProgram") */
 static void gen_prog_table(Program *p)
 {
@@ -296,7 +451,9 @@ static void gen_prog_table(Program *p)
 	gen_code("\t/* init func */         " NM_INIT ",\n");
 	gen_code("\t/* entry func */        %s,\n", p->prog->prog_entry ? NM_ENTRY : "0");
 	gen_code("\t/* exit func */         %s,\n", p->prog->prog_exit ? NM_EXIT : "0");
-	gen_code("\t/* num. queues */       %d\n", p->syncq_list->num_elems);
+	gen_code("\t/* num. queues */       %d,\n", p->syncq_list->num_elems);
+	gen_code("\t/* message channels */  " NM_MSGCHANS ",\n");
+	gen_code("\t/* num. msg channels */ %d\n", p->msgchan_list->num_elems);
 	gen_code("};\n");
 }
 
@@ -340,7 +497,7 @@ static void gen_state_event_mask(Node *sp, uint num_event_flags,
 	 */
 	foreach (tp, sp->state_whens)
 	{
-		event_mask_args em_args = { event_words, num_event_flags };
+		event_mask_args em_args = { event_words, num_event_flags, 0, FALSE };
 
 		/* look for scalar variables and event flags */
 		traverse_syntax_tree(tp->when_cond, bit(E_VAR), 0, 0,
@@ -358,7 +515,95 @@ static void gen_state_event_mask(Node *sp, uint num_event_flags,
 #endif
 }
 
-#define bitnum(var_ix, ch_ix, num_efs) ((var_ix)+(ch_ix)+(num_efs)+1)
+/* Generate the part of the read mask that is common to all states. In safe
+   mode, the run time system refreshes a state set's copy of a channel's
+   variable only if the current state may read it. Which states end up
+   calling a function defined in the program cannot be determined easily,
+   and a variable whose address has been taken may be read through a
+   pointer anywhere, so channels referenced in these ways are considered
+   read by all states. */
+static void gen_common_read_mask(Node *prog, uint num_event_flags,
+	uint num_channels, seqMask *read_words, uint num_event_words)
+{
+	uint	n;
+	event_mask_args rm_args = { read_words, num_event_flags, num_channels, TRUE };
+
+	for (n = 0; n < num_event_words; n++)
+		read_words[n] = 0;
+
+	traverse_syntax_tree(prog, bit(D_FUNCDEF)|bit(E_PRE), 0, 0,
+		iter_read_mask_common, &rm_args);
+}
+
+/* Generate read mask for a single state. The read mask has a bit set for
+   each channel whose variable is referenced anywhere in the state, i.e.
+   in entry and exit blocks, when() conditions, and transition actions. It
+   uses the same bit numbering as the event mask. */
+static void gen_state_read_mask(Node *sp, uint num_event_flags,
+	uint num_channels, const seqMask *common_words,
+	seqMask *read_words, uint num_event_words)
+{
+	uint	n;
+	event_mask_args rm_args = { read_words, num_event_flags, num_channels, TRUE };
+
+	for (n = 0; n < num_event_words; n++)
+		read_words[n] = common_words[n];
+
+	add_read_mask(sp->state_entry, &rm_args);
+	add_read_mask(sp->state_whens, &rm_args);
+	add_read_mask(sp->state_exit, &rm_args);
+#ifdef DEBUG
+	report("read mask for state %s is", sp->token.str);
+	for (n = 0; n < num_event_words; n++)
+		report(" 0x%lx", (unsigned long)read_words[n]);
+	report("\n");
+#endif
+}
+
+/* Add all channels referenced in a list of nodes to the read mask */
+static void add_read_mask(Node *ep, event_mask_args *rm_args)
+{
+	Node	*cep;
+
+	foreach (cep, ep)
+	{
+		traverse_syntax_tree(cep, bit(E_VAR), 0, 0,
+			iter_event_mask_scalar, rm_args);
+		traverse_syntax_tree(cep, bit(E_VAR)|bit(E_SUBSCR), 0, 0,
+			iter_event_mask_array, rm_args);
+		traverse_syntax_tree(cep, bit(T_TEXT), 0, 0,
+			iter_read_mask_text, rm_args);
+	}
+}
+
+/* Iteratee for embedded C code: it may read anything. */
+static int iter_read_mask_text(Node *ep, Node *scope, void *parg)
+{
+	event_mask_args	*rm_args = (event_mask_args *)parg;
+	uint		ix;
+
+	assert(ep->tag == T_TEXT);
+	for (ix = 0; ix < rm_args->num_channels; ix++)
+		bitSet(rm_args->event_words, bitnum(0,ix,rm_args->num_event_flags));
+	return FALSE;
+}
+
+/* Iteratee for function definitions and address-of expressions. */
+static int iter_read_mask_common(Node *ep, Node *scope, void *parg)
+{
+	event_mask_args	*rm_args = (event_mask_args *)parg;
+
+	if (ep->tag == D_FUNCDEF)
+	{
+		add_read_mask(ep->funcdef_block, rm_args);
+		return FALSE;
+	}
+	assert(ep->tag == E_PRE);
+	if (strcmp(ep->token.str, "&") == 0)
+		add_read_mask(ep->pre_operand, rm_args);
+	return TRUE;
+}
+
 
 /* Iteratee for scalar variables (including event flags). */
 static int iter_event_mask_scalar(Node *ep, Node *scope, void *parg)
@@ -465,6 +710,13 @@ static int iter_event_mask_array(Node *ep, Node *scope, void *parg)
 
 			if (!strtoui(e_ix->token.str, length1, &ix))
 			{
+				if (em_args->read_set)
+				{
+					/* not our business to complain here */
+					for (ix = 0; ix < length1; ix++)
+						bitSet(event_words, bitnum(vp->index,ix,num_event_flags));
+					return FALSE;
+				}
 				error_at_node(e_ix,
 					"subscript in '%s[%s]' out of range\n",
 					vp->name, e_ix->token.str);
@@ -36,10 +36,12 @@ typedef struct program		Program;
 typedef struct channel		Chan;
 typedef struct event_flag	EvFlag;
 typedef struct sync_queue	SyncQ;
+typedef struct msg_chan		MsgChan;
 typedef struct syntax_node	Node;
 typedef struct variable		Var;
 typedef struct chan_list	ChanList;
 typedef struct sync_queue_list	SyncQList;
+typedef struct msg_chan_list	MsgChanList;
 typedef struct var_list		VarList;
 typedef struct func_symbol	FuncSym;
 typedef struct const_symbol	ConstSym;
@@ -107,25 +109,29 @@ struct state				/* extra data for state clauses */
 
 struct state_set			/* extra data for state set clauses */
 {
+	uint		index;		/* index in array of seqSS structs */
 	uint		num_states;	/* number of states */
 	VarList		*var_list;	/* list of 'local' variables */
+	uint		num_chans;	/* number of channels used */
+	uint		all_chans:1;	/* whether all channels are used */
 };
 
 /* Expression types */
 enum node_tag			/* description [child nodes...] */
 {
-	D_ASSIGN,		/* assign statement [subscr,pvs] */
+	D_ASSIGN,		/* assign statement [subscr,pvs,options] */
 	D_DECL,			/* variable declaration [init] */
 	D_ENTEX,		/* entry or exit statement [block] */
 	D_FUNCDEF,		/* function definition [decl,block] */
-	D_MONITOR,		/* monitor statement [subscr] */
+	D_MONITOR,		/* monitor statement [subscr,options] */
+	D_MSGCHAN,		/* msgchan statement [size] */
 	D_OPTION,		/* option definition [] */
 	D_PROG,			/* whole program [param,defns,entry,statesets,exit,xdefns] */
 	D_SS,			/* state set statement [defns,states] */
 	D_STATE,		/* state statement [defns,entry,whens,exit] */
 	D_STRUCTDEF,		/* struct definition [members] */
 	D_SYNC,			/* sync statement [subscr,evflag] */
-	D_SYNCQ,		/* syncq statement [subscr,evflag,maxqsize] */
+	D_SYNCQ,		/* syncq statement [subscr,evflag,maxqsize,options] */
 	D_WHEN,			/* when statement [cond,block] */
 
 	E_BINOP,		/* binary operator [left,right] */
@@ -209,7 +215,13 @@ struct variable				/* variable definition */
 		Chan	**multi;	/* multiple channels if assign == SOME */
 		EvFlag	*evflag;	/* event flag data if this is an event flag */
 	} chan;
+	MsgChan	*msgchan;		/* message channel if declared as one */
 	uint	index;			/* index (base) in seqChan array */
+	/* usage */
+	Node	*owner;			/* the only state set that references
+					   this variable (or NULL) */
+	uint	shared:1;		/* referenced from more than one state
+					   set or from outside of state sets */
 };
 /* Laws (Invariants):
 L1a:	monitor	== M_MULTI	=> assign == M_MULTI
@@ -221,6 +233,9 @@ L2c:	assign	== M_NONE	=> syncq == M_NONE
 L3:	assign	== M_MULTI	=> type->tag == T_ARRAY
 */
 
+/* priority of a channel whose assign clause gives none */
+#define NO_PRIORITY	((uint)-1)
+
 struct channel				/* channel assignment info */
 {
 	Chan	*next;			/* link to next channel in list */
@@ -228,7 +243,14 @@ struct channel				/* channel assignment info */
 	uint	index;			/* index (offset) if array element */
 	Var	*var;			/* variable definition */
 	uint	count;			/* request count for pv access */
+	uint	priority;		/* channel priority, or NO_PRIORITY */
+	uint	ctrl:1;			/* whether control information is used */
 	uint	monitor:1;		/* whether this channel is monitored */
+	uint	monitor_dynamic:1;	/* whether monitor delivers only the
+					   elements the server has */
+	uint	monitor_mask;		/* events to monitor (bits as
+					   pvMonitorXxx in pv.h), 0=default */
+	char	*filter;		/* channel filter (JSON), or 0 */
 	Var	*sync;			/* event flag variable if sync'd */
 	SyncQ	*syncq;			/* sync queue if syncQ'd */
 };
@@ -238,6 +260,23 @@ struct sync_queue
 	SyncQ	*next;
 	uint	index;
 	uint	size;
+	uint	bytes;			/* buffer size for elements of
+					   varying size, or 0 */
+	const char *policy;		/* overflow policy (C name) */
+	uint	spill;			/* spill area size in bytes, or 0 */
+	int	stats;			/* whether to record residence times */
+};
+
+struct msg_chan				/* message channel between state sets */
+{
+	MsgChan	*next;
+	uint	index;			/* index in array of seqMsgChan structs */
+	Var	*var;			/* message variable */
+	uint	size;			/* number of messages per receiver */
+	Node	*decl;			/* the msgchan statement */
+	uint	*receivers;		/* indices of receiving state sets */
+	uint	num_receivers;		/* number of receiving state sets */
+	uint	num_senders;		/* number of calls to msgSend */
 };
 
 struct chan_list
@@ -252,6 +291,12 @@ struct sync_queue_list
 	uint	num_elems;		/* number of elements in this list */
 };
 
+struct msg_chan_list
+{
+	MsgChan	*first, *last;		/* first and last member of the list */
+	uint	num_elems;		/* number of elements in this list */
+};
+
 struct var_list
 {
 	Var	*first, *last;		/* first and last member of the list */
@@ -272,6 +317,7 @@ struct program
 	SymTable	sym_table;	/* symbol table */
 	ChanList	*chan_list;	/* channel list, incl. number of channels */
 	SyncQList	*syncq_list;	/* syncq list, incl. number of syncqs */
+	MsgChanList	*msgchan_list;	/* message channel list */
 	uint		num_ss;		/* number of state sets */
 	uint		num_event_flags;/* number of event flags */
 };
@@ -320,6 +366,7 @@ enum multiplicity
    uniformly iterate over all children... */
 #define assign_subscr	children[0]
 #define assign_pvs	children[1]
+#define assign_opts	children[2]
 #define binop_left	children[0]
 #define binop_right	children[1]
 #define cast_type	children[0]
@@ -341,6 +388,8 @@ enum multiplicity
 #define if_else		children[2]
 #define init_elems	children[0]
 #define monitor_subscr	children[0]
+#define monitor_opts	children[1]
+#define msgchan_size	children[0]
 #define paren_expr	children[0]
 #define post_operand	children[0]
 #define pre_operand	children[0]
@@ -368,6 +417,7 @@ enum multiplicity
 #define syncq_subscr	children[0]
 #define syncq_evflag	children[1]
 #define syncq_size	children[2]
+#define syncq_opts	children[3]
 #define ternop_cond	children[0]
 #define ternop_then	children[1]
 #define ternop_else	children[2]
@@ -389,18 +439,19 @@ struct node_info
 node_info[]
 #ifdef node_info_GLOBAL
 = {
-	{ "D_ASSIGN",	2 },
+	{ "D_ASSIGN",	3 },
 	{ "D_DECL",	1 },
 	{ "D_ENTEX",	1 },
 	{ "D_FUNCDEF",	2 },
-	{ "D_MONITOR",	1 },
+	{ "D_MONITOR",	2 },
+	{ "D_MSGCHAN",	1 },
 	{ "D_OPTION",	0 },
 	{ "D_PROG",	6 },
 	{ "D_SS",	2 },
 	{ "D_STATE",	4 },
 	{ "D_STRUCTDEF",1 },
 	{ "D_SYNC",	2 },
-	{ "D_SYNCQ",	3 },
+	{ "D_SYNCQ",	4 },
 	{ "D_WHEN",	2 },
 	{ "E_BINOP",	2 },
 	{ "E_BUILTIN",	0 },
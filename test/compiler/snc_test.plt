@@ -5,6 +5,7 @@ use strict;
 use Test::More;
 
 my $tests = {
+  assign_options          => { warnings => 0, errors => 2  },
   cast                    => { warnings => 0, errors => 0  },
   change                  => { warnings => 0, errors => 2  },
   delay_in_action         => { warnings => 0, errors => 1  },
@@ -18,6 +19,8 @@ my $tests = {
   foreignTypes            => { warnings => 1, errors => 0  },
   funcdefShadowGlobal     => { warnings => 0, errors => 1  },
   misplacedExit           => { warnings => 0, errors => 1  },
+  monitor_options         => { warnings => 0, errors => 4  },
+  msgchan_errors          => { warnings => 1, errors => 6  },
   namingConflict          => { warnings => 0, errors => 0  },
   nesting_depth           => { warnings => 0, errors => 0  },
   pvArray                 => { warnings => 0, errors => 21 },
@@ -27,6 +30,7 @@ my $tests = {
   sync_not_assigned       => { warnings => 0, errors => 1  },
   syncq_no_size           => { warnings => 1, errors => 0  },
   syncq_not_assigned      => { warnings => 0, errors => 1  },
+  syncq_options           => { warnings => 0, errors => 5  },
   syncq_size_out_of_range => { warnings => 0, errors => 1  },
   type_not_allowed        => { warnings => 2, errors => 9  },
 };
@@ -0,0 +1,121 @@
+/*************************************************************************\
+This file is distributed subject to a Software License Agreement found
+in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/*************************************************************************\
+Benchmarks for pvConvert on large waveforms. This is not a test: it is
+built with the tests but not run by them. Each result is printed as a
+single line of name=value pairs, so that the output can be compared
+between versions.
+
+For each pair of types and waveform length, the time per conversion
+of the whole waveform is measured for
+  pvConvert: the library function (vectorised kernels where available)
+  loop:      a plain loop over the elements, as a reference
+and reported as nanoseconds per element and source megabytes per second.
+The time type pair includes copying status, severity and time stamp.
+\*************************************************************************/
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pv.h"
+#include "epicsTime.h"
+#include "testMain.h"
+
+static const unsigned counts[] = {1024, 65536, 1048576};
+#define numCounts (sizeof(counts)/sizeof(unsigned))
+
+/* elements converted per measurement, at least one waveform */
+#define minElems (64 * 1024 * 1024)
+
+struct pair {
+    const char  *name;
+    pvType      src, dst;
+};
+
+static const struct pair pairs[] = {
+    {"shortToDouble",       pvTypeSHORT,        pvTypeDOUBLE},
+    {"longToDouble",        pvTypeLONG,         pvTypeDOUBLE},
+    {"floatToDouble",       pvTypeFLOAT,        pvTypeDOUBLE},
+    {"timeShortToDouble",   pvTypeTIME_SHORT,   pvTypeTIME_DOUBLE},
+    {"doubleToShort",       pvTypeDOUBLE,       pvTypeSHORT},
+};
+#define numPairs (sizeof(pairs)/sizeof(struct pair))
+
+/* the reference loop, simple types only */
+static void loop(pvType dstType, void *dst, pvType srcType, const void *src, unsigned n)
+{
+    unsigned i;
+
+    if (srcType == pvTypeSHORT && dstType == pvTypeDOUBLE)
+        for (i = 0; i < n; i++)
+            ((pvDouble *)dst)[i] = ((const pvShort *)src)[i];
+    else if (srcType == pvTypeLONG && dstType == pvTypeDOUBLE)
+        for (i = 0; i < n; i++)
+            ((pvDouble *)dst)[i] = ((const pvLong *)src)[i];
+    else if (srcType == pvTypeFLOAT && dstType == pvTypeDOUBLE)
+        for (i = 0; i < n; i++)
+            ((pvDouble *)dst)[i] = ((const pvFloat *)src)[i];
+    else if (srcType == pvTypeDOUBLE && dstType == pvTypeSHORT)
+        for (i = 0; i < n; i++)
+            ((pvShort *)dst)[i] = (pvShort)(pvLong)((const pvDouble *)src)[i];
+}
+
+static double run(const struct pair *p, void *dst, const void *src, unsigned count,
+    unsigned reps, int useLoop)
+{
+    epicsTimeStamp start, stop;
+    unsigned r;
+
+    epicsTimeGetCurrent(&start);
+    for (r = 0; r < reps; r++) {
+        if (useLoop)
+            loop(p->dst, dst, p->src, src, count);
+        else
+            pvConvert(p->dst, dst, p->src, src, count);
+    }
+    epicsTimeGetCurrent(&stop);
+    return epicsTimeDiffInSeconds(&stop, &start);
+}
+
+static void bench(const struct pair *p, unsigned count)
+{
+    size_t srcSize = pv_size_n(p->src, count), dstSize = pv_size_n(p->dst, count);
+    char *src = (char *)malloc(srcSize), *dst = (char *)malloc(dstSize);
+    unsigned reps = count >= minElems ? 1 : minElems / count;
+    double bytes = (double)count * pv_value_sizes[p->src] * reps;
+    int useLoop;
+
+    if (!src || !dst) {
+        printf("# out of memory\n");
+        exit(1);
+    }
+    memset(src, 1, srcSize);
+    memset(dst, 0, dstSize);
+    for (useLoop = 0; useLoop < 2; useLoop++) {
+        double secs;
+
+        /* the reference loop has no meta data */
+        if (useLoop && pv_is_time_type(p->src))
+            continue;
+        run(p, dst, src, count, 1, useLoop);    /* warm up */
+        secs = run(p, dst, src, count, reps, useLoop);
+        printf("bench=%s impl=%s count=%u nsPerElem=%.3f MBPerSec=%.0f\n",
+            p->name, useLoop ? "loop" : "pvConvert", count,
+            1e9 * secs / ((double)count * reps), bytes / secs / 1e6);
+    }
+    free(src);
+    free(dst);
+}
+
+MAIN(pvConvertBench)
+{
+    unsigned i, j;
+
+    for (i = 0; i < numPairs; i++)
+        for (j = 0; j < numCounts; j++)
+            bench(&pairs[i], counts[j]);
+    return 0;
+}
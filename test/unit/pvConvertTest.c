@@ -0,0 +1,173 @@
+/*************************************************************************\
+This file is distributed subject to a Software License Agreement found
+in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/*************************************************************************\
+Tests for pvConvert, the client side conversion of values requested in
+a channel's native type.
+\*************************************************************************/
+#include <assert.h>
+#include <limits.h>
+#include <math.h>
+#include <string.h>
+
+#include "pv.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#define maxCount 37     /* more than the widest kernel step, and odd */
+
+static union {
+    double  align;
+    char    buf[sizeof(pvString) * maxCount + 64];
+} srcBuf, dstBuf;
+
+static char *src = srcBuf.buf, *dst = dstBuf.buf;
+
+static void setMeta(char *buf, pvType type, int status, int severity, unsigned secs)
+{
+    unsigned t = type - pvTypeTIME_CHAR;
+    epicsInt16 stat = (epicsInt16)status, sevr = (epicsInt16)severity;
+    epicsTimeStamp stamp;
+
+    stamp.secPastEpoch = secs;
+    stamp.nsec = 1;
+    memcpy(buf + pv_status_offsets[t], &stat, sizeof(stat));
+    memcpy(buf + pv_severity_offsets[t], &sevr, sizeof(sevr));
+    memcpy(buf + pv_stamp_offsets[t], &stamp, sizeof(stamp));
+}
+
+/* short, long, and float arrays of every length up to maxCount, into
+   double arrays, element by element against a plain loop */
+static void testKernels(void)
+{
+    pvShort *s = (pvShort *)src;
+    pvLong *l = (pvLong *)src;
+    pvFloat *f = (pvFloat *)src;
+    pvDouble *d = (pvDouble *)dst;
+    unsigned n, i;
+    int ok;
+
+    ok = TRUE;
+    for (n = 0; n <= maxCount; n++) {
+        for (i = 0; i < n; i++)
+            s[i] = (pvShort)(i % 2 ? -32768 + 7 * i : 32767 - 11 * i);
+        memset(dst, 0x55, sizeof(dstBuf));
+        ok = ok && pvConvert(pvTypeDOUBLE, d, pvTypeSHORT, s, n) == pvStatOK;
+        for (i = 0; i < n; i++)
+            ok = ok && d[i] == s[i];
+        ok = ok && d[n] != 0;   /* nothing written beyond count */
+    }
+    testOk(ok, "short to double, all lengths up to %d", maxCount);
+
+    ok = TRUE;
+    for (n = 0; n <= maxCount; n++) {
+        for (i = 0; i < n; i++)
+            l[i] = i % 3 == 0 ? INT_MIN + (pvLong)i : INT_MAX - (pvLong)(1000 * i);
+        ok = ok && pvConvert(pvTypeDOUBLE, d, pvTypeLONG, l, n) == pvStatOK;
+        for (i = 0; i < n; i++)
+            ok = ok && d[i] == l[i];
+    }
+    testOk(ok, "long to double, all lengths up to %d", maxCount);
+
+    ok = TRUE;
+    for (n = 0; n <= maxCount; n++) {
+        for (i = 0; i < n; i++)
+            f[i] = (pvFloat)((i % 2 ? -1.0 : 1.0) * (i + 0.1) * 1e6);
+        ok = ok && pvConvert(pvTypeDOUBLE, d, pvTypeFLOAT, f, n) == pvStatOK;
+        for (i = 0; i < n; i++)
+            ok = ok && d[i] == (double)f[i];
+    }
+    testOk(ok, "float to double, all lengths up to %d", maxCount);
+}
+
+static void testGeneric(void)
+{
+    pvDouble d[6] = {40000.0, -1.0, 3e9, -2.7, 1e20, -1e20};
+    pvShort s[6];
+    pvLong l[6];
+    pvChar c[6];
+    pvFloat f[3];
+    pvShort s2[3] = {-5, 0, 300};
+
+    pvConvert(pvTypeSHORT, s, pvTypeDOUBLE, d, 6);
+    testOk((epicsUInt16)s[0] == 40000 && (epicsUInt16)s[1] == 65535,
+        "double to unsigned short: %u %u", (epicsUInt16)s[0], (epicsUInt16)s[1]);
+    pvConvert(pvTypeLONG, l, pvTypeDOUBLE, d, 6);
+    testOk((epicsUInt32)l[2] == 3000000000u && l[3] == -2,
+        "double to unsigned long, truncating: %u %d", (epicsUInt32)l[2], (int)l[3]);
+    testOk(l[4] == -1 && l[5] == INT_MIN, "out of range: %d %d", (int)l[4], (int)l[5]);
+    pvConvert(pvTypeCHAR, c, pvTypeDOUBLE, d + 1, 1);
+    testOk1(c[0] == 255);
+
+    d[0] = sqrt(-1.0);
+    pvConvert(pvTypeLONG, l, pvTypeDOUBLE, d, 1);
+    testOk(l[0] == 0, "NaN to 0");
+
+    pvConvert(pvTypeFLOAT, f, pvTypeSHORT, s2, 3);
+    testOk1(f[0] == -5 && f[1] == 0 && f[2] == 300);
+    pvConvert(pvTypeCHAR, c, pvTypeSHORT, s2, 3);
+    testOk(c[0] == 251 && c[2] == 44, "short to char wraps: %u %u", c[0], c[2]);
+}
+
+static void testMeta(void)
+{
+    pvShort *s = (pvShort *)pv_value_ptr(src, pvTypeTIME_SHORT);
+    pvDouble *d = (pvDouble *)pv_value_ptr(dst, pvTypeTIME_DOUBLE);
+
+    memset(src, 0, sizeof(srcBuf));
+    setMeta(src, pvTypeTIME_SHORT, pvStatHIHI, pvSevrMAJOR, 1234);
+    s[0] = -3;
+    s[1] = 4;
+    testOk1(pvConvert(pvTypeTIME_DOUBLE, dst, pvTypeTIME_SHORT, src, 2) == pvStatOK);
+    testOk(d[0] == -3 && d[1] == 4
+        && pv_status(dst, pvTypeTIME_DOUBLE) == pvStatHIHI
+        && pv_severity(dst, pvTypeTIME_DOUBLE) == pvSevrMAJOR
+        && pv_stamp(dst, pvTypeTIME_DOUBLE).secPastEpoch == 1234
+        && pv_stamp(dst, pvTypeTIME_DOUBLE).nsec == 1,
+        "time type to time type copies status, severity and time stamp");
+
+    pvConvert(pvTypeTIME_DOUBLE, dst, pvTypeSHORT, s, 2);
+    testOk(d[1] == 4 && pv_status(dst, pvTypeTIME_DOUBLE) == pvStatOK
+        && pv_severity(dst, pvTypeTIME_DOUBLE) == pvSevrNONE
+        && pv_stamp(dst, pvTypeTIME_DOUBLE).secPastEpoch == 0,
+        "simple type to time type clears them");
+
+    /* time type to simple type drops them */
+    pvConvert(pvTypeLONG, dst, pvTypeTIME_SHORT, src, 2);
+    testOk1(((pvLong *)dst)[0] == -3 && ((pvLong *)dst)[1] == 4);
+}
+
+static void testStrings(void)
+{
+    pvString *str = (pvString *)pv_value_ptr(src, pvTypeTIME_STRING);
+
+    strcpy(str[0], "hello");
+    setMeta(src, pvTypeTIME_STRING, pvStatOK, pvSevrNONE, 1);
+    testOk1(pvConvert(pvTypeSTRING, dst, pvTypeTIME_STRING, src, 1) == pvStatOK
+        && strcmp(dst, "hello") == 0);
+    testOk1(pvConvert(pvTypeDOUBLE, dst, pvTypeSTRING, src, 1) == pvStatERROR);
+    testOk1(pvConvert(pvTypeTIME_STRING, dst, pvTypeLONG, src, 1) == pvStatERROR);
+    testOk1(pvConvert(pvTypeCTRL, dst, pvTypeDOUBLE, src, 1) == pvStatERROR);
+}
+
+MAIN(pvConvertTest)
+{
+    testPlan(20);
+
+    testOk1(pv_simple_type(pvTypeTIME_FLOAT) == pvTypeFLOAT
+        && pv_simple_type(pvTypeFLOAT) == pvTypeFLOAT);
+    testOk1(pv_time_type(pvTypeSTRING) == pvTypeTIME_STRING
+        && pv_time_type(pvTypeTIME_CHAR) == pvTypeTIME_CHAR);
+
+    testDiag("vectorised kernels");
+    testKernels();
+    testDiag("other pairs");
+    testGeneric();
+    testDiag("status, severity and time stamp");
+    testMeta();
+    testDiag("strings and control information");
+    testStrings();
+
+    return testDone();
+}
@@ -0,0 +1,192 @@
+/*************************************************************************\
+Copyright (c) 2010-2015 Helmholtz-Zentrum Berlin f. Materialien
+                        und Energie GmbH, Germany (HZB)
+This file is distributed subject to a Software License Agreement found
+in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/*************************************************************************\
+Tests for the loopback backend of the pv library.
+\*************************************************************************/
+#include <limits.h>
+#include <string.h>
+
+#include "pv.h"
+#include "epicsThread.h"
+#include "epicsEvent.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+#include "pvTestClient.h"
+
+MAIN(pvLoopbackTest)
+{
+    pvSystem sys, slow;
+    pvVar x1, x2, arr;
+    struct client c1, c2, ca;
+    double start, now;
+    pvDouble d;
+    pvLong l[2] = {1, 2};
+    pvLong big[4] = {3, 4, 5, 6};
+    pvDouble *values;
+    pvCtrl ctrl, *got;
+    int i, ok;
+
+    testPlan(34);
+
+    testOk1(pvBackendFind("ca") == &pvCaBackend);
+    testOk1(pvBackendFind("loopback") == &pvLoopbackBackend);
+    testOk1(pvSysCreateBackend(&sys, "nosuchbackend") != pvStatOK);
+    testOk1(pvSysCreateBackend(&sys, "loopback:latency=x") != pvStatOK);
+    if (pvSysCreateBackend(&sys, "loopback:latency=0.02") != pvStatOK
+        || pvSysCreateBackend(&slow, "loopback:rate=100") != pvStatOK) {
+        testAbort("pvSysCreateBackend failed");
+    }
+    testOk1(pvSysIsDefined(sys) && pvSysIsDefined(slow));
+
+    testDiag("connect and monitor");
+
+    clientInit(&c1);
+    clientInit(&c2);
+    pvTimeGetCurrentDouble(&start);
+    x1 = x2 = arr = nullPvVar;
+    if (pvVarCreate(sys, "lbTest:x", connHandler, eventHandler, &c1, &x1) != pvStatOK
+        || pvVarCreate(slow, "lbTest:x", connHandler, eventHandler, &c2, &x2) != pvStatOK) {
+        testAbort("pvVarCreate failed");
+    }
+    ok = waitConn(&c1);
+    testOk(ok && c1.connected && c1.time - start >= 0.02,
+        "connected after %g seconds", c1.time - start);
+    testOk1(waitConn(&c2) && c2.connected);
+    testOk(pvVarGetCount(&x1) == UINT_MAX, "type and count not yet known");
+
+    pvVarMonitorOn(&x1, pvTypeTIME_DOUBLE, 1, &c1);
+    testOk1(pvMonIsDefined(x1));
+    testOk1(waitEvent(&c1) && c1.evt == pvEventMonitor && c1.type == pvTypeTIME_DOUBLE
+        && *(pvDouble *)pv_value_ptr(c1.value, pvTypeTIME_DOUBLE) == 0);
+    testOk1(pvVarGetCount(&x1) == 1);
+
+    testDiag("put from another pv system");
+
+    d = 3.5;
+    pvVarPutCallback(&x2, pvTypeDOUBLE, 1, &d, &c2);
+    testOk1(waitEvent(&c2) && c2.evt == pvEventPut && c2.status == pvStatOK);
+    testOk1(waitEvent(&c1) && c1.evt == pvEventMonitor
+        && *(pvDouble *)pv_value_ptr(c1.value, pvTypeTIME_DOUBLE) == 3.5
+        && pv_stamp(c1.value, pvTypeTIME_DOUBLE).secPastEpoch != 0);
+
+    pvVarGetCallback(&x2, pvTypeSTRING, 1, &c2);
+    ok = waitEvent(&c2);
+    testOk(ok && c2.evt == pvEventGet
+        && strcmp(c2.value, "3.5") == 0, "get as string: '%s'", c2.value);
+
+    testDiag("arrays");
+
+    clientInit(&ca);
+    testOk1(pvLoopbackDefine("lbTest:arr", pvTypeLONG, 4) == pvStatOK);
+    testOk1(pvLoopbackDefine("lbTest:arr", pvTypeDOUBLE, 4) != pvStatOK);
+    pvVarCreate(sys, "lbTest:arr", connHandler, eventHandler, &ca, &arr);
+    testOk1(waitConn(&ca) && pvVarGetCount(&arr) == 4);
+    pvVarPutCallback(&arr, pvTypeLONG, 2, l, &ca);
+    waitEvent(&ca);
+    pvVarGetCallback(&arr, pvTypeDOUBLE, 4, &ca);
+    values = (pvDouble *)ca.value;
+    testOk(waitEvent(&ca) && ca.count == 4 && values[0] == 1 && values[1] == 2
+        && values[2] == 0 && values[3] == 0, "get converts and pads with zeros");
+    pvVarMonitorOn(&arr, pvTypeLONG, 0, &ca);
+    testOk(waitEvent(&ca) && ca.evt == pvEventMonitor && ca.count == 2,
+        "monitor with count 0 gets the elements put: %u", ca.count);
+    pvVarPutNoBlock(&arr, pvTypeLONG, 4, big);
+    testOk(waitEvent(&ca) && ca.count == 4 && ((pvLong *)ca.value)[3] == 6,
+        "a longer put grows it: %u", ca.count);
+    memset(ca.value, 0xff, sizeof(ca.value));
+    pvVarPutNoBlock(&arr, pvTypeLONG, 1, l);
+    ok = waitEvent(&ca);
+    testOk(ok && ca.count == 1 && ((pvLong *)ca.value)[0] == 1
+        && ((pvLong *)ca.value)[1] == -1 && pvVarGetCount(&arr) == 4,
+        "a shorter put shrinks it: %u of %u", ca.count, pvVarGetCount(&arr));
+
+    testDiag("control information");
+
+    pvVarMonitorOff(&arr);
+    memset(&ctrl, 0, sizeof(pvCtrl));
+    strcpy(ctrl.units, "mm");
+    ctrl.precision = 3;
+    ctrl.displayHigh = 10;
+    testOk1(pvLoopbackSetCtrl("lbTest:arr", &ctrl) == pvStatOK);
+    pvVarGetCallback(&arr, pvTypeCTRL, 1, &ca);
+    got = (pvCtrl *)ca.value;
+    ok = waitEvent(&ca);
+    testOk(ok && ca.evt == pvEventGet && ca.type == pvTypeCTRL && ca.count == 1
+        && strcmp(got->units, "mm") == 0 && got->precision == 3 && got->displayHigh == 10,
+        "get control information: units '%s'", got->units);
+    pvVarMonitorOnMask(&arr, pvTypeCTRL, 1, pvMonitorProperty, &ca);
+    testOk1(waitEvent(&ca) && ca.evt == pvEventMonitor && strcmp(got->units, "mm") == 0);
+    strcpy(ctrl.units, "m");
+    pvLoopbackSetCtrl("lbTest:arr", &ctrl);
+    ok = waitEvent(&ca);
+    testOk(ok && ca.evt == pvEventMonitor && strcmp(got->units, "m") == 0,
+        "monitor sees the change: units '%s'", got->units);
+
+    testDiag("event masks");
+
+    ca.numEvents = 0;
+    pvVarPutNoBlock(&arr, pvTypeLONG, 2, l);
+    epicsThreadSleep(0.1);
+    testOk(ca.numEvents == 0, "a put posts no property event");
+    pvVarMonitorOff(&x1);
+    pvVarMonitorOnMask(&x1, pvTypeDOUBLE, 1, pvMonitorAlarm, &c1);
+    waitEvent(&c1);
+    c1.numEvents = 0;
+    d = 4.5;
+    pvVarPutCallback(&x2, pvTypeDOUBLE, 1, &d, &c2);
+    waitEvent(&c2);
+    epicsThreadSleep(0.1);
+    testOk(c1.numEvents == 0, "a put posts no alarm event");
+    pvVarMonitorOff(&x1);
+    pvVarMonitorOnMask(&x1, pvTypeDOUBLE, 1, pvMonitorArchive, &c1);
+    waitEvent(&c1);
+    d = 5.5;
+    pvVarPutCallback(&x2, pvTypeDOUBLE, 1, &d, &c2);
+    waitEvent(&c2);
+    ok = waitEvent(&c1);
+    testOk(ok && c1.evt == pvEventMonitor && *(pvDouble *)c1.value == 5.5,
+        "a put posts an archive event");
+
+    testDiag("rate limit");
+
+    pvTimeGetCurrentDouble(&start);
+    for (i = 0; i < 10; i++) {
+        d = i;
+        pvVarPutNoBlock(&x2, pvTypeDOUBLE, 1, &d);
+    }
+    pvVarGetCallback(&x2, pvTypeDOUBLE, 1, &c2);
+    ok = waitEvent(&c2);
+    testOk(ok && c2.time - start >= 0.095 && *(pvDouble *)c2.value == 9,
+        "11 events at 100 per second took %g seconds", c2.time - start);
+
+    testDiag("monitor off and destroy");
+
+    /* wait for the monitors of the last puts */
+    epicsThreadSleep(0.1);
+    pvVarMonitorOff(&x1);
+    testOk1(!pvMonIsDefined(x1));
+    c1.numEvents = 0;
+    d = 42;
+    pvVarPutCallback(&x2, pvTypeDOUBLE, 1, &d, &c2);
+    waitEvent(&c2);
+    epicsThreadSleep(0.1);
+    testOk(c1.numEvents == 0, "no monitor events after pvVarMonitorOff");
+
+    /* destroy with a pending get */
+    c1.numEvents = 0;
+    pvVarGetCallback(&x1, pvTypeDOUBLE, 1, &c1);
+    testOk1(pvVarDestroy(&x1) == pvStatOK && !pvVarIsDefined(x1));
+    epicsThreadSleep(0.1);
+    testOk(c1.numEvents == 0, "no callbacks after pvVarDestroy");
+
+    ok = pvVarDestroy(&x2) == pvStatOK && pvVarDestroy(&arr) == pvStatOK;
+    testOk1(ok);
+
+    pvTimeGetCurrentDouble(&now);
+    testDiag("done after %g seconds", now - start);
+    return testDone();
+}
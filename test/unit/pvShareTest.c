@@ -0,0 +1,179 @@
+/*************************************************************************\
+This file is distributed subject to a Software License Agreement found
+in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/*************************************************************************\
+Tests for shared channels and subscriptions of the pv library, on top
+of the loopback backend.
+\*************************************************************************/
+#include <string.h>
+
+#include "pv.h"
+#include "epicsThread.h"
+#include "epicsEvent.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+#include "pvTestClient.h"
+
+#define NUM_VARS 4
+
+static double monitoredValue(struct client *c)
+{
+    return *(pvDouble *)pv_value_ptr(c->value, c->type);
+}
+
+static int checkInfo(pvSystem sys, unsigned vars, unsigned chans, unsigned mons)
+{
+    unsigned nv, nc, nm;
+
+    pvSysShareInfo(sys, &nv, &nc, &nm);
+    return testOk(nv == vars && nc == chans && nm == mons,
+        "%u variables use %u channels and %u subscriptions", nv, nc, nm);
+}
+
+MAIN(pvShareTest)
+{
+    pvSystem sys, other;
+    pvVar x[NUM_VARS], y = nullPvVar, z = nullPvVar;
+    struct client c[NUM_VARS], cy, cz;
+    pvDouble d;
+    int i, ok;
+
+    testPlan(24);
+
+    /* sharing is turned on by the option; the latency makes sure that
+       the get below is still pending when its variable is destroyed,
+       without it the get could complete first */
+    if (pvSysCreateBackend(&sys, "loopback:latency=0.02:share") != pvStatOK
+        || pvSysCreateBackend(&other, "loopback") != pvStatOK) {
+        testAbort("pvSysCreateBackend failed");
+    }
+    testOk1(sys.share != NULL && other.share == NULL);
+    testOk1(pvSysShare(&sys) == pvStatOK && sys.share != NULL);
+
+    testDiag("connect");
+
+    for (i = 0; i < NUM_VARS; i++) {
+        clientInit(&c[i]);
+        x[i] = nullPvVar;
+    }
+    clientInit(&cy);
+    ok = TRUE;
+    for (i = 0; i < NUM_VARS - 1; i++) {
+        ok = ok && pvVarCreate(sys, "shTest:x", connHandler, eventHandler, &c[i], &x[i]) == pvStatOK;
+    }
+    if (!ok || pvVarCreate(other, "shTest:x", connHandler, eventHandler, &cy, &y) != pvStatOK) {
+        testAbort("pvVarCreate failed");
+    }
+    ok = TRUE;
+    for (i = 0; i < NUM_VARS - 1; i++) {
+        ok = ok && waitConn(&c[i]) && c[i].connected;
+    }
+    testOk(ok, "all variables connected");
+    checkInfo(sys, 3, 1, 0);
+    testOk1(waitConn(&cy));
+
+    testDiag("monitors");
+
+    if (pvVarMonitorOn(&x[0], pvTypeTIME_DOUBLE, 1, &c[0]) != pvStatOK
+        || pvVarMonitorOn(&x[1], pvTypeTIME_DOUBLE, 1, &c[1]) != pvStatOK
+        || pvVarMonitorOn(&x[2], pvTypeDOUBLE, 1, &c[2]) != pvStatOK) {
+        testAbort("pvVarMonitorOn failed");
+    }
+    checkInfo(sys, 3, 1, 2);
+    ok = TRUE;
+    for (i = 0; i < NUM_VARS - 1; i++) {
+        ok = ok && waitEvent(&c[i]) && c[i].evt == pvEventMonitor && monitoredValue(&c[i]) == 0;
+    }
+    testOk(ok, "each monitor got the initial value");
+    testOk1(c[0].type == pvTypeTIME_DOUBLE && c[2].type == pvTypeDOUBLE);
+
+    d = 5;
+    ok = pvVarPutCallback(&y, pvTypeDOUBLE, 1, &d, &cy) == pvStatOK && waitEvent(&cy);
+    for (i = 0; i < NUM_VARS - 1; i++) {
+        ok = ok && waitEvent(&c[i]) && monitoredValue(&c[i]) == 5;
+    }
+    testOk(ok, "update fanned out to all monitors");
+
+    testDiag("late joiner");
+
+    if (pvVarCreate(sys, "shTest:x", connHandler, eventHandler, &c[3], &x[3]) != pvStatOK) {
+        testAbort("pvVarCreate failed");
+    }
+    testOk1(waitConn(&c[3]) && c[3].connected && pvVarGetCount(&x[3]) == 1);
+    ok = pvVarMonitorOn(&x[3], pvTypeTIME_DOUBLE, 1, &c[3]) == pvStatOK
+        && waitEvent(&c[3]);
+    testOk(ok && c[3].evt == pvEventMonitor && monitoredValue(&c[3]) == 5,
+        "joined subscription with its last value: %g", monitoredValue(&c[3]));
+    checkInfo(sys, 4, 1, 2);
+
+    testDiag("gets and puts go to the requesting variable");
+
+    c[0].numEvents = c[1].numEvents = 0;
+    ok = pvVarGetCallback(&x[1], pvTypeSTRING, 1, &c[1]) == pvStatOK
+        && waitEvent(&c[1]);
+    testOk(ok && c[1].evt == pvEventGet && strcmp(c[1].value, "5") == 0,
+        "get as string: '%s'", c[1].value);
+    d = 6;
+    ok = pvVarPutCallback(&x[1], pvTypeDOUBLE, 1, &d, &c[1]) == pvStatOK;
+    /* put completion and monitor may come in any order */
+    waitEvent(&c[1]);
+    waitEvent(&c[1]);
+    waitEvent(&c[0]);
+    testOk(ok && c[1].numEvents == 3 && c[0].numEvents == 1 && monitoredValue(&c[0]) == 6,
+        "x[0] only saw the monitor");
+
+    testDiag("monitor off and destroy");
+
+    if (pvVarMonitorOff(&x[2]) != pvStatOK) {
+        testAbort("pvVarMonitorOff failed");
+    }
+    checkInfo(sys, 4, 1, 1);
+    if (pvVarMonitorOff(&x[0]) != pvStatOK) {
+        testAbort("pvVarMonitorOff failed");
+    }
+    checkInfo(sys, 4, 1, 1);
+
+    testDiag("event masks");
+
+    /* a different mask needs its own subscription, the default joins */
+    if (pvVarMonitorOnMask(&x[0], pvTypeTIME_DOUBLE, 1, pvMonitorValue, &c[0]) != pvStatOK) {
+        testAbort("pvVarMonitorOnMask failed");
+    }
+    checkInfo(sys, 4, 1, 2);
+    if (pvVarMonitorOnMask(&x[2], pvTypeTIME_DOUBLE, 1, 0, &c[2]) != pvStatOK) {
+        testAbort("pvVarMonitorOnMask failed");
+    }
+    checkInfo(sys, 4, 1, 2);
+
+    testDiag("priorities");
+
+    /* a different priority needs its own channel */
+    clientInit(&cz);
+    if (pvVarCreatePriority(sys, "shTest:x", 50, connHandler, eventHandler, &cz, &z) != pvStatOK) {
+        testAbort("pvVarCreatePriority failed");
+    }
+    testOk1(waitConn(&cz) && cz.connected && z.priority == 50);
+    checkInfo(sys, 5, 2, 2);
+    pvVarDestroy(&z);
+
+    /* destroy with a pending get */
+    c[1].numEvents = 0;
+    if (pvVarGetCallback(&x[1], pvTypeDOUBLE, 1, &c[1]) != pvStatOK) {
+        testAbort("pvVarGetCallback failed");
+    }
+    testOk1(pvVarDestroy(&x[1]) == pvStatOK && !pvVarIsDefined(x[1]));
+    epicsThreadSleep(0.1);
+    testOk(c[1].numEvents == 0, "no callbacks after pvVarDestroy");
+
+    ok = TRUE;
+    for (i = 0; i < NUM_VARS; i++) {
+        if (pvVarIsDefined(x[i]))
+            ok = ok && pvVarDestroy(&x[i]) == pvStatOK;
+    }
+    testOk1(ok);
+    checkInfo(sys, 0, 0, 0);
+    pvVarDestroy(&y);
+
+    return testDone();
+}
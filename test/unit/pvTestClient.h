@@ -0,0 +1,81 @@
+/*************************************************************************\
+This file is distributed subject to a Software License Agreement found
+in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/*************************************************************************\
+Connection and event handlers for the pv library tests: a client records
+what its handlers have seen last and signals each callback.
+\*************************************************************************/
+#ifndef INCLpvTestClienth
+#define INCLpvTestClienth
+
+#include <string.h>
+
+#include "pv.h"
+#include "epicsEvent.h"
+#include "epicsUnitTest.h"
+
+/* largest number of string elements a client keeps */
+#define clientMaxCount 8
+
+/* what the handlers have seen last */
+struct client {
+    epicsEventId    conn;
+    epicsEventId    event;
+    int             connected;
+    pvEventType     evt;
+    pvType          type;
+    unsigned        count;
+    pvStat          status;
+    void            *arg;
+    double          time;       /* of the last callback */
+    unsigned        numEvents;
+    char            value[sizeof(pvString) * clientMaxCount + sizeof(pvCtrl)];
+};
+
+static void connHandler(int connected, void *arg)
+{
+    struct client *c = (struct client *)arg;
+
+    c->connected = connected;
+    pvTimeGetCurrentDouble(&c->time);
+    epicsEventSignal(c->conn);
+}
+
+static void eventHandler(pvEventType evt, void *arg, pvType type,
+    unsigned count, pvValue *value, pvStat status)
+{
+    struct client *c = (struct client *)arg;
+
+    c->evt = evt;
+    c->type = type;
+    c->count = count;
+    c->status = status;
+    if (value)
+        memcpy(c->value, value, pv_size_n(type, count));
+    c->numEvents++;
+    pvTimeGetCurrentDouble(&c->time);
+    epicsEventSignal(c->event);
+}
+
+static void clientInit(struct client *c)
+{
+    memset(c, 0, sizeof(struct client));
+    c->conn = epicsEventCreate(epicsEventEmpty);
+    c->event = epicsEventCreate(epicsEventEmpty);
+    if (!c->conn || !c->event) {
+        testAbort("epicsEventCreate failed");
+    }
+}
+
+static int waitEvent(struct client *c)
+{
+    return epicsEventWaitWithTimeout(c->event, 5.0) == epicsEventWaitOK;
+}
+
+static int waitConn(struct client *c)
+{
+    return epicsEventWaitWithTimeout(c->conn, 5.0) == epicsEventWaitOK;
+}
+
+#endif /* INCLpvTestClienth */
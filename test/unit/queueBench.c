@@ -0,0 +1,279 @@
+/*************************************************************************\
+Copyright (c) 2010-2015 Helmholtz-Zentrum Berlin f. Materialien
+                        und Energie GmbH, Germany (HZB)
+This file is distributed subject to a Software License Agreement found
+in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/*************************************************************************\
+Benchmarks for syncQ queues. This is not a test: it is built with the
+tests but not run by them. Each result is printed as a single line of
+name=value pairs, so that the output can be compared between versions.
+Times are in nanoseconds; percentiles are named p50, p99, p999.
+
+The mpsc benchmarks run one or more producer threads against a single
+consumer, for each combination of element size, queue depth, number of
+producers, and regime:
+  drain:  the consumer removes elements as fast as it can
+  full:   the consumer only starts removing elements (half of the queue)
+          when it finds the queue full, so puts often hit the overflow
+          policy, which is given as well
+They report
+  putsPerSec, getsPerSec: elements put resp. removed per second, from
+             start until the queue has been drained
+  put:       latency of a put
+  age:       time from the start of a put until the element is removed
+The first bytes of each element hold the time of its put.
+
+The spill benchmarks put a burst of elements into a queue with a small
+in-memory part and a spill area large enough for the whole burst, and
+compare against a queue that holds the burst in memory:
+  put:   latency of a put
+  drain: rate at which a single consumer removes the burst (elements/s)
+\*************************************************************************/
+#include "seq.h"
+#include "seq_debug.h"
+#include "epicsThread.h"
+#include "epicsEvent.h"
+#include "testMain.h"
+
+/* total size of a burst, in bytes */
+#define burstBytes (16 * 1024 * 1024)
+/* in-memory part of a queue that spills */
+#define spillNumElems 16
+
+static const size_t elemSizes[] = {8, 1024, 65536};
+#define numElemSizes (sizeof(elemSizes)/sizeof(size_t))
+
+/* mpsc benchmarks: elements per run, limited by the bytes moved */
+#define mpscMaxOps 200000
+#define mpscMaxBytes (64 * 1024 * 1024)
+/* queues larger than this are skipped */
+#define mpscMaxQueueBytes (16 * 1024 * 1024)
+#define mpscMaxProducers 4
+
+static const size_t mpscElemSizes[] = {8, 256, 4096, 65536};
+#define mpscNumElemSizes (sizeof(mpscElemSizes)/sizeof(size_t))
+static const size_t mpscDepths[] = {16, 1024};
+#define mpscNumDepths (sizeof(mpscDepths)/sizeof(size_t))
+static const unsigned mpscProducers[] = {1, 2, mpscMaxProducers};
+#define mpscNumProducers (sizeof(mpscProducers)/sizeof(unsigned))
+
+static const char *policyNames[] = {
+    "overwriteLast", "dropOldest", "dropNewest", "grow"
+};
+
+static int cmpDouble(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+/* Print mean, median, 99th and 99.9th percentile and maximum of n
+   samples, with names starting with the given prefix */
+static void printStats(const char *prefix, double *ns, size_t n)
+{
+    double sum = 0;
+    size_t i;
+
+    if (n == 0) {
+        printf(" %sCount=0", prefix);
+        return;
+    }
+    for (i = 0; i < n; i++)
+        sum += ns[i];
+    qsort(ns, n, sizeof(double), cmpDouble);
+    printf(" %sMean=%.0f %sP50=%.0f %sP99=%.0f %sP999=%.0f %sMax=%.0f",
+        prefix, sum / n, prefix, ns[n / 2], prefix, ns[n - 1 - n / 100],
+        prefix, ns[n - 1 - n / 1000], prefix, ns[n - 1]);
+}
+
+static void spillBench(size_t elemSize, int spill)
+{
+    size_t numElems = burstBytes / elemSize, i, n;
+    /* headroom for the headers of elements in the spill area */
+    size_t spillBytes = numElems * (elemSize + seqQueueVarOverhead + sizeof(double));
+    QUEUE q = seqQueueCreate(spill ? spillNumElems : numElems, elemSize);
+    char *value = (char *)calloc(1, elemSize);
+    double *ns = (double *)calloc(numElems, sizeof(double));
+    epicsTimeStamp start, stop;
+    const char *mode = spill ? "spill" : "memory";
+
+    if (!q || !value || !ns) {
+        printf("# out of memory\n");
+        exit(1);
+    }
+    if (spill && !seqQueueSpill(q, spillBytes)) {
+        printf("# seqQueueSpill failed\n");
+        exit(1);
+    }
+    for (i = 0; i < numElems; i++) {
+        epicsTimeGetCurrent(&start);
+        seqQueuePut(q, value);
+        epicsTimeGetCurrent(&stop);
+        ns[i] = 1e9 * epicsTimeDiffInSeconds(&stop, &start);
+    }
+    printf("bench=put mode=%s elemSize=%lu count=%lu lost=%lu", mode,
+        (unsigned long)elemSize, (unsigned long)numElems,
+        (unsigned long)seqQueueLost(q));
+    printStats("put", ns, numElems);
+    printf("\n");
+
+    epicsTimeGetCurrent(&start);
+    for (n = 0; !seqQueueGet(q, value); n++)
+        ;
+    epicsTimeGetCurrent(&stop);
+    printf("bench=drain mode=%s elemSize=%lu count=%lu perSec=%.0f\n", mode,
+        (unsigned long)elemSize, (unsigned long)n,
+        n / epicsTimeDiffInSeconds(&stop, &start));
+
+    seqQueueDestroy(q);
+    free(ns);
+    free(value);
+}
+
+struct mpscProducer {
+    QUEUE           q;
+    size_t          elemSize;
+    size_t          count;      /* number of puts */
+    double          *putNs;     /* latency of each put */
+    epicsTimeStamp  *start;     /* common time origin */
+    epicsEventId    done;
+};
+
+static void mpscProducerTask(void *arg)
+{
+    struct mpscProducer *pp = (struct mpscProducer *)arg;
+    char *value = (char *)calloc(1, pp->elemSize);
+    size_t i;
+
+    if (!value) {
+        printf("# out of memory\n");
+        exit(1);
+    }
+    for (i = 0; i < pp->count; i++) {
+        epicsTimeStamp before, after;
+        double t;
+
+        epicsTimeGetCurrent(&before);
+        t = epicsTimeDiffInSeconds(&before, pp->start);
+        memcpy(value, &t, sizeof(double));
+        seqQueuePut(pp->q, value);
+        epicsTimeGetCurrent(&after);
+        pp->putNs[i] = 1e9 * epicsTimeDiffInSeconds(&after, &before);
+    }
+    free(value);
+    epicsEventSignal(pp->done);
+}
+
+static void mpscBench(size_t elemSize, size_t depth, unsigned numProducers,
+    int full, enum seqQueuePolicy policy)
+{
+    size_t count = mpscMaxBytes / elemSize / numProducers;
+    struct mpscProducer pp[mpscMaxProducers];
+    double *putNs, *ageNs;
+    char *value = (char *)calloc(1, elemSize);
+    size_t numPuts, numGets = 0;
+    unsigned p, numDone = 0;
+    int done[mpscMaxProducers];
+    epicsTimeStamp start, stop;
+    QUEUE q;
+
+    if (count > mpscMaxOps / numProducers)
+        count = mpscMaxOps / numProducers;
+    numPuts = count * numProducers;
+    putNs = (double *)calloc(numPuts, sizeof(double));
+    ageNs = (double *)calloc(numPuts, sizeof(double));
+    q = seqQueueCreatePolicy(depth, elemSize, 0, policy);
+    if (!q || !value || !putNs || !ageNs) {
+        printf("# out of memory\n");
+        exit(1);
+    }
+
+    epicsTimeGetCurrent(&start);
+    for (p = 0; p < numProducers; p++) {
+        pp[p].q = q;
+        pp[p].elemSize = elemSize;
+        pp[p].count = count;
+        pp[p].putNs = putNs + p * count;
+        pp[p].start = &start;
+        pp[p].done = epicsEventCreate(epicsEventEmpty);
+        done[p] = 0;
+        if (!pp[p].done || !epicsThreadCreate("producer",
+            epicsThreadPriorityMedium,
+            epicsThreadGetStackSize(epicsThreadStackSmall),
+            mpscProducerTask, pp + p)) {
+            printf("# cannot start producer\n");
+            exit(1);
+        }
+    }
+    while (numDone < numProducers || !seqQueueIsEmpty(q)) {
+        size_t n = 0, batch = full && numDone < numProducers ? depth / 2 : 1;
+
+        if (batch > 1 && !seqQueueIsFull(q)) {
+            epicsThreadSleep(0.0);
+        } else {
+            while (n < batch && !seqQueueGet(q, value)) {
+                epicsTimeStamp now;
+                double t;
+
+                epicsTimeGetCurrent(&now);
+                memcpy(&t, value, sizeof(double));
+                ageNs[numGets++] = 1e9 * (epicsTimeDiffInSeconds(&now, &start) - t);
+                n++;
+            }
+        }
+        if (n == 0) {
+            for (p = 0; p < numProducers; p++) {
+                if (!done[p] && epicsEventWaitWithTimeout(pp[p].done, 0.0) == epicsEventWaitOK) {
+                    done[p] = 1;
+                    numDone++;
+                }
+            }
+        }
+    }
+    epicsTimeGetCurrent(&stop);
+
+    printf("bench=mpsc regime=%s policy=%s elemSize=%lu depth=%lu producers=%u"
+        " puts=%lu gets=%lu lost=%lu putsPerSec=%.0f getsPerSec=%.0f",
+        full ? "full" : "drain", policyNames[policy], (unsigned long)elemSize,
+        (unsigned long)depth, numProducers, (unsigned long)numPuts,
+        (unsigned long)numGets, (unsigned long)seqQueueLost(q),
+        numPuts / epicsTimeDiffInSeconds(&stop, &start),
+        numGets / epicsTimeDiffInSeconds(&stop, &start));
+    printStats("put", putNs, numPuts);
+    printStats("age", ageNs, numGets);
+    printf("\n");
+
+    for (p = 0; p < numProducers; p++)
+        epicsEventDestroy(pp[p].done);
+    seqQueueDestroy(q);
+    free(ageNs);
+    free(putNs);
+    free(value);
+}
+
+MAIN(queueBench)
+{
+    size_t i, j, k;
+    enum seqQueuePolicy policy;
+
+    for (i = 0; i < mpscNumElemSizes; i++) {
+        for (j = 0; j < mpscNumDepths; j++) {
+            if (mpscElemSizes[i] * mpscDepths[j] > mpscMaxQueueBytes)
+                continue;
+            for (k = 0; k < mpscNumProducers; k++) {
+                mpscBench(mpscElemSizes[i], mpscDepths[j], mpscProducers[k],
+                    FALSE, QP_OVERWRITE_LAST);
+                for (policy = QP_OVERWRITE_LAST; policy <= QP_GROW; policy++)
+                    mpscBench(mpscElemSizes[i], mpscDepths[j], mpscProducers[k],
+                        TRUE, policy);
+            }
+        }
+    }
+    for (i = 0; i < numElemSizes; i++) {
+        spillBench(elemSizes[i], FALSE);
+        spillBench(elemSizes[i], TRUE);
+    }
+    return 0;
+}
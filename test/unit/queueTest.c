@@ -80,15 +80,291 @@ static void writerTask(void *arg)
     epicsEventSignal(wdone);
 }
 
+#define numProducers 4
+
+static const int mpscTestIterations = 200000;
+static const size_t mpscTestNumElems[] = {1, 2, 5, 16, 100};
+#define mpscTestNumSizes (sizeof(mpscTestNumElems)/sizeof(size_t))
+#define mpscTestBatch 8
+/* mpscTest modes */
+#define mpscZeroCopy 1
+#define mpscSpill 2
+
+typedef struct {
+    unsigned producer;
+    int seq;
+} MSG;
+
+struct producerArg {
+    QUEUE q;
+    unsigned id;
+    int zeroCopy;
+    int overwritten;
+    epicsEventId done;
+};
+
+static void producerTask(void *arg)
+{
+    struct producerArg *pa = (struct producerArg *)arg;
+    MSG m;
+    int i;
+
+    m.producer = pa->id;
+    for (i = 0; i < mpscTestIterations; i++) {
+        MSG *pm = pa->zeroCopy ? (MSG *)seqQueueReserve(pa->q, sizeof(MSG)) : 0;
+
+        m.seq = i;
+        if (pm) {
+            *pm = m;
+            seqQueueCommit(pa->q, pm, sizeof(MSG));
+        } else if (seqQueuePut(pa->q, &m)) {
+            pa->overwritten++;
+        }
+    }
+    epicsEventSignal(pa->done);
+}
+
+/* Several producers, one consumer: each producer's messages must
+   arrive in order, and every message lost must be accounted for
+   by exactly one put that reported overwriting. The consumer
+   removes either single elements or batches of them. In zero-copy
+   mode, producers and consumer access elements in place where
+   possible; in spill mode, the queue has a spill area. This only
+   finds ordering bugs that show up on the host it runs on; it has
+   been run on x86-64 only, which does not reorder loads, so it says
+   nothing about weakly ordered processors. */
+static void mpscTest(size_t numElems, size_t batch, int mode)
+{
+    int zeroCopy = mode & mpscZeroCopy;
+    MSG msgs[mpscTestBatch];
+    struct producerArg pa[numProducers];
+    int last[numProducers], received[numProducers];
+    int done[numProducers];
+    int numDone = 0, lost = 0, overwritten = 0, ordered = 1;
+    unsigned p;
+    QUEUE q;
+
+    testDiag("concurrent multi-producer queueTest with numElems=%u, batch=%u%s%s",
+        (unsigned)numElems, (unsigned)batch, zeroCopy ? ", zero-copy" : "",
+        (mode & mpscSpill) ? ", spill" : "");
+
+    q = seqQueueCreate(numElems, sizeof(MSG));
+    if (!q) {
+        testAbort("seqQueueCreate failed");
+    }
+    if ((mode & mpscSpill) && !seqQueueSpill(q, 64 * numElems * sizeof(MSG))) {
+        testAbort("seqQueueSpill failed");
+    }
+    for (p = 0; p < numProducers; p++) {
+        last[p] = -1;
+        received[p] = 0;
+        done[p] = 0;
+        pa[p].q = q;
+        pa[p].id = p;
+        pa[p].zeroCopy = zeroCopy;
+        pa[p].overwritten = 0;
+        pa[p].done = epicsEventCreate(epicsEventEmpty);
+        if (!pa[p].done) {
+            testAbort("epicsEventCreate failed");
+        }
+    }
+    for (p = 0; p < numProducers; p++) {
+        if (!epicsThreadCreate("producer", epicsThreadPriorityMedium,
+            epicsThreadGetStackSize(epicsThreadStackSmall), producerTask, pa + p)) {
+            testAbort("epicsThreadCreate failed");
+        }
+    }
+    while (numDone < numProducers || !seqQueueIsEmpty(q)) {
+        size_t i, n;
+
+        if (zeroCopy) {
+            MSG *pm = (MSG *)seqQueuePeek(q, 0);
+
+            n = 0;
+            if (pm) {
+                msgs[n++] = *pm;
+                seqQueueRelease(q, pm);
+            }
+        } else if (batch) {
+            n = seqQueueGetBatch(q, msgs, batch);
+        } else {
+            n = !seqQueueGet(q, msgs);
+        }
+        for (i = 0; i < n; i++) {
+            MSG *m = msgs + i;
+
+            if (m->producer >= numProducers) {
+                testAbort("bad producer id %u", m->producer);
+            }
+            if (m->seq <= last[m->producer]) {
+                ordered = 0;
+            }
+            last[m->producer] = m->seq;
+            received[m->producer]++;
+        }
+        if (n == 0) {
+            for (p = 0; p < numProducers; p++) {
+                if (!done[p] && epicsEventWaitWithTimeout(pa[p].done, 0.0) == epicsEventWaitOK) {
+                    done[p] = 1;
+                    numDone++;
+                }
+            }
+        }
+    }
+    for (p = 0; p < numProducers; p++) {
+        lost += mpscTestIterations - received[p];
+        overwritten += pa[p].overwritten;
+        epicsEventDestroy(pa[p].done);
+    }
+    testOk(ordered, "messages of each producer arrive in order");
+    testOk(lost == overwritten, "lost %d==%d overwritten", lost, overwritten);
+    testOk1(seqQueueInvariant(q));
+    seqQueueDestroy(q);
+}
+
+/* Elements of varying size: each starts with its id, followed by
+   a pattern of bytes; the size depends on the id */
+#define varTestMaxSize 40
+#define varTestNumElems 10
+#define varTestIterations 10000
+
+static size_t varSize(size_t id)
+{
+    return sizeof(size_t) + id % (varTestMaxSize - sizeof(size_t) + 1);
+}
+
+static void *varPut(void *dest, const void *src, size_t size)
+{
+    size_t id = *(const size_t *)src;
+    unsigned char *p = (unsigned char *)dest;
+    size_t i;
+
+    memcpy(p, &id, sizeof(size_t));
+    for (i = sizeof(size_t); i < size; i++)
+        p[i] = (unsigned char)(id + i);
+    return dest;
+}
+
+struct varArg {
+    size_t id;
+    int ok;
+};
+
+static void *varGet(void *dest, const void *src, size_t size)
+{
+    struct varArg *va = (struct varArg *)dest;
+    const unsigned char *p = (const unsigned char *)src;
+    size_t i;
+
+    memcpy(&va->id, p, sizeof(size_t));
+    va->ok = (size == varSize(va->id));
+    for (i = sizeof(size_t); i < size; i++) {
+        if (p[i] != (unsigned char)(va->id + i))
+            va->ok = 0;
+    }
+    return dest;
+}
+
+/* Puts of elements of varying size interleaved with gets: elements
+   must arrive intact and in order, and elements can only get lost
+   if a put reported overwriting. */
+static void varTest(size_t numBytes, enum seqQueuePolicy policy)
+{
+    QUEUE q;
+    size_t id, n, numGot = 0, lastId = 0;
+    int ok = 1, ordered = 1, overwritten = 0;
+    struct varArg va;
+
+    testDiag("variable size queueTest with numBytes=%u, policy=%d",
+        (unsigned)numBytes, policy);
+
+    q = seqQueueCreatePolicy(varTestNumElems, varTestMaxSize, numBytes, policy);
+    if (!q) {
+        testAbort("seqQueueCreateVar failed");
+    }
+    for (id = 1; id <= varTestIterations; id++) {
+        if (seqQueuePutN(q, varPut, &id, varSize(id)))
+            overwritten++;
+        /* remove a varying number of elements */
+        for (n = 0; n < id % 3 && !seqQueueGetF(q, varGet, &va); n++) {
+            if (!va.ok)
+                ok = 0;
+            if (va.id <= lastId)
+                ordered = 0;
+            lastId = va.id;
+            numGot++;
+        }
+        if (!seqQueueInvariant(q)) {
+            testAbort("invariant violated after %u puts", (unsigned)id);
+        }
+    }
+    while (!seqQueueGetF(q, varGet, &va)) {
+        if (!va.ok)
+            ok = 0;
+        if (va.id <= lastId)
+            ordered = 0;
+        lastId = va.id;
+        numGot++;
+    }
+    testOk(ok, "element contents and sizes");
+    testOk(ordered, "elements arrive in order");
+    testOk((numGot < varTestIterations) == (overwritten > 0),
+        "got %u elements, %d puts overwrote", (unsigned)numGot, overwritten);
+    testOk(numGot + seqQueueLost(q) == varTestIterations,
+        "%u elements lost", (unsigned)seqQueueLost(q));
+    testOk1(seqQueueIsEmpty(q) && seqQueueInvariant(q));
+    seqQueueDestroy(q);
+}
+
+#define policyTestNumElems 3
+#define policyTestNumPuts 5
+
+/* Fill a queue beyond its capacity and check which elements survive */
+static void policyTest(enum seqQueuePolicy policy, size_t numBytes)
+{
+    static const ELEM expected[][policyTestNumElems] = {
+        {0, 1, 4},  /* QP_OVERWRITE_LAST */
+        {2, 3, 4},  /* QP_DROP_OLDEST */
+        {0, 1, 2}   /* QP_DROP_NEWEST */
+    };
+    QUEUE q;
+    ELEM i, got;
+    int ok = 1;
+
+    testDiag("overflow policy %d with numBytes=%u", policy, (unsigned)numBytes);
+
+    q = seqQueueCreatePolicy(policyTestNumElems, sizeof(ELEM), numBytes, policy);
+    if (!q) {
+        testAbort("seqQueueCreatePolicy failed");
+    }
+    for (i = 0; i < policyTestNumPuts; i++) {
+        if (seqQueuePut(q, &i) != (i >= policyTestNumElems))
+            ok = 0;
+    }
+    testOk(ok, "puts report lost elements");
+    testOk(seqQueueLost(q) == policyTestNumPuts - policyTestNumElems,
+        "lost %u", (unsigned)seqQueueLost(q));
+    testOk(seqQueueHighWater(q) == policyTestNumElems,
+        "high water %u", (unsigned)seqQueueHighWater(q));
+    ok = 1;
+    for (i = 0; i < policyTestNumElems; i++) {
+        if (seqQueueGet(q, &got) || got != expected[policy][i])
+            ok = 0;
+    }
+    testOk(ok && seqQueueIsEmpty(q) && seqQueueInvariant(q),
+        "remaining elements");
+    seqQueueDestroy(q);
+}
+
 MAIN(queueTest)
 {
-    size_t numElems;
+    size_t numElems, nsize;
     QUEUE q;
     epicsThreadId reader, writer;
 
     errlogSetSevToLog(errlogFatal+1);
 
-    testPlan(212 + 2*threadTestMaxNumElems);
+    testPlan(349 + 2*threadTestMaxNumElems + 12*mpscTestNumSizes);
 
     testOk1(seqQueueCreate(1,0)==0);
     testOk1(seqQueueCreate(0,1)==0);
@@ -138,6 +414,390 @@ MAIN(queueTest)
         seqQueueDestroy(q);
     }
 
+    for (numElems = 1; numElems <= maxNumElems; numElems++) {
+        ELEM put[maxNumElems+1];
+        ELEM get[maxNumElems+1];
+        size_t i, j, n;
+
+        testDiag("batch queueTest with numElems=%u", (unsigned)numElems);
+
+        q = seqQueueCreate(numElems, sizeof(ELEM));
+        if (!q) {
+            testAbort("seqQueueCreate failed");
+        }
+        for (i = 0; i <= numElems; i++) {
+            int ok = 1;
+            for (j = 0; j < i; j++) {
+                put[j] = 10 * numElems + j;
+                seqQueuePut(q, put+j);
+            }
+            n = seqQueueGetBatch(q, get, numElems + 1);
+            testOk(n == i, "batch get %lu == %lu", (unsigned long)n, (unsigned long)i);
+            for (j = 0; j < n; j++) {
+                if (get[j] != put[j])
+                    ok = 0;
+            }
+            testOk(ok, "batch get values");
+        }
+        for (j = 0; j < numElems; j++) {
+            seqQueuePut(q, put+j);
+        }
+        n = seqQueueGetBatch(q, get, 1);
+        testOk(n == 1 && get[0] == put[0], "partial batch get");
+        check(q, 1);
+        seqQueueDestroy(q);
+    }
+
+    {
+        ELEM *p;
+        size_t size;
+        int ok = 1;
+
+        testDiag("zero-copy queueTest");
+
+        q = seqQueueCreate(maxNumElems, sizeof(ELEM));
+        if (!q) {
+            testAbort("seqQueueCreate failed");
+        }
+        p = (ELEM *)seqQueueReserve(q, sizeof(ELEM));
+        testOk(p != 0 && seqQueuePeek(q, 0) == 0, "reserved element not yet visible");
+        *p = 42;
+        seqQueueCommit(q, p, sizeof(ELEM));
+        check(q, maxNumElems - 1);
+        p = (ELEM *)seqQueuePeek(q, &size);
+        testOk(p != 0 && *p == 42 && size == sizeof(ELEM), "peek in place");
+        seqQueueRelease(q, p);
+        testOk1(seqQueuePeek(q, 0) == 0 && seqQueueIsEmpty(q));
+        for (size = 0; size < maxNumElems; size++) {
+            p = (ELEM *)seqQueueReserve(q, sizeof(ELEM));
+            if (!p) {
+                ok = 0;
+                break;
+            }
+            *p = size;
+            seqQueueCommit(q, p, sizeof(ELEM));
+        }
+        testOk(ok && seqQueueReserve(q, sizeof(ELEM)) == 0,
+            "reserve fails if full");
+        testOk1(seqQueueLost(q) == 0 && seqQueueHighWater(q) == maxNumElems);
+        seqQueueDestroy(q);
+
+        q = seqQueueCreatePolicy(maxNumElems, sizeof(ELEM), 0, QP_DROP_OLDEST);
+        if (!q) {
+            testAbort("seqQueueCreatePolicy failed");
+        }
+        for (size = 0; size <= maxNumElems; size++) {
+            p = (ELEM *)seqQueueReserve(q, sizeof(ELEM));
+            if (!p) {
+                testAbort("seqQueueReserve failed");
+            }
+            *p = size;
+            seqQueueCommit(q, p, sizeof(ELEM));
+        }
+        p = (ELEM *)seqQueuePeek(q, 0);
+        testOk(p != 0 && *p == 1 && seqQueueLost(q) == 1,
+            "reserve drops oldest element");
+        seqQueueRelease(q, p);
+        seqQueueDestroy(q);
+    }
+
+    {
+        ELEM i, got;
+        int ok = 1, ordered = 1;
+        size_t n = 0;
+        ELEM next = 0;
+
+        testDiag("spill queueTest");
+
+        q = seqQueueCreate(2, sizeof(ELEM));
+        if (!q || !seqQueueSpill(q, 1000)) {
+            testAbort("seqQueueSpill failed");
+        }
+        testOk1(!seqQueueSpill(q, 1000));
+        for (i = 0; i < 20; i++) {
+            if (seqQueuePut(q, &i))
+                ok = 0;
+        }
+        testOk(ok && seqQueueUsed(q) == 20 && seqQueueIsFull(q),
+            "puts go to the spill area");
+        testOk1(seqQueueUsed(seqQueueSpillArea(q)) == 18);
+        /* interleave puts and gets while elements are spilled */
+        for (i = 20; i < 40; i++) {
+            seqQueuePut(q, &i);
+            if (i % 2 == 0 && !seqQueueGet(q, &got)) {
+                if (got != next++)
+                    ordered = 0;
+                n++;
+            }
+        }
+        while (!seqQueueGet(q, &got)) {
+            if (got != next++)
+                ordered = 0;
+            n++;
+        }
+        testOk(ordered && n == 40, "got %u elements in order", (unsigned)n);
+        testOk1(seqQueueIsEmpty(q) && seqQueueLost(q) == 0 && seqQueueInvariant(q));
+        /* spill area has room for 1000/32 = 31 elements (on 64 bit systems) */
+        for (i = 0; i < 50; i++) {
+            seqQueuePut(q, &i);
+        }
+        testOk(seqQueueLost(q) == 50 - 2 - 1000 / (sizeof(ELEM) + seqQueueVarOverhead),
+            "lost %u when spill area is full", (unsigned)seqQueueLost(q));
+        seqQueueFlush(q);
+        testOk1(seqQueueIsEmpty(q));
+        seqQueueDestroy(q);
+
+        q = seqQueueCreateVar(2, sizeof(ELEM), 100);
+        if (!q || !seqQueueSpill(q, 1000)) {
+            testAbort("seqQueueSpill failed");
+        }
+        ok = 1;
+        for (i = 0; i < 10; i++) {
+            if (seqQueuePut(q, &i))
+                ok = 0;
+        }
+        for (i = 0; i < 10; i++) {
+            if (seqQueueGet(q, &got) || got != i)
+                ok = 0;
+        }
+        testOk(ok, "variable size queue with spill area");
+        ok = 1;
+        for (i = 0; i < 10; i++) {
+            seqQueuePut(q, &i);
+        }
+        for (i = 0; i < 10; i++) {
+            ELEM *p = (ELEM *)seqQueuePeek(q, 0);
+
+            if (!p || *p != i)
+                ok = 0;
+            if (p)
+                seqQueueRelease(q, p);
+        }
+        testOk(ok && seqQueueIsEmpty(q), "peek into spill area");
+        seqQueueDestroy(q);
+    }
+
+    {
+        static const char *kind[] = {"fixed size", "variable size", "spilling"};
+        ELEM i, first, got;
+        int k;
+
+        testDiag("first element queueTest");
+
+        for (k = 0; k < 3; k++) {
+            int ok = 1;
+
+            q = k == 1 ? seqQueueCreateVar(20, sizeof(ELEM), 1000)
+                : seqQueueCreate(k == 2 ? 4 : 20, sizeof(ELEM));
+            if (!q || (k == 2 && !seqQueueSpill(q, 1000))) {
+                testAbort("seqQueueCreate failed");
+            }
+            for (i = 0; i < 20; i++) {
+                seqQueuePut(q, &i);
+            }
+            for (i = 0; i < 20; i++) {
+                size_t used = seqQueueUsed(q);
+
+                if (seqQueueFirstF(q, memcpy, &first) || seqQueueUsed(q) != used
+                    || seqQueueGet(q, &got) || first != i || got != i)
+                    ok = 0;
+            }
+            testOk(ok && seqQueueFirstF(q, memcpy, &first),
+                "%s queue: first element stays in the queue", kind[k]);
+            seqQueueDestroy(q);
+        }
+    }
+
+    {
+        static const size_t numBytes[] = {64, 200, 1000};
+        struct varArg got[varTestNumElems];
+        size_t id, n;
+        int i;
+
+        testOk1(seqQueueCreateVar(1, varTestMaxSize, varTestMaxSize)==0);
+
+        testDiag("variable size queueTest, overwriting");
+
+        /* room for exactly three elements of maximum size */
+        q = seqQueueCreateVar(varTestNumElems, varTestMaxSize,
+            3 * (varTestMaxSize + seqQueueVarOverhead));
+        if (!q) {
+            testAbort("seqQueueCreateVar failed");
+        }
+        for (id = 1; id <= 4; id++) {
+            int full = seqQueuePutN(q, varPut, &id, varTestMaxSize);
+            testOk(full == (id == 4), "var q put %lu", (unsigned long)id);
+        }
+        n = 0;
+        while (n < varTestNumElems && !seqQueueGetF(q, varGet, got + n))
+            n++;
+        testOk(n == 3, "var q get %lu == 3 elements", (unsigned long)n);
+        testOk(n == 3 && got[0].id == 1 && got[1].id == 2 && got[2].id == 4,
+            "last element overwritten");
+
+        testDiag("variable size queueTest, zero-copy");
+
+        /* only room for three elements of maximum size, but
+           committing smaller ones leaves room for more */
+        for (id = 1; id <= 4; id++) {
+            void *p = seqQueueReserve(q, varTestMaxSize);
+
+            if (!p) {
+                break;
+            }
+            varPut(p, &id, varSize(id));
+            seqQueueCommit(q, p, varSize(id));
+        }
+        testOk(id == 5 && seqQueueLost(q) == 1, "reserved room shrinks to actual size");
+        for (n = 0; n < 4; n++) {
+            size_t size;
+            void *p = seqQueuePeek(q, &size);
+
+            if (!p) {
+                break;
+            }
+            varGet(got + n, p, size);
+            seqQueueRelease(q, p);
+        }
+        testOk(n == 4 && got[0].ok && got[1].ok && got[2].ok && got[3].ok
+            && got[0].id == 1 && got[3].id == 4, "elements stored with actual size");
+        testOk1(seqQueueIsEmpty(q) && seqQueueInvariant(q));
+        seqQueueDestroy(q);
+
+        for (i = 0; i < 3; i++) {
+            varTest(numBytes[i], QP_OVERWRITE_LAST);
+        }
+        varTest(200, QP_DROP_OLDEST);
+        varTest(varTestNumElems * varTestMaxSize, QP_GROW);
+    }
+
+    {
+        enum seqQueuePolicy policy;
+        ELEM i, got;
+        int ok = 1;
+
+        for (policy = QP_OVERWRITE_LAST; policy <= QP_DROP_NEWEST; policy++) {
+            policyTest(policy, 0);
+            policyTest(policy, 100);
+        }
+
+        testDiag("growing queueTest");
+
+        q = seqQueueCreatePolicy(100, sizeof(ELEM), 0, QP_GROW);
+        if (!q) {
+            testAbort("seqQueueCreatePolicy failed");
+        }
+        for (i = 0; i < 50; i++) {
+            if (seqQueuePut(q, &i))
+                ok = 0;
+        }
+        testOk(ok && seqQueueLost(q) == 0, "grow: no elements lost");
+        testOk(seqQueueNumBytes(q) > 4 * (sizeof(ELEM) + seqQueueVarOverhead)
+            && seqQueueNumBytes(q) <= seqQueueMaxBytes(q),
+            "grow: numBytes=%u", (unsigned)seqQueueNumBytes(q));
+        for (i = 0; i < 50; i++) {
+            if (seqQueueGet(q, &got) || got != i)
+                ok = 0;
+        }
+        testOk(ok, "grow: elements in order");
+        testOk1(seqQueueIsEmpty(q) && seqQueueInvariant(q));
+        seqQueueDestroy(q);
+
+        /* limited to ten elements */
+        q = seqQueueCreatePolicy(100, sizeof(ELEM),
+            10 * (sizeof(ELEM) + seqQueueVarOverhead), QP_GROW);
+        if (!q) {
+            testAbort("seqQueueCreatePolicy failed");
+        }
+        for (i = 0; i < 20; i++) {
+            seqQueuePut(q, &i);
+        }
+        testOk(seqQueueLost(q) == 10, "grow: lost %u beyond limit",
+            (unsigned)seqQueueLost(q));
+        testOk1(seqQueueNumBytes(q) == seqQueueMaxBytes(q));
+        ok = 1;
+        for (i = 0; i < 10; i++) {
+            if (seqQueueGet(q, &got) || got != (i < 9 ? i : 19))
+                ok = 0;
+        }
+        testOk(ok, "grow: last element overwritten at limit");
+
+        testOk(seqQueueReportLost(q, 1000.0) == 10, "first report");
+        for (i = 0; i <= 10; i++) {
+            seqQueuePut(q, &i);
+        }
+        testOk1(seqQueueReportLost(q, 1000.0) == 0);
+        testOk1(seqQueueReportLost(q, 0.0) == 1);
+        seqQueueDestroy(q);
+    }
+
+    {
+        static const char *kind[] = {"fixed size", "variable size", "spilling"};
+        ELEM i, got[2];
+        seqQueueStats stats;
+        int k;
+
+        for (k = 0; k < 3; k++) {
+            size_t n, young;
+            void *p;
+
+            testDiag("%s queue statistics queueTest", kind[k]);
+
+            q = k == 1 ? seqQueueCreateVar(10, sizeof(ELEM), 1000)
+                : seqQueueCreate(k == 2 ? 1 : 10, sizeof(ELEM));
+            if (!q || (k == 2 && !seqQueueSpill(q, 1000))) {
+                testAbort("seqQueueCreate failed");
+            }
+            seqQueueEnableStats(q);
+            for (i = 0; i < 4; i++) {
+                seqQueuePut(q, &i);
+            }
+            epicsThreadSleep(0.02);
+            seqQueueGetStats(q, &stats);
+            testOk(stats.used == 4 && stats.removed == 0 && stats.oldestAge >= 0.02,
+                "%s: oldestAge=%g", kind[k], stats.oldestAge);
+            seqQueueGet(q, got);
+            seqQueueGetBatch(q, got, 2);
+            p = seqQueuePeek(q, 0);
+            if (p)
+                seqQueueRelease(q, p);
+            seqQueueGetStats(q, &stats);
+            for (n = 0, young = 0; n < seqQueueNumAgeBuckets; n++) {
+                if (n < 5)
+                    young += stats.ageHist[n];
+            }
+            testOk(stats.removed == 4 && young == 0,
+                "%s: removed=%u, of these %u within 10ms", kind[k],
+                (unsigned)stats.removed, (unsigned)young);
+            testOk(stats.maxAge >= 0.02 && stats.oldestAge == 0,
+                "%s: maxAge=%g", kind[k], stats.maxAge);
+            for (i = 0; i < 4; i++) {
+                seqQueuePut(q, &i);
+            }
+            seqQueueFlush(q);
+            seqQueueGetStats(q, &stats);
+            testOk(stats.removed == 4 && stats.used == 0,
+                "%s: flushed elements are not counted", kind[k]);
+            seqQueueDestroy(q);
+        }
+
+        q = seqQueueCreate(10, sizeof(ELEM));
+        if (!q) {
+            testAbort("seqQueueCreate failed");
+        }
+        for (i = 0; i < 4; i++) {
+            seqQueuePut(q, &i);
+        }
+        epicsThreadSleep(0.02);
+        seqQueueGet(q, got);
+        seqQueueGetBatch(q, got, 2);
+        seqQueueGetStats(q, &stats);
+        testOk(!stats.timed && stats.removed == 0 && stats.maxAge == 0
+            && stats.oldestAge == 0 && stats.used == 1,
+            "without statistics, nothing is timed");
+        seqQueueDestroy(q);
+    }
+
     for (numElems = 1; numElems <= threadTestMaxNumElems; numElems++) {
 
         testDiag("concurrent queueTest with numElems=%u", (unsigned)numElems);
@@ -168,5 +828,12 @@ MAIN(queueTest)
     epicsEventDestroy(rdone);
     epicsEventDestroy(ready);
 
+    for (nsize = 0; nsize < mpscTestNumSizes; nsize++) {
+        mpscTest(mpscTestNumElems[nsize], 0, 0);
+        mpscTest(mpscTestNumElems[nsize], mpscTestBatch, 0);
+        mpscTest(mpscTestNumElems[nsize], 0, mpscZeroCopy);
+        mpscTest(mpscTestNumElems[nsize], mpscTestBatch, mpscSpill);
+    }
+
     return testDone();
 }